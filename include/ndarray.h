@@ -18,10 +18,12 @@
 
 #include "ndarray/Array.h"
 #include "ndarray/ArrayRef.h"
+#include "ndarray/DynamicArray.h"
 #include "ndarray/initialization.h"
 #ifndef GCC_45
 #include "ndarray/operators.h"
 #include "ndarray/arange.h"
+#include "ndarray/reductions.h"
 #endif
 #include "ndarray/casts.h"
 #include "ndarray/formatting.h"
@@ -17,17 +17,10 @@
 
 #pragma SWIG nowarn=467
 
-%define %declareNumPyConverters(TYPE...)
-%typemap(out) TYPE {
-    $result = ndarray::PyConverter< TYPE >::toPython($1);
-}
-%typemap(out) TYPE const &, TYPE &, TYPE const *, TYPE * {
-    $result = ndarray::PyConverter< TYPE >::toPython(*$1);
-}
+// Input typemaps shared by %declareNumPyConverters and %declareBufferConverters.
+%define %_declareInputConverters(TYPE...)
 %typemap(typecheck) TYPE, TYPE const *, TYPE const & {
-    ndarray::PyPtr tmp($input,true);
-    $1 = ndarray::PyConverter< TYPE >::fromPythonStage1(tmp);
-    if (!($1)) PyErr_Clear();
+    $1 = ndarray::PyConverter< TYPE >::matches($input);
 }
 %typemap(in) TYPE const & (TYPE val) {
     ndarray::PyPtr tmp($input,true);
@@ -41,3 +34,40 @@
     if (!ndarray::PyConverter< TYPE >::fromPythonStage2(tmp, $1)) return NULL;
 }
 %enddef
+
+%define %declareNumPyConverters(TYPE...)
+%typemap(out) TYPE {
+    $result = ndarray::PyConverter< TYPE >::toPython($1);
+}
+%typemap(out) TYPE const &, TYPE &, TYPE const *, TYPE * {
+    $result = ndarray::PyConverter< TYPE >::toPython(*$1);
+}
+%_declareInputConverters(TYPE)
+%enddef
+
+// Wrap a const member function CLASS::METHOD() that returns a reference to memory owned by
+// the object (a TYPE declared with %declareNumPyConverters) so the result shares that memory
+// instead of copying it; the numpy array is read-only and keeps the Python object alive.
+// Must appear before the class is declared, and requires proxy classes (not -builtin).
+%define %declareSharedNumPyGetter(CLASS, METHOD, TYPE...)
+%ignore CLASS::METHOD;
+%extend CLASS {
+    PyObject * _shared_ ## METHOD(PyObject * owner) const {
+        return ndarray::PyConverter< TYPE >::toPython($self->METHOD(), owner);
+    }
+%pythoncode %{
+def METHOD(self):
+    return self._shared_ ## METHOD(self)
+%}
+}
+%enddef
+
+%define %declareBufferConverters(TYPE...)
+%typemap(out) TYPE {
+    $result = ndarray::PyConverter< TYPE >::toPyBuffer($1);
+}
+%typemap(out) TYPE const &, TYPE &, TYPE const *, TYPE * {
+    $result = ndarray::PyConverter< TYPE >::toPyBuffer(*$1);
+}
+%_declareInputConverters(TYPE)
+%enddef
@@ -88,6 +88,14 @@ public:
      */
     explicit Array(int n1, int n2=1, int n3=1, int n4=1, int n5=1, int n6=1, int n7=1, int n8=1);
 
+    /**
+     *  @brief Construct an array with the given shape and allocated but uninitialized memory,
+     *         obtained according to the given AllocationPolicy.
+     *
+     *  This is implemented in initialization.h.
+     */
+    Array(Vector<int,N> const & shape, AllocationPolicy const & policy);
+
     /**
      *  @brief Non-converting shallow assignment.
      */
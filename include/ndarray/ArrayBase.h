@@ -88,7 +88,8 @@ public:
         return Traits::makeIterator(
             this->_data,
             this->_core,
-            this->template getStride<0>()
+            this->template getStride<0>(),
+            0
         );
     }
 
@@ -97,7 +98,8 @@ public:
         return Traits::makeIterator(
             this->_data + this->template getSize<0>() * this->template getStride<0>(), 
             this->_core,
-            this->template getStride<0>()
+            this->template getStride<0>(),
+            this->template getSize<0>()
         );
     }
 
@@ -18,7 +18,11 @@ define(`GENERAL_ASSIGN',
     operator $1(ExpressionBase<Other> const & expr) const {
         NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        indir(`$3',$1)
+        if (!detail::flatEvaluate(*this, static_cast<Other const &>(expr), detail::$4())
+            && !detail::transposeEvaluate(*this, static_cast<Other const &>(expr), detail::$4())
+            && !detail::plannedEvaluate(*this, static_cast<Other const &>(expr), detail::$4())) {
+            indir(`$3',$1)
+        }
         return *this;
     }
 
@@ -30,9 +34,18 @@ define(`GENERAL_ASSIGN',
     ArrayRef const &
 #endif
     operator $1(Scalar const & scalar) const {
-        indir(`$2',$1)
+        if (!detail::flatFill(*this, scalar, detail::$4())) {
+            indir(`$2',$1)
+        }
         return *this;
     }')dnl
+define(`ASSIGN_FUNCTOR',
+`
+/// @internal @brief Function object for $2 assignment, used by flat evaluation.
+struct $1 {
+    template <typename A, typename B>
+    void operator()(A & a, B const & b) const { a $2 b; }
+};')dnl
 define(`BASIC_ASSIGN_SCALAR',`Super::Traits::fill(this->begin(),this->end(),scalar);')dnl
 define(`BASIC_ASSIGN_EXPR',`std::copy(expr.begin(),expr.end(),this->begin());')dnl
 define(`AUGMENTED_ASSIGN_SCALAR',
@@ -42,8 +55,18 @@ define(`AUGMENTED_ASSIGN_EXPR',
 `Iterator const i_end = this->end();
         typename Other::Iterator j = expr.begin();
         for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) $1 (*j);')dnl
-define(`BASIC_ASSIGN',`GENERAL_ASSIGN(`=',`BASIC_ASSIGN_SCALAR',`BASIC_ASSIGN_EXPR')')dnl
-define(`AUGMENTED_ASSIGN',`GENERAL_ASSIGN($1,`AUGMENTED_ASSIGN_SCALAR',`AUGMENTED_ASSIGN_EXPR')')dnl
+define(`PACKET_ASSIGN',
+`
+template <typename T>
+struct PacketAssign<$1,T> {
+    typedef typename Packet<T>::IsVectorized IsVectorized;
+
+    static void apply(T * p, typename Packet<T>::Type v) {
+        Packet<T>::store(p, $2);
+    }
+};')dnl
+define(`BASIC_ASSIGN',`GENERAL_ASSIGN(`=',`BASIC_ASSIGN_SCALAR',`BASIC_ASSIGN_EXPR',`Assign')')dnl
+define(`AUGMENTED_ASSIGN',`GENERAL_ASSIGN($1,`AUGMENTED_ASSIGN_SCALAR',`AUGMENTED_ASSIGN_EXPR',$2)')dnl
 #ifndef NDARRAY_ArrayRef_h_INCLUDED
 #define NDARRAY_ArrayRef_h_INCLUDED
 
@@ -60,8 +83,29 @@ define(`AUGMENTED_ASSIGN',`GENERAL_ASSIGN($1,`AUGMENTED_ASSIGN_SCALAR',`AUGMENTE
 #include "ndarray/Vector.h"
 #include "ndarray/detail/Core.h"
 #include "ndarray/views.h"
+#include "ndarray/detail/Evaluation.h"
 
 namespace ndarray {
+namespace detail {
+ASSIGN_FUNCTOR(Assign,=)
+ASSIGN_FUNCTOR(PlusAssign,+=)
+ASSIGN_FUNCTOR(MinusAssign,-=)
+ASSIGN_FUNCTOR(MultipliesAssign,*=)
+ASSIGN_FUNCTOR(DividesAssign,/=)
+ASSIGN_FUNCTOR(ModulusAssign,%=)
+ASSIGN_FUNCTOR(BitwiseXorAssign,^=)
+ASSIGN_FUNCTOR(BitwiseAndAssign,&=)
+ASSIGN_FUNCTOR(BitwiseOrAssign,|=)
+ASSIGN_FUNCTOR(BitwiseLeftShiftAssign,<<=)
+ASSIGN_FUNCTOR(BitwiseRightShiftAssign,>>=)
+
+PACKET_ASSIGN(Assign,`v')
+PACKET_ASSIGN(PlusAssign,`Packet<T>::add(Packet<T>::load(p), v)')
+PACKET_ASSIGN(MinusAssign,`Packet<T>::sub(Packet<T>::load(p), v)')
+PACKET_ASSIGN(MultipliesAssign,`Packet<T>::mul(Packet<T>::load(p), v)')
+PACKET_ASSIGN(DividesAssign,`Packet<T>::div(Packet<T>::load(p), v)')
+
+} // namespace detail
 
 /**
  *  @brief A proxy class for Array with deep assignment operators.
@@ -128,27 +172,35 @@ public:
     /// @{
     ArrayRef const & operator=(Array<T,N,C> const & other) const {
         NDARRAY_ASSERT(other.getShape() == this->getShape());
-        std::copy(other.begin(), other.end(), this->begin());
+        if (!detail::flatEvaluate(*this, other, detail::Assign())
+            && !detail::transposeEvaluate(*this, other, detail::Assign())
+            && !detail::plannedEvaluate(*this, other, detail::Assign())) {
+            std::copy(other.begin(), other.end(), this->begin());
+        }
         return *this;
     }
 
     ArrayRef const & operator=(ArrayRef const & other) const {
         NDARRAY_ASSERT(other.getShape() == this->getShape());
-        std::copy(other.begin(), other.end(), this->begin());
+        if (!detail::flatEvaluate(*this, other, detail::Assign())
+            && !detail::transposeEvaluate(*this, other, detail::Assign())
+            && !detail::plannedEvaluate(*this, other, detail::Assign())) {
+            std::copy(other.begin(), other.end(), this->begin());
+        }
         return *this;
     }
 
 BASIC_ASSIGN
-AUGMENTED_ASSIGN(+=)
-AUGMENTED_ASSIGN(-=)
-AUGMENTED_ASSIGN(*=)
-AUGMENTED_ASSIGN(/=)
-AUGMENTED_ASSIGN(%=)
-AUGMENTED_ASSIGN(^=)
-AUGMENTED_ASSIGN(&=)
-AUGMENTED_ASSIGN(|=)
-AUGMENTED_ASSIGN(<<=)
-AUGMENTED_ASSIGN(>>=)
+AUGMENTED_ASSIGN(+=,PlusAssign)
+AUGMENTED_ASSIGN(-=,MinusAssign)
+AUGMENTED_ASSIGN(*=,MultipliesAssign)
+AUGMENTED_ASSIGN(/=,DividesAssign)
+AUGMENTED_ASSIGN(%=,ModulusAssign)
+AUGMENTED_ASSIGN(^=,BitwiseXorAssign)
+AUGMENTED_ASSIGN(&=,BitwiseAndAssign)
+AUGMENTED_ASSIGN(|=,BitwiseOrAssign)
+AUGMENTED_ASSIGN(<<=,BitwiseLeftShiftAssign)
+AUGMENTED_ASSIGN(>>=,BitwiseRightShiftAssign)
     ///@}
 
 private:
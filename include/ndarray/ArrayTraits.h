@@ -54,8 +54,8 @@ struct ArrayTraits {
     static Reference makeReference(Element * data, CorePtr const & core) {
         return Reference(data, core);
     }
-    static Iterator makeIterator(Element * data, CorePtr const & core, int stride) {
-        return Iterator(Reference(data, core), stride);
+    static Iterator makeIterator(Element * data, CorePtr const & core, int stride, int index) {
+        return Iterator(Reference(data, core), stride, index);
     }
     static void fill(Iterator iter, Iterator const & end, Element value) {
         // We can't use std::fill here because NestedIterator is not formally an STL ForwardIterator;
@@ -83,8 +83,8 @@ struct ArrayTraits<T,1,0> {
     static Reference makeReference(Element * data, CorePtr const & core) {
         return *data;
     }
-    static Iterator makeIterator(Element * data, CorePtr const & core, int stride) {
-        return Iterator(data, stride);
+    static Iterator makeIterator(Element * data, CorePtr const & core, int stride, int index) {
+        return Iterator(data, stride, index);
     }
     static void fill(Iterator iter, Iterator const & end, Element value) {
         std::fill(iter, end, value);
@@ -105,7 +105,7 @@ struct ArrayTraits<T,1,1> {
     static Reference makeReference(Element * data, CorePtr const & core) {
         return *data;
     }
-    static Iterator makeIterator(Element * data, CorePtr const & core, int stride) {
+    static Iterator makeIterator(Element * data, CorePtr const & core, int stride, int index) {
         return data;
     }
     static void fill(Iterator iter, Iterator const & end, Element value) {
@@ -127,7 +127,7 @@ struct ArrayTraits<T,1,-1> {
     static Reference makeReference(Element * data, CorePtr const & core) {
         return *data;
     }
-    static Iterator makeIterator(Element * data, CorePtr const & core, int stride) {
+    static Iterator makeIterator(Element * data, CorePtr const & core, int stride, int index) {
         return data;
     }
     static void fill(Iterator iter, Iterator const & end, Element value) {
@@ -0,0 +1,360 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DynamicArray_h_INCLUDED
+#define NDARRAY_DynamicArray_h_INCLUDED
+
+/**
+ *  @file ndarray/DynamicArray.h
+ *
+ *  @brief Definitions for DynamicArray, an array whose number of dimensions is a runtime value.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include "ndarray_fwd.h"
+#include "ndarray/Array.h"
+#include "ndarray/Manager.h"
+
+namespace ndarray {
+namespace detail {
+
+/// @internal @brief The largest number of dimensions supported by DynamicArray.
+enum { MAX_DYNAMIC_DIMENSIONS = 32 };
+
+/**
+ *  @internal @brief Return true if a layout's dimensions are contiguous in the order required
+ *         by the row-major-contiguous parameter c.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Strides of dimensions with unit size are ignored.
+ */
+inline bool hasRMC(int c, int nDim, int const * shape, int const * strides) {
+    int expected = 1;
+    if (c > 0) {
+        for (int n = nDim - 1; n >= nDim - c; --n) {
+            if (shape[n] != 1 && strides[n] != expected) return false;
+            expected *= shape[n];
+        }
+    } else {
+        for (int n = 0; n < -c; ++n) {
+            if (shape[n] != 1 && strides[n] != expected) return false;
+            expected *= shape[n];
+        }
+    }
+    return true;
+}
+
+/// @internal @brief Copy one strided row of elements.
+template <typename T, typename U>
+inline void copyRow(T * out, int outStride, U const * in, int inStride, int n) {
+    if (outStride == 1 && inStride == 1) {
+        std::copy(in, in + n, out);
+    } else {
+        for (int i = 0; i < n; ++i, out += outStride, in += inStride) *out = *in;
+    }
+}
+
+/**
+ *  @internal @brief Copy elements between two strided layouts with any number of dimensions.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Dimensions with unit size are dropped, the rest are ordered by decreasing output stride,
+ *  and neighboring dimensions that are contiguous relative to each other in both layouts are
+ *  merged; most copies then reduce to a few long rows.  This is compiled once per pair of
+ *  element types rather than once per number of dimensions.
+ */
+template <typename T, typename U>
+void stridedCopy(int nDim, int const * shape,
+                 T * out, int const * outStrides, U const * in, int const * inStrides) {
+    NDARRAY_ASSERT(nDim <= MAX_DYNAMIC_DIMENSIONS);
+    int size[MAX_DYNAMIC_DIMENSIONS];
+    int outStride[MAX_DYNAMIC_DIMENSIONS];
+    int inStride[MAX_DYNAMIC_DIMENSIONS];
+    int m = 0;
+    for (int n = 0; n < nDim; ++n) {
+        if (shape[n] == 0) return;
+        if (shape[n] == 1) continue;
+        // insertion sort by decreasing output stride
+        int k = m++;
+        for (; k > 0 && std::abs(outStride[k-1]) < std::abs(outStrides[n]); --k) {
+            size[k] = size[k-1];
+            outStride[k] = outStride[k-1];
+            inStride[k] = inStride[k-1];
+        }
+        size[k] = shape[n];
+        outStride[k] = outStrides[n];
+        inStride[k] = inStrides[n];
+    }
+    if (m == 0) {
+        *out = *in;
+        return;
+    }
+    int r = 0;
+    for (int k = 1; k < m; ++k) {
+        if (outStride[r] == outStride[k] * size[k] && inStride[r] == inStride[k] * size[k]) {
+            size[r] *= size[k];
+            outStride[r] = outStride[k];
+            inStride[r] = inStride[k];
+        } else {
+            ++r;
+            size[r] = size[k];
+            outStride[r] = outStride[k];
+            inStride[r] = inStride[k];
+        }
+    }
+    int const inner = r;
+    int index[MAX_DYNAMIC_DIMENSIONS] = { 0 };
+    while (true) {
+        copyRow(out, outStride[inner], in, inStride[inner], size[inner]);
+        int k = inner - 1;
+        for (; k >= 0; --k) {
+            out += outStride[k];
+            in += inStride[k];
+            if (++index[k] < size[k]) break;
+            out -= outStride[k] * size[k];
+            in -= inStride[k] * size[k];
+            index[k] = 0;
+        }
+        if (k < 0) return;
+    }
+}
+
+} // namespace detail
+
+/**
+ *  @brief A strided array whose number of dimensions is set at runtime.
+ *
+ *  @ingroup MainGroup
+ *
+ *  DynamicArray holds the same data pointer and Manager as an Array, with its shape and
+ *  strides in a small inline buffer (or on the heap, for arrays with many dimensions).  It
+ *  is intended for code that moves data without caring about its rank, such as I/O and
+ *  language bindings, so that code is compiled once instead of once per Array type.
+ *  Conversions from any Array are implicit; conversions back are checked at runtime.
+ *
+ *  Like Array, copying a DynamicArray is shallow; elements are modified only by assign().
+ */
+template <typename T>
+class DynamicArray {
+public:
+
+    typedef T Element;
+
+    /// @brief Construct an empty array with no dimensions.
+    DynamicArray() : _data(0), _manager(), _nDim(0), _dims(_buffer) {}
+
+    /// @brief Construct from a data pointer, shape, strides (in elements) and manager.
+    DynamicArray(
+        T * data, std::vector<int> const & shape, std::vector<int> const & strides,
+        Manager::Ptr const & manager = Manager::Ptr()
+    ) : _data(data), _manager(manager), _nDim(0), _dims(_buffer) {
+        NDARRAY_ASSERT(shape.size() == strides.size());
+        _resize(shape.size());
+        std::copy(shape.begin(), shape.end(), _dims);
+        std::copy(strides.begin(), strides.end(), _dims + _nDim);
+    }
+
+    /// @brief Shallow copy constructor.
+    DynamicArray(DynamicArray const & other) :
+        _data(other._data), _manager(other._manager), _nDim(0), _dims(_buffer)
+    {
+        _copyDims(other);
+    }
+
+    /// @brief Converting shallow copy constructor (e.g. from non-const to const elements).
+    template <typename U>
+    DynamicArray(
+        DynamicArray<U> const & other
+#ifndef DOXYGEN
+        , typename boost::enable_if<boost::is_convertible<U*,T*>,void*>::type=0
+#endif
+    ) : _data(other._data), _manager(other._manager), _nDim(0), _dims(_buffer) {
+        _copyDims(other);
+    }
+
+    /// @brief Construct a view of an Array or ArrayRef with any number of dimensions.
+    template <typename Derived>
+    DynamicArray(
+        ArrayBase<Derived> const & array
+#ifndef DOXYGEN
+        , typename boost::enable_if<
+            boost::is_convertible<typename ExpressionTraits<Derived>::Element*,T*>,void*
+        >::type=0
+#endif
+    ) : _data(array.getData()), _manager(array.getManager()), _nDim(0), _dims(_buffer) {
+        int const N = ExpressionTraits<Derived>::ND::value;
+        _resize(N);
+        Vector<int,N> const shape = array.getShape();
+        Vector<int,N> const strides = array.getStrides();
+        for (int n = 0; n < N; ++n) {
+            _dims[n] = shape[n];
+            _dims[N + n] = strides[n];
+        }
+    }
+
+    ~DynamicArray() { if (_dims != _buffer) delete [] _dims; }
+
+    /// @brief Shallow assignment.
+    DynamicArray & operator=(DynamicArray const & other) {
+        if (&other != this) {
+            _data = other._data;
+            _manager = other._manager;
+            _copyDims(other);
+        }
+        return *this;
+    }
+
+    /// @brief Return the number of dimensions.
+    int getNumDimensions() const { return _nDim; }
+
+    /// @brief Return the size of dimension n.
+    int getSize(int n) const { return _dims[n]; }
+
+    /// @brief Return the stride of dimension n, in elements.
+    int getStride(int n) const { return _dims[_nDim + n]; }
+
+    /// @brief Return the sizes of all dimensions.
+    std::vector<int> getShape() const { return std::vector<int>(_dims, _dims + _nDim); }
+
+    /// @brief Return the strides of all dimensions, in elements.
+    std::vector<int> getStrides() const { return std::vector<int>(_dims + _nDim, _dims + 2 * _nDim); }
+
+    /// @brief Return the total number of elements.
+    int getNumElements() const {
+        int r = 1;
+        for (int n = 0; n < _nDim; ++n) r *= _dims[n];
+        return r;
+    }
+
+    /// @brief Return a raw pointer to the first element.
+    T * getData() const { return _data; }
+
+    /// @brief Return the opaque object responsible for memory management.
+    Manager::Ptr getManager() const { return _manager; }
+
+    /// @brief Return true if the array has a null data pointer.
+    bool isEmpty() const { return _data == 0; }
+
+    /// @brief Return true if the array can be viewed as an Array<T,N,C>.
+    template <int N, int C>
+    bool isConvertible() const {
+        return _nDim == N && detail::hasRMC(C, N, _dims, _dims + N);
+    }
+
+    /**
+     *  @brief Return an Array<T,N,C> view of the same data.
+     *
+     *  @throw std::runtime_error if the number of dimensions differs from N or the strides
+     *         do not satisfy the contiguity guaranteed by C.
+     */
+    template <int N, int C>
+    Array<T,N,C> toArray() const {
+        typedef detail::ArrayAccess< Array<T,N,C> > Access;
+        if (_nDim != N) {
+            throw std::runtime_error("DynamicArray has the wrong number of dimensions for conversion");
+        }
+        if (!detail::hasRMC(C, N, _dims, _dims + N)) {
+            throw std::runtime_error("DynamicArray strides are incompatible with the target contiguity");
+        }
+        Vector<int,N> shape;
+        Vector<int,N> strides;
+        for (int n = 0; n < N; ++n) {
+            shape[n] = _dims[n];
+            strides[n] = _dims[N + n];
+        }
+        return Access::construct(_data, Access::Core::create(shape, strides, _manager));
+    }
+
+    /**
+     *  @brief Copy the elements of another array with the same shape into this one.
+     *
+     *  Elements are converted with an implicit conversion from U to T.
+     */
+    template <typename U>
+    void assign(DynamicArray<U> const & other) const {
+        NDARRAY_ASSERT(other.getShape() == getShape());
+        detail::stridedCopy(_nDim, _dims, _data, _dims + _nDim, other._data, other._dims + _nDim);
+    }
+
+private:
+
+    template <typename U> friend class DynamicArray;
+
+    enum { INLINE_DIMENSIONS = 4 };
+
+    void _resize(int nDim) {
+        NDARRAY_ASSERT(nDim >= 0 && nDim <= detail::MAX_DYNAMIC_DIMENSIONS);
+        if (nDim > INLINE_DIMENSIONS && nDim > _nDim) {
+            if (_dims != _buffer) delete [] _dims;
+            _dims = new int[2 * nDim];
+        }
+        _nDim = nDim;
+    }
+
+    template <typename U>
+    void _copyDims(DynamicArray<U> const & other) {
+        _resize(other._nDim);
+        std::copy(other._dims, other._dims + 2 * other._nDim, _dims);
+    }
+
+    T * _data;
+    Manager::Ptr _manager;
+    int _nDim;
+    int * _dims;
+    int _buffer[2 * INLINE_DIMENSIONS];
+};
+
+/// @addtogroup MainGroup
+/// @{
+
+/**
+ *  @brief Allocate a new contiguous DynamicArray with the given shape.
+ *
+ *  Elements are default-constructed (and hence not initialized for arithmetic types).
+ */
+template <typename T>
+DynamicArray<T> allocateDynamic(std::vector<int> const & shape, DataOrderEnum order=ROW_MAJOR) {
+    int const nDim = shape.size();
+    std::vector<int> strides(nDim, 1);
+    if (order == ROW_MAJOR) {
+        for (int n = nDim - 1; n > 0; --n) strides[n-1] = strides[n] * shape[n];
+    } else {
+        for (int n = 1; n < nDim; ++n) strides[n] = strides[n-1] * shape[n-1];
+    }
+    int size = 1;
+    for (int n = 0; n < nDim; ++n) size *= shape[n];
+    std::pair<Manager::Ptr,T*> p = SimpleManager<T>::allocate(size);
+    return DynamicArray<T>(p.second, shape, strides, p.first);
+}
+
+/// @brief Create a deep, row-major contiguous copy of a DynamicArray.
+template <typename T>
+DynamicArray<typename boost::remove_const<T>::type> copy(DynamicArray<T> const & array) {
+    DynamicArray<typename boost::remove_const<T>::type> r =
+        allocateDynamic<typename boost::remove_const<T>::type>(array.getShape());
+    r.assign(array);
+    return r;
+}
+
+/// @}
+
+} // namespace ndarray
+
+#endif // !NDARRAY_DynamicArray_h_INCLUDED
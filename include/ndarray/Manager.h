@@ -22,6 +22,28 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/atomic.hpp>
 #include <boost/scoped_array.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NDARRAY_HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 namespace ndarray {
 
@@ -34,6 +56,15 @@ public:
 
     virtual bool isUnique() const { return false; }
 
+    /**
+     *  @brief Return the alignment in bytes guaranteed for the start of the managed data,
+     *         or zero if it is not known.
+     *
+     *  Views into the data are not necessarily aligned; kernels should check the data
+     *  pointer of the array they operate on as well.
+     */
+    virtual int getAlignment() const { return 0; }
+
 protected:
 
     virtual ~Manager() {}
@@ -69,6 +100,8 @@ public:
 
     virtual bool isUnique() const { return true; }
 
+    virtual int getAlignment() const { return boost::alignment_of<U>::value; }
+
 private:
     explicit SimpleManager(int size) : _p() {
         if (size > 0) _p.reset(new U[size]);
@@ -76,6 +109,235 @@ private:
     boost::scoped_array<U> _p;
 };
 
+/**
+ *  @brief Options for how ndarray::allocate obtains memory.
+ *
+ *  @ingroup MainGroup
+ */
+class AllocationPolicy {
+public:
+
+    /**
+     *  @brief Construct a policy.
+     *
+     *  @param[in] alignment  Alignment in bytes of the first element; must be a power of two.
+     *  @param[in] padRows    If true, pad the stride of the second-fastest dimension so each
+     *                        row starts on an alignment boundary.  This is only done when the
+     *                        target array type does not guarantee that rows are contiguous
+     *                        with each other (that is, when its RMC is 0, 1, or -1).
+     *  @param[in] hugePages  If true, ask the operating system to back large allocations with
+     *                        transparent huge pages (where supported); such allocations are
+     *                        also aligned to the huge page size.
+     */
+    explicit AllocationPolicy(int alignment=64, bool padRows=false, bool hugePages=false) :
+        _alignment(alignment), _padRows(padRows), _hugePages(hugePages) {}
+
+    int getAlignment() const { return _alignment; }
+
+    bool getPadRows() const { return _padRows; }
+
+    bool getHugePages() const { return _hugePages; }
+
+private:
+    int _alignment;
+    bool _padRows;
+    bool _hugePages;
+};
+
+namespace detail {
+
+/// @internal @brief Allocate raw memory with the given power-of-two alignment; throws std::bad_alloc.
+inline void * alignedAllocate(std::size_t bytes, std::size_t alignment) {
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    if (bytes == 0) bytes = 1;
+#ifdef _WIN32
+    void * p = _aligned_malloc(bytes, alignment);
+    if (!p) throw std::bad_alloc();
+#else
+    void * p = 0;
+    if (posix_memalign(&p, alignment, bytes) != 0) throw std::bad_alloc();
+#endif
+    return p;
+}
+
+/// @internal @brief Free memory returned by alignedAllocate.
+inline void alignedFree(void * p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // namespace detail
+
+/**
+ *  @brief A Manager for memory allocated with a specific alignment.
+ *
+ *  Elements are default-constructed on allocation and destroyed with the manager.
+ */
+template <typename T>
+class AlignedManager : public Manager {
+    typedef typename boost::remove_const<T>::type U;
+public:
+
+    /// @brief Size in bytes above which huge-page allocations are aligned to the huge page size.
+    static std::size_t const HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    static std::pair<Manager::Ptr,T*> allocate(int size, AllocationPolicy const & policy) {
+        boost::intrusive_ptr<AlignedManager> r(new AlignedManager(size, policy));
+        return std::pair<Manager::Ptr,T*>(r, r->_p);
+    }
+
+    virtual bool isUnique() const { return true; }
+
+    virtual int getAlignment() const { return _alignment; }
+
+    virtual ~AlignedManager() {
+        destroy(_size);
+        detail::alignedFree(_p);
+    }
+
+private:
+
+    AlignedManager(int size, AllocationPolicy const & policy) :
+        _p(0), _size(0), _alignment(std::max(policy.getAlignment(), int(boost::alignment_of<U>::value)))
+    {
+        std::size_t bytes = std::size_t(size) * sizeof(U);
+        bool huge = policy.getHugePages() && bytes >= HUGE_PAGE_SIZE;
+        if (huge) _alignment = std::max(_alignment, int(HUGE_PAGE_SIZE));
+        _p = static_cast<U*>(detail::alignedAllocate(bytes, _alignment));
+#ifdef MADV_HUGEPAGE
+        if (huge) ::madvise(_p, bytes, MADV_HUGEPAGE);
+#endif
+        try {
+            for (; _size < size; ++_size) new (_p + _size) U;
+        } catch (...) {
+            destroy(_size);
+            detail::alignedFree(_p);
+            throw;
+        }
+    }
+
+    void destroy(int n) {
+        for (int i = 0; i < n; ++i) _p[i].~U();
+    }
+
+    U * _p;
+    int _size;
+    int _alignment;
+};
+
+#ifdef NDARRAY_HAVE_MMAP
+
+/// @brief How a file is mapped into memory by MappedManager.
+enum MapModeEnum {
+    MAPPED_READ_ONLY,       ///< Pages are read-only; writing through the array is undefined behavior.
+    MAPPED_COPY_ON_WRITE,   ///< Pages are writeable, but changes are private and never reach the file.
+    MAPPED_READ_WRITE       ///< Changes are written back to the file, which is grown if necessary.
+};
+
+/**
+ *  @brief A Manager that owns a memory-mapped region of a file.
+ *
+ *  The file is closed as soon as it is mapped; the mapping is released when the last
+ *  array referencing it is destroyed.  Only available on POSIX systems (when
+ *  NDARRAY_HAVE_MMAP is defined).
+ */
+class MappedManager : public Manager {
+public:
+
+    /**
+     *  @brief Map a region of a file, returning the manager and a pointer to the first byte.
+     *
+     *  @param[in] path    File to map.  In MAPPED_READ_WRITE mode it is created if it does
+     *                     not exist and extended if it is shorter than offset + bytes; in
+     *                     other modes it must already be at least that long.
+     *  @param[in] offset  Offset in bytes of the region from the start of the file.  It need
+     *                     not be a multiple of the page size.
+     *  @param[in] bytes   Size of the region in bytes.
+     *  @param[in] mode    Access mode for the mapping.
+     *
+     *  @throw std::runtime_error if the file cannot be opened, resized, or mapped.
+     */
+    static std::pair<Manager::Ptr,void*> map(
+        std::string const & path, std::size_t offset, std::size_t bytes, MapModeEnum mode
+    ) {
+        boost::intrusive_ptr<MappedManager> r(new MappedManager(path, offset, bytes, mode));
+        return std::pair<Manager::Ptr,void*>(r, r->_data);
+    }
+
+    /// @brief Return the mode the file was mapped with.
+    MapModeEnum getMode() const { return _mode; }
+
+    /// @brief Write any changes to the file and wait for completion (MAPPED_READ_WRITE only).
+    void sync() const {
+        if (_mode == MAPPED_READ_WRITE && _length > 0 && ::msync(_base, _length, MS_SYNC) != 0) {
+            fail("Failed to sync", _path);
+        }
+    }
+
+    virtual int getAlignment() const {
+        // the mapping starts on a page boundary; the data start is as aligned as its offset in it
+        std::size_t delta = static_cast<char*>(_data) - static_cast<char*>(_base);
+        if (delta == 0) return int(::sysconf(_SC_PAGESIZE));
+        return int(delta & (~delta + 1));
+    }
+
+    virtual ~MappedManager() {
+        if (_length > 0) ::munmap(_base, _length);
+    }
+
+private:
+
+    static void fail(char const * what, std::string const & path, int fd=-1) {
+        int const error = errno;
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error(std::string(what) + " '" + path + "': " + std::strerror(error));
+    }
+
+    MappedManager(std::string const & path, std::size_t offset, std::size_t bytes, MapModeEnum mode) :
+        _base(0), _data(0), _length(0), _mode(mode), _path(path)
+    {
+        int fd = ::open(path.c_str(), (mode == MAPPED_READ_WRITE) ? (O_RDWR | O_CREAT) : O_RDONLY, 0666);
+        if (fd < 0) fail("Failed to open", path);
+        struct stat info;
+        if (::fstat(fd, &info) != 0) fail("Failed to stat", path, fd);
+        if (std::size_t(info.st_size) < offset + bytes) {
+            if (mode != MAPPED_READ_WRITE) {
+                ::close(fd);
+                throw std::runtime_error("File '" + path + "' is too small for the requested mapping");
+            }
+            if (::ftruncate(fd, off_t(offset + bytes)) != 0) fail("Failed to resize", path, fd);
+        }
+        std::size_t const pageSize = ::sysconf(_SC_PAGESIZE);
+        std::size_t const start = (offset / pageSize) * pageSize;
+        _length = bytes + (offset - start);
+        if (bytes > 0) {
+            int prot = (mode == MAPPED_READ_ONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+            int flags = (mode == MAPPED_COPY_ON_WRITE) ? MAP_PRIVATE : MAP_SHARED;
+            _base = ::mmap(0, _length, prot, flags, fd, off_t(start));
+            if (_base == MAP_FAILED) {
+                _base = 0;
+                _length = 0;
+                fail("Failed to map", path, fd);
+            }
+            _data = static_cast<char*>(_base) + (offset - start);
+        } else {
+            _length = 0;
+        }
+        ::close(fd);
+    }
+
+    void * _base;
+    void * _data;
+    std::size_t _length;
+    MapModeEnum _mode;
+    std::string _path;
+};
+
+#endif // NDARRAY_HAVE_MMAP
+
 template <typename T> Manager::Ptr makeManager(T const & owner);
 
 template <typename U>
@@ -14,6 +14,8 @@
 #include "boost/numpy.hpp"
 #include "ndarray.h"
 #include "ndarray/bp_fwd.h"
+#include "ndarray/detail/PyBuffer.h"
+#include "ndarray/detail/PyCopyPolicy.h"
 #include <vector>
 
 namespace ndarray {
@@ -68,67 +70,121 @@ template <typename T, int N, int C>
 class FromBoostPython< Array<T,N,C> > {
 public:
 
-    explicit FromBoostPython(boost::python::object const & input_) : input(input_) {}
+    explicit FromBoostPython(boost::python::object const & input_) : input(input_), _converted(false), _copy(false) {}
 
+    /**
+     *  Boost.Python calls convertible() and then operator() on the same converter, so the
+     *  validated Array is constructed here, in a single pass over the dimensions, and
+     *  operator() just returns it.  Arrays that must be copied are only copied in
+     *  operator(), as convertible() is also called while resolving overloads.
+     */
     bool convertible() {
-        if (input.is_none()) return true;
+        if (_converted) return true;
+        if (input.is_none()) {
+            _output = Array<T,N,C>();
+            return _converted = true;
+        }
+        boost::python::extract<boost::numpy::ndarray> extractor(input);
+        if (!extractor.check()) return convertibleBuffer();
         try {
-            boost::numpy::ndarray array = boost::python::extract<boost::numpy::ndarray>(input);
+            boost::numpy::ndarray array = extractor();
             boost::numpy::dtype dtype
                 = boost::numpy::dtype::get_builtin<typename boost::remove_const<T>::type>();
-            boost::numpy::ndarray::bitflag flags = array.get_flags();
-            if (dtype != array.get_dtype()) return false;
             if (N != array.get_nd()) return false;
+            if (dtype != array.get_dtype()) return false;
+            boost::numpy::ndarray::bitflag flags = array.get_flags();
             if (!boost::is_const<T>::value && !(flags & boost::numpy::ndarray::WRITEABLE)) return false;
-            if (C > 0) {
-                int requiredStride = sizeof(T);
-                for (int i = 0; i < C; ++i) {
-                    if (array.strides(N-i-1) != requiredStride) {
-                        return false;
-                    }
-                    requiredStride *= array.shape(N-i-1);
-                }
-            } else if (C < 0) {
-                int requiredStride = sizeof(T);
-                for (int i = 0; i < -C; ++i) {
-                    if (array.strides(i) != requiredStride) {
-                        return false;
-                    }
-                    requiredStride *= array.shape(i);
+            Py_intptr_t const * dims = array.get_shape();
+            Py_intptr_t const * strides = array.get_strides();
+            Vector<int,N> shape;
+            Vector<int,N> elementStrides;
+            Py_intptr_t requiredStride = sizeof(T);
+            for (int i = 0; i < N; ++i) {
+                int const n = (C < 0) ? i : N - i - 1;
+                if (i < ((C < 0) ? -C : C)) {
+                    if (strides[n] != requiredStride) return convertibleCopy();
+                    requiredStride *= dims[n];
                 }
+                shape[n] = dims[n];
+                elementStrides[n] = strides[n] / Py_intptr_t(sizeof(T));
             }
+            boost::python::object obj_owner = array.get_base();
+            if (obj_owner.is_none()) {
+                obj_owner = array;
+            }
+            _output = ndarray::external(
+                reinterpret_cast<T*>(array.get_data()), shape, elementStrides, obj_owner
+            );
         } catch (boost::python::error_already_set) {
             boost::python::handle_exception();
             PyErr_Clear();
             return false;
         }
-        return true;
+        return _converted = true;
     }
 
     Array<T,N,C> operator()() {
-        if (input.is_none()) return Array<T,N,C>();
-        boost::numpy::ndarray array = boost::python::extract<boost::numpy::ndarray>(input);
-        boost::numpy::dtype dtype = array.get_dtype();
-        int itemsize = dtype.get_itemsize();
-        boost::python::object obj_owner = array.get_base();
-        if (obj_owner.is_none()) {
-            obj_owner = array;
+        if (!convertible()) {
+            PyErr_SetString(PyExc_TypeError, "object cannot be converted to ndarray::Array");
+            boost::python::throw_error_already_set();
         }
-        Vector<int,N> shape;
-        Vector<int,N> strides;
-        for (int i=0; i<N; ++i) {
-            shape[i] = array.shape(i);
-            strides[i] = array.strides(i) / itemsize;
+        if (_copy) {
+            boost::numpy::ndarray array = boost::python::extract<boost::numpy::ndarray>(input);
+            _output = detail::copyToContiguous<T,N,C>(
+                array.ptr(), array.get_data(), array.get_shape(), array.get_strides()
+            );
+            _copy = false;
         }
-        Array<T,N,C> r = ndarray::external(
-            reinterpret_cast<T*>(array.get_data()), shape, strides, obj_owner
-        );
-        return r;
+        return _output;
     }
 
     boost::python::object input;
+
+private:
+
+    // Arrays that aren't contiguous enough are copied (by operator()) if PyCopyPolicy allows it.
+    bool convertibleCopy() {
+        if (!boost::is_const<T>::value || !PyCopyPolicy::isEnabled()) return false;
+        _copy = true;
+        return _converted = true;
+    }
+
+    // Objects that aren't numpy arrays are viewed with the buffer protocol.
+    bool convertibleBuffer() {
+        boost::python::handle<> buffer;
+        if (detail::isPyBufferObject(input.ptr())) {
+            buffer = boost::python::handle<>(boost::python::borrowed(input.ptr()));
+        } else if (PyObject_CheckBuffer(input.ptr())) {
+            buffer = boost::python::handle<>(
+                boost::python::allow_null(detail::importPyBuffer<T,N,C>(input.ptr()))
+            );
+        }
+        if (!buffer || !detail::extractPyBuffer(buffer.get(), _output)) {
+            PyErr_Clear();
+            return false;
+        }
+        return _converted = true;
+    }
+
+    bool _converted;
+    bool _copy;
+    Array<T,N,C> _output;
 };
 
+/**
+ *  @brief Create an object that exports an Array with the Python buffer protocol.
+ *
+ *  Unlike the numpy.ndarray returned by ToBoostPython, this does not use the numpy C API;
+ *  the result can be passed to memoryview or numpy.asarray.  The Array will be
+ *  shallow-copied if it has a Manager, and deep-copied otherwise.
+ */
+template <typename T, int N, int C>
+boost::python::object toPyBuffer(Array<T,N,C> const & array) {
+    PyObject * buffer = detail::exportPyBuffer(array);
+    if (buffer == NULL) boost::python::throw_error_already_set();
+    return boost::python::object(boost::python::handle<>(buffer));
+}
+
 } // namespace ndarray
 
 namespace boost { namespace numpy {
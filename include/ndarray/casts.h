@@ -19,10 +19,12 @@
 
 #include "ndarray/Array.h"
 #include "ndarray/ArrayRef.h"
+#include "ndarray/initialization.h"
 #include <boost/type_traits/add_const.hpp>
 #include <boost/type_traits/remove_const.hpp>
 #include <boost/mpl/comparison.hpp>
 #include <boost/static_assert.hpp>
+#include <algorithm>
 
 namespace ndarray {
 namespace detail {
@@ -49,6 +51,39 @@ struct ComplexExtractor {
     }
 };
 
+/**
+ *  @internal @brief Compile-time RMC of views that rearrange dimensions.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  C > 0 guarantees the last C dimensions are row-major contiguous, and C < 0 the first -C
+ *  dimensions are column-major contiguous; each view keeps whatever part of that guarantee
+ *  is left untouched by the dimensions it moves, removes or inserts.
+ */
+template <int N, int C, int I, int J>
+struct SwapAxesRMC {
+    static int const lo = (I < J) ? I : J;
+    static int const hi = (I < J) ? J : I;
+    static int const value = (I == J) ? C
+        : (C > 0) ? ((N - 1 - hi < C) ? N - 1 - hi : C)
+        : (C < 0) ? ((lo < -C) ? -lo : C)
+        : 0;
+};
+
+template <int N, int C, int I>
+struct SqueezeRMC {
+    static int const value = (C > 0) ? ((I >= N - C) ? C - 1 : C)
+        : (C < 0) ? ((I < -C) ? C + 1 : C)
+        : 0;
+};
+
+template <int N, int C, int I>
+struct ExpandDimsRMC {
+    static int const value = (C > 0) ? ((I >= N - C) ? C + 1 : C)
+        : (C < 0) ? ((I <= -C) ? C - 1 : C)
+        : 0;
+};
+
 } // namespace detail
 
 /// @addtogroup MainGroup
@@ -147,6 +182,204 @@ flatten(Array<T,N,C> const & input) {
     return Access::construct(input.getData(), Core::create(newShape, newStrides, input.getManager()));
 }
 
+/**
+ *  @brief Create a view of an array broadcast to a larger shape.
+ *
+ *  As in NumPy, the dimensions of the input are aligned with the last dimensions of the
+ *  new shape; each must either match or have size one.  New and expanded dimensions have
+ *  zero stride, so no data is copied.  Because elements of the result share memory, they
+ *  are always const.
+ *
+ *  @code
+ *  Array<double,2,2> image = allocate(rows, cols);
+ *  Array<double,1,1> offsets = allocate(cols);
+ *  image.deep() += broadcast<2>(offsets, image.getShape());
+ *  @endcode
+ */
+template <int Nb, typename T, int N, int C>
+inline Array<typename boost::add_const<T>::type,Nb,0>
+broadcast(Array<T,N,C> const & input, Vector<int,Nb> const & shape) {
+    typedef detail::ArrayAccess< Array<typename boost::add_const<T>::type,Nb,0> > Access;
+    typedef typename Access::Core Core;
+    BOOST_STATIC_ASSERT(Nb >= N);
+    Vector<int,N> const oldShape = input.getShape();
+    Vector<int,N> const oldStrides = input.getStrides();
+    Vector<int,Nb> newStrides;
+    for (int n = 0; n < Nb; ++n) {
+        int const m = n + N - Nb;
+        if (m < 0 || (oldShape[m] == 1 && shape[n] != 1)) {
+            newStrides[n] = 0;
+        } else {
+            NDARRAY_ASSERT(oldShape[m] == shape[n]);
+            newStrides[n] = oldStrides[m];
+        }
+    }
+    return Access::construct(input.getData(), Core::create(shape, newStrides, input.getManager()));
+}
+
+/**
+ *  @brief Create a view of an array with its dimensions permuted.
+ *
+ *  Dimension n of the result is dimension perm[n] of the input, as in numpy.transpose.  The
+ *  permutation is only known at runtime, so the result has no guaranteed contiguous
+ *  dimensions; use dynamic_dimension_cast to recover them.
+ */
+template <typename T, int N, int C>
+inline ArrayRef<T,N,0>
+transpose(Array<T,N,C> const & input, Vector<int,N> const & perm) {
+    typedef detail::ArrayAccess< ArrayRef<T,N,0> > Access;
+    typedef typename Access::Core Core;
+    Vector<int,N> const oldShape = input.getShape();
+    Vector<int,N> const oldStrides = input.getStrides();
+    Vector<int,N> newShape;
+    Vector<int,N> newStrides;
+    for (int n = 0; n < N; ++n) {
+        NDARRAY_ASSERT(perm[n] >= 0 && perm[n] < N);
+        NDARRAY_ASSERT(std::count(perm.begin(), perm.end(), perm[n]) == 1);
+        newShape[n] = oldShape[perm[n]];
+        newStrides[n] = oldStrides[perm[n]];
+    }
+    return Access::construct(input.getData(), Core::create(newShape, newStrides, input.getManager()));
+}
+
+/**
+ *  @brief Create a view of an array with dimensions I and J exchanged.
+ *
+ *  Contiguous dimensions that are not moved are still guaranteed by the result type.
+ */
+template <int I, int J, typename T, int N, int C>
+inline ArrayRef<T,N,detail::SwapAxesRMC<N,C,I,J>::value>
+swapaxes(Array<T,N,C> const & input) {
+    typedef detail::ArrayAccess< ArrayRef<T,N,detail::SwapAxesRMC<N,C,I,J>::value> > Access;
+    typedef typename Access::Core Core;
+    BOOST_STATIC_ASSERT(I >= 0 && I < N && J >= 0 && J < N);
+    Vector<int,N> newShape = input.getShape();
+    Vector<int,N> newStrides = input.getStrides();
+    std::swap(newShape[I], newShape[J]);
+    std::swap(newStrides[I], newStrides[J]);
+    return Access::construct(input.getData(), Core::create(newShape, newStrides, input.getManager()));
+}
+
+/**
+ *  @brief Create a view of an array with a different shape and the same elements in
+ *         row-major order.
+ *
+ *  As with numpy.reshape, this is possible for many noncontiguous arrays as well: every group
+ *  of input dimensions that is merged or split must be contiguous with respect to each other.
+ *  The result is only guaranteed to be contiguous if the input is.
+ *
+ *  @returns A view with the new shape or, if the input's strides do not allow it (so a copy
+ *           would be required), an empty ArrayRef (one for which isEmpty() is true, with zero
+ *           shape).  Callers that need a result either way should copy the input in that case.
+ */
+template <int M, typename T, int N, int C>
+inline ArrayRef<T,M,(C == N ? M : 0)>
+reshape(Array<T,N,C> const & input, Vector<int,M> const & shape) {
+    typedef detail::ArrayAccess< ArrayRef<T,M,(C == N ? M : 0)> > Access;
+    typedef typename Access::Core Core;
+    NDARRAY_ASSERT(shape.product() == input.getNumElements());
+    Vector<int,N> const inShape = input.getShape();
+    Vector<int,N> const inStrides = input.getStrides();
+    Vector<int,M> newStrides = computeStrides(shape);
+    if (C == N || input.getNumElements() == 0) {
+        return Access::construct(input.getData(), Core::create(shape, newStrides, input.getManager()));
+    }
+    // Dimensions with unit size can be dropped from the input and take any stride in the output.
+    int oldShape[N];
+    int oldStrides[N];
+    int oldN = 0;
+    for (int n = 0; n < N; ++n) {
+        if (inShape[n] != 1) {
+            oldShape[oldN] = inShape[n];
+            oldStrides[oldN] = inStrides[n];
+            ++oldN;
+        }
+    }
+    // Match up groups of old and new dimensions with the same total size, requiring each
+    // group of old dimensions to be contiguous; the new strides then follow from the last one.
+    int oi = 0, oj = 1, ni = 0, nj = 1;
+    while (ni < M && oi < oldN) {
+        int np = shape[ni];
+        int op = oldShape[oi];
+        while (np != op) {
+            if (np < op) {
+                np *= shape[nj++];
+            } else {
+                op *= oldShape[oj++];
+            }
+        }
+        for (int ok = oi; ok < oj - 1; ++ok) {
+            if (oldStrides[ok] != oldShape[ok + 1] * oldStrides[ok + 1]) {
+                return Access::construct(
+                    static_cast<T*>(0), Core::create(Vector<int,M>(), Vector<int,M>(), Manager::Ptr())
+                );
+            }
+        }
+        newStrides[nj - 1] = oldStrides[oj - 1];
+        for (int nk = nj - 1; nk > ni; --nk) newStrides[nk - 1] = newStrides[nk] * shape[nk];
+        ni = nj++;
+        oi = oj++;
+    }
+    // trailing unit dimensions
+    for (int nk = ni; nk < M; ++nk) newStrides[nk] = (nk > 0) ? newStrides[nk - 1] : 1;
+    return Access::construct(input.getData(), Core::create(shape, newStrides, input.getManager()));
+}
+
+/**
+ *  @brief Create a view of an array with dimension I, which must have unit size, removed.
+ */
+template <int I, typename T, int N, int C>
+inline ArrayRef<T,N-1,detail::SqueezeRMC<N,C,I>::value>
+squeeze(Array<T,N,C> const & input) {
+    typedef detail::ArrayAccess< ArrayRef<T,N-1,detail::SqueezeRMC<N,C,I>::value> > Access;
+    typedef typename Access::Core Core;
+    BOOST_STATIC_ASSERT(I >= 0 && I < N && N > 1);
+    NDARRAY_ASSERT(input.template getSize<I>() == 1);
+    Vector<int,N> const oldShape = input.getShape();
+    Vector<int,N> const oldStrides = input.getStrides();
+    Vector<int,N-1> newShape;
+    Vector<int,N-1> newStrides;
+    for (int n = 0, m = 0; n < N; ++n) {
+        if (n == I) continue;
+        newShape[m] = oldShape[n];
+        newStrides[m] = oldStrides[n];
+        ++m;
+    }
+    return Access::construct(input.getData(), Core::create(newShape, newStrides, input.getManager()));
+}
+
+/**
+ *  @brief Create a view of an array with a new dimension of unit size inserted before
+ *         dimension I (or after the last dimension if I == N).
+ */
+template <int I, typename T, int N, int C>
+inline ArrayRef<T,N+1,detail::ExpandDimsRMC<N,C,I>::value>
+expand_dims(Array<T,N,C> const & input) {
+    typedef detail::ArrayAccess< ArrayRef<T,N+1,detail::ExpandDimsRMC<N,C,I>::value> > Access;
+    typedef typename Access::Core Core;
+    BOOST_STATIC_ASSERT(I >= 0 && I <= N);
+    Vector<int,N> const oldShape = input.getShape();
+    Vector<int,N> const oldStrides = input.getStrides();
+    Vector<int,N+1> newShape;
+    Vector<int,N+1> newStrides;
+    for (int n = 0, m = 0; m <= N; ++m) {
+        if (m == I) {
+            newShape[m] = 1;
+            // any stride will do; this one keeps contiguous arrays contiguous
+            if (C >= 0) {
+                newStrides[m] = (I < N) ? oldStrides[I] * oldShape[I] : 1;
+            } else {
+                newStrides[m] = (I > 0) ? oldStrides[I - 1] * oldShape[I - 1] : 1;
+            }
+        } else {
+            newShape[m] = oldShape[n];
+            newStrides[m] = oldStrides[n];
+            ++n;
+        }
+    }
+    return Access::construct(input.getData(), Core::create(newShape, newStrides, input.getManager()));
+}
+
 /// @}
 
 } // namespace ndarray
@@ -19,31 +19,46 @@
 
 #include "ndarray/ExpressionBase.h"
 #include "ndarray/vectorize.h"
-#include <boost/iterator/iterator_adaptor.hpp>
-#include <boost/iterator/zip_iterator.hpp>
-#include <boost/tuple/tuple.hpp>
+#include <boost/iterator/iterator_facade.hpp>
 
 namespace ndarray {
 namespace detail {
 
+/**
+ *  @internal @brief Compute the shape of a binary operation, broadcasting dimensions of size one.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Corresponding dimensions of the operands must either be equal, or one of them must be
+ *  one, as in NumPy.
+ */
+template <int N>
+inline Vector<int,N> broadcastShapes(Vector<int,N> const & shape1, Vector<int,N> const & shape2) {
+    Vector<int,N> r(shape1);
+    for (int n = 0; n < N; ++n) {
+        if (shape1[n] == 1) {
+            r[n] = shape2[n];
+        } else {
+            NDARRAY_ASSERT(shape2[n] == 1 || shape2[n] == shape1[n]);
+        }
+    }
+    return r;
+}
+
 /**
  *  @internal @brief An iterator for binary expression templates.
  *
  *  @ingroup ndarrayInternalGroup
  *
- *  Acts as a combination "zip" and "transform" iterator.
+ *  Acts as a combination "zip" and "transform" iterator.  An operand whose outermost
+ *  dimension is broadcast (has size one when the other's does not) is not advanced, and
+ *  iterators are compared by position.
  */
 template <typename Operand1, typename Operand2, typename BinaryFunction>
-class BinaryOpIterator : public boost::iterator_adaptor<
+class BinaryOpIterator : public boost::iterator_facade<
     BinaryOpIterator<Operand1,Operand2,BinaryFunction>,
-    boost::zip_iterator<
-        boost::tuple<
-            typename ExpressionTraits<Operand1>::Iterator,
-            typename ExpressionTraits<Operand2>::Iterator
-            >
-        >,
     typename ExpressionTraits< BinaryOpExpression<Operand1,Operand2,BinaryFunction> >::Value,
-    boost::use_default,
+    boost::random_access_traversal_tag,
     typename ExpressionTraits< BinaryOpExpression<Operand1,Operand2,BinaryFunction> >::Reference
     > {
     typedef BinaryOpExpression<Operand1,Operand2,BinaryFunction> Operation;
@@ -53,31 +68,44 @@ public:
     typedef typename ExpressionTraits<Operation>::Value Value;
     typedef typename ExpressionTraits<Operation>::Reference Reference;
 
-    BinaryOpIterator() : BinaryOpIterator::iterator_adaptor_(), _functor() {}
+    BinaryOpIterator() :
+        _baseIter1(), _baseIter2(), _functor(), _index(0), _step1(1), _step2(1) {}
 
     BinaryOpIterator(
         BaseIterator1 const & baseIter1, 
         BaseIterator2 const & baseIter2, 
-        BinaryFunction const & functor
+        BinaryFunction const & functor,
+        int index=0, int step1=1, int step2=1
     ) :
-        BinaryOpIterator::iterator_adaptor_(boost::make_tuple(baseIter1,baseIter2)),
-        _functor(functor) {}
-
-    BinaryOpIterator(BinaryOpIterator const & other) :
-        BinaryOpIterator::iterator_adaptor_(other), _functor(other._functor) {}
+        _baseIter1(baseIter1), _baseIter2(baseIter2), _functor(functor),
+        _index(index), _step1(step1), _step2(step2) {}
 
 private:
     friend class boost::iterator_core_access;
 
     Reference dereference() const {
-        return vectorize(
-            _functor, 
-            this->base_reference()->template get<0>(),
-            this->base_reference()->template get<1>()
-        );
+        return vectorize(_functor, *_baseIter1, *_baseIter2);
     }
-    
+
+    void increment() { advance(1); }
+    void decrement() { advance(-1); }
+
+    void advance(int n) {
+        _baseIter1 += n * _step1;
+        _baseIter2 += n * _step2;
+        _index += n;
+    }
+
+    int distance_to(BinaryOpIterator const & other) const { return other._index - _index; }
+
+    bool equal(BinaryOpIterator const & other) const { return _index == other._index; }
+
+    BaseIterator1 _baseIter1;
+    BaseIterator2 _baseIter2;
     BinaryFunction _functor;
+    int _index;
+    int _step1;
+    int _step2;
 };
 
 /**
@@ -85,7 +113,9 @@ private:
  *
  *  @ingroup ndarrayInternalGroup
  *
- *  Represents the lazy evaluation of a binary expression.
+ *  Represents the lazy evaluation of a binary expression.  The operands must have the same
+ *  number of dimensions, but a dimension of size one in either operand is broadcast to the
+ *  size of the other; broadcast operands are read in place.
  */
 template <typename Operand1, typename Operand2, typename BinaryFunction, int N>
 class BinaryOpExpression : public ExpressionBase< BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> > {
@@ -103,33 +133,52 @@ public:
         Operand2 const & operand2,
         BinaryFunction const & functor
     ) :
-        _operand1(operand1), _operand2(operand2), _functor(functor) {
-        NDARRAY_ASSERT(_operand1.getShape() == _operand2.getShape());
+        _operand1(operand1), _operand2(operand2), _functor(functor)
+    {
+        Index const shape1 = _operand1.getShape();
+        Index const shape2 = _operand2.getShape();
+        _isBroadcast = !(shape1 == shape2);
+        _shape = _isBroadcast ? broadcastShapes(shape1, shape2) : shape1;
     }
 
     Reference operator[](int n) const {
-        return Reference(_operand1[n],_operand2[n],_functor);
+        return vectorize(
+            _functor,
+            _operand1[(_operand1.template getSize<0>() == 1) ? 0 : n],
+            _operand2[(_operand2.template getSize<0>() == 1) ? 0 : n]
+        );
     }
 
     Iterator begin() const {
-        return Iterator(_operand1.begin(),_operand2.begin(),_functor);
+        return Iterator(_operand1.begin(), _operand2.begin(), _functor, 0, getStep1(), getStep2());
     }
 
     Iterator end() const {
-        return Iterator(_operand1.end(),_operand2.end(),_functor);
+        return begin() + _shape[0];
     }
 
     template <int P> int getSize() const {
-        return _operand1.template getSize<P>();
+        return _shape[P];
     }
 
     Index getShape() const {
-        return _operand1.getShape();
+        return _shape;
     }
 
+    /// @brief Return true if the operands' shapes differ, so one or both are broadcast.
+    bool isBroadcast() const { return _isBroadcast; }
+
     Operand1 _operand1;
     Operand2 _operand2;
     BinaryFunction _functor;
+
+private:
+
+    int getStep1() const { return (_operand1.template getSize<0>() == _shape[0]) ? 1 : 0; }
+    int getStep2() const { return (_operand2.template getSize<0>() == _shape[0]) ? 1 : 0; }
+
+    Index _shape;
+    bool _isBroadcast;
 };
 
 } // namespace detail
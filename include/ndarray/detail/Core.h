@@ -22,6 +22,7 @@
 #include <boost/mpl/int.hpp>
 #include "ndarray/Vector.h"
 #include "ndarray/Manager.h"
+#include "ndarray/detail/CorePool.h"
 
 namespace ndarray {
 namespace detail {
@@ -43,6 +44,8 @@ namespace detail {
  *  Core objects are never const; even an Array with a const
  *  template parameter holds a Core with a non-const template
  *  parameter.
+ *
+ *  Cores are allocated from CorePool rather than the global heap.
  */
 template <int N>
 class Core : public Core<N-1> {
@@ -83,7 +86,7 @@ public:
         return Ptr(new Core(manager), false);
     }
 
-    Ptr copy() const { return Ptr(new Core(*this)); }
+    Ptr copy() const { return Ptr(new Core(*this), false); }
 
     /// @brief Return the size of the Nth dimension.
     int getSize() const { return _size; }
@@ -175,7 +178,13 @@ public:
     typedef boost::intrusive_ptr<Core> Ptr;
     typedef boost::intrusive_ptr<Core const> ConstPtr;
 
-    Ptr copy() const { return Ptr(new Core(*this)); }
+    Ptr copy() const { return Ptr(new Core(*this), false); }
+
+    /// @brief Allocate a Core of any dimension from the thread-local pool.
+    static void * operator new(std::size_t size) { return CorePool::allocate(size); }
+
+    /// @brief Return a Core of any dimension to the thread-local pool.
+    static void operator delete(void * p, std::size_t size) { CorePool::deallocate(p, size); }
 
     int getSize() const { return 1; }
     int getStride() const { return 1; }
@@ -0,0 +1,190 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_CorePool_h_INCLUDED
+#define NDARRAY_DETAIL_CorePool_h_INCLUDED
+
+/**
+ * @file ndarray/detail/CorePool.h
+ *
+ * @brief Thread-local free lists used to allocate Core objects.
+ *
+ * Every view, reshape, and Array construction allocates a small Core; recycling
+ * them through per-thread free lists keeps tight loops over subarrays off the
+ * global heap.  Defining NDARRAY_NO_CORE_POOL (or building with a compiler that
+ * has no thread-local storage keyword) makes Cores use the global operator new.
+ */
+
+#include <cstddef>
+#include <new>
+
+#ifndef NDARRAY_NO_CORE_POOL
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+#define NDARRAY_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define NDARRAY_THREAD_LOCAL __declspec(thread)
+#else
+#define NDARRAY_NO_CORE_POOL
+#endif
+#endif
+
+#if !defined(NDARRAY_NO_CORE_POOL) && !defined(_WIN32)
+#define NDARRAY_CORE_POOL_PTHREAD
+#include <pthread.h>
+#endif
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief Size-class allocator for Core objects.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Blocks are grouped into size classes of 16 bytes each; each thread keeps a singly-linked
+ *  free list of up to MAX_CACHED blocks per class, which are handed out again before the
+ *  global heap is used.  A block may be freed by a different thread than the one that
+ *  allocated it; it then simply joins the freeing thread's list.  On POSIX systems, a
+ *  thread's lists are returned to the heap when it exits (through a pthread key
+ *  destructor); elsewhere, at most N_CLASSES * MAX_CACHED small blocks are retained per
+ *  exited thread.
+ */
+class CorePool {
+public:
+
+    /// @brief Allocate a block of at least the given size.
+    static void * allocate(std::size_t size) {
+#ifndef NDARRAY_NO_CORE_POOL
+        std::size_t n = getClass(size);
+        if (n < N_CLASSES) {
+            FreeList & list = getThreadCache().lists[n];
+            if (list.head) {
+                Node * node = list.head;
+                list.head = node->next;
+                --list.count;
+                return node;
+            }
+            return ::operator new((n + 1) * GRANULARITY);
+        }
+#endif
+        return ::operator new(size);
+    }
+
+    /// @brief Free a block returned by allocate(size).
+    static void deallocate(void * p, std::size_t size) {
+#ifndef NDARRAY_NO_CORE_POOL
+        std::size_t n = getClass(size);
+        if (p && n < N_CLASSES) {
+            FreeList & list = getThreadCache().lists[n];
+            if (list.count < MAX_CACHED) {
+                Node * node = static_cast<Node*>(p);
+                node->next = list.head;
+                list.head = node;
+                ++list.count;
+                return;
+            }
+        }
+#endif
+        ::operator delete(p);
+    }
+
+    /// @brief Return the number of free blocks cached by this thread (for testing purposes).
+    static int getCachedCount() {
+        int count = 0;
+#ifndef NDARRAY_NO_CORE_POOL
+        for (std::size_t n = 0; n < N_CLASSES; ++n) count += getThreadCache().lists[n].count;
+#endif
+        return count;
+    }
+
+    /// @brief Return all blocks cached by this thread to the heap.
+    static void releaseCached() {
+#ifndef NDARRAY_NO_CORE_POOL
+        release(getThreadCache().lists);
+#endif
+    }
+
+private:
+
+    enum { GRANULARITY = 16, N_CLASSES = 16, MAX_CACHED = 64 };
+
+    struct Node {
+        Node * next;
+    };
+
+    struct FreeList {
+        Node * head;
+        int count;
+    };
+
+    static std::size_t getClass(std::size_t size) { return (size + GRANULARITY - 1) / GRANULARITY - 1; }
+
+#ifndef NDARRAY_NO_CORE_POOL
+
+    struct ThreadCache {
+        FreeList lists[N_CLASSES];
+        bool registered;    ///< True if the lists will be released when the thread exits.
+    };
+
+    static void release(FreeList * lists) {
+        for (std::size_t n = 0; n < N_CLASSES; ++n) {
+            while (lists[n].head) {
+                Node * node = lists[n].head;
+                lists[n].head = node->next;
+                ::operator delete(node);
+            }
+            lists[n].count = 0;
+        }
+    }
+
+    static ThreadCache & getThreadCache() {
+        static NDARRAY_THREAD_LOCAL ThreadCache cache;
+#ifdef NDARRAY_CORE_POOL_PTHREAD
+        if (!cache.registered) {
+            cache.registered = true;
+            ::pthread_setspecific(getThreadExitKey(), &cache);
+        }
+#endif
+        return cache;
+    }
+
+#ifdef NDARRAY_CORE_POOL_PTHREAD
+
+    // Blocks freed by later thread-exit destructors register the cache again, so they are
+    // released on the next round of destructor calls.
+    static void releaseAtThreadExit(void * p) {
+        ThreadCache * cache = static_cast<ThreadCache*>(p);
+        release(cache->lists);
+        cache->registered = false;
+    }
+
+    static void createThreadExitKey() { ::pthread_key_create(&getThreadExitKeyStorage(), &releaseAtThreadExit); }
+
+    static pthread_key_t & getThreadExitKeyStorage() {
+        static pthread_key_t key;
+        return key;
+    }
+
+    static pthread_key_t getThreadExitKey() {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        ::pthread_once(&once, &createThreadExitKey);
+        return getThreadExitKeyStorage();
+    }
+
+#endif
+
+#endif
+
+};
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_CorePool_h_INCLUDED
@@ -0,0 +1,911 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_Evaluation_h_INCLUDED
+#define NDARRAY_DETAIL_Evaluation_h_INCLUDED
+
+/**
+ * @file ndarray/detail/Evaluation.h
+ *
+ * @brief Flat (linear-index) evaluation of array assignment.
+ *
+ * ArrayRef assignment normally walks its operands with NestedIterator, which
+ * materializes an ArrayRef<T,N-1> proxy per outer row.  When the destination
+ * and every leaf of the expression share the same dense memory layout, the
+ * whole assignment can instead be done with one loop over raw pointers.
+ * If the expression's leaves and functions all operate on the destination's
+ * element type and have SIMD implementations, that loop processes one
+ * Packet at a time, with a scalar loop for the remainder.
+ *
+ * Assignments between plain arrays whose fastest-varying dimensions differ (e.g. from a
+ * transposed view) are instead done in cache-sized tiles, transposing blocks of float and
+ * double elements in SIMD registers.
+ *
+ * Other expressions over arrays with arbitrary layouts are evaluated with a LoopPlan: an
+ * outer odometer over the dimensions that cannot be merged, and one flat inner loop (still
+ * vectorized when every operand has unit stride) over the ones that can.
+ */
+
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+#include "ndarray_fwd.h"
+#include "ndarray/Vector.h"
+#include "ndarray/detail/Packet.h"
+#include "ndarray/detail/LoopPlan.h"
+
+namespace ndarray {
+namespace detail {
+
+struct Assign;
+
+/**
+ *  @internal @brief Return true if the given shape and strides describe a dense block of memory.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  The dimensions may appear in any order (row-major, column-major, or any other permutation),
+ *  but all strides must be positive and there can be no gaps between elements.  Dimensions with
+ *  unit size are ignored, and empty arrays are always considered dense.
+ */
+template <int N>
+inline bool isDense(Vector<int,N> const & shape, Vector<int,N> const & strides) {
+    int order[N];
+    int m = 0;
+    for (int n = 0; n < N; ++n) {
+        if (shape[n] == 0) return true;
+        if (shape[n] == 1) continue;
+        // insertion sort of the non-trivial dimensions by increasing stride
+        int k = m++;
+        for (; k > 0 && strides[order[k-1]] > strides[n]; --k) order[k] = order[k-1];
+        order[k] = n;
+    }
+    int expected = 1;
+    for (int k = 0; k < m; ++k) {
+        if (strides[order[k]] != expected) return false;
+        expected *= shape[order[k]];
+    }
+    return true;
+}
+
+/**
+ *  @internal @brief Return true if two arrays with the given shape have the same memory layout.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Strides of dimensions with unit size are ignored.
+ */
+template <int N>
+inline bool haveSameLayout(
+    Vector<int,N> const & shape, Vector<int,N> const & strides1, Vector<int,N> const & strides2
+) {
+    for (int n = 0; n < N; ++n) {
+        if (shape[n] != 1 && strides1[n] != strides2[n]) return false;
+    }
+    return true;
+}
+
+/**
+ *  @internal @brief Traits that expose an expression as a linearly-indexable cursor.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  An expression can be evaluated flat if it is an Array or ArrayRef, or an elementwise
+ *  unary or binary operation whose leaves are all Arrays or ArrayRefs.  This unspecialized
+ *  template is used for all other expressions (such as CountingExpression), which are always
+ *  evaluated with nested iteration.
+ *
+ *  Specializations provide:
+ *   - IsFlat: boost::mpl::true_.
+ *   - IsRowMajor, IsColumnMajor: whether all leaves are fully contiguous in that order at
+ *     compile time (from their RMC parameter).
+ *   - Cursor: a type with operator[](int) returning the i-th element in memory order.
+ *   - getCursor(expr): construct a Cursor.
+ *   - getCursor(expr, index): construct a Cursor that starts at the given index.
+ *   - StridedCursor: like Cursor, but with operator[](i) returning the i-th element along
+ *     one dimension.
+ *   - getStridedCursor(expr, index, axis): construct a StridedCursor that starts at the given
+ *     index and steps along the given dimension.
+ *   - visitStrides(expr, visitor): call visitor(strides) for every leaf.
+ *   - hasLayout(expr, shape, strides): runtime check that every leaf has the given
+ *     shape and the same memory layout as the given strides.
+ *   - isBroadcast(expr): runtime check for a binary operation whose operands have different
+ *     shapes; such expressions are never evaluated flat, even if IsRowMajor or IsColumnMajor.
+ */
+template <typename Expression>
+struct FlatTraits {
+    typedef boost::mpl::false_ IsFlat;
+    typedef boost::mpl::false_ IsRowMajor;
+    typedef boost::mpl::false_ IsColumnMajor;
+    typedef void Cursor;
+    typedef void StridedCursor;
+};
+
+/**
+ *  @internal @brief Cursor that steps through an array with a constant stride.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T>
+struct StridedFlatCursor {
+    T & operator[](int i) const { return data[i * stride]; }
+
+    T * data;
+    int stride;
+};
+
+/**
+ *  @internal @brief FlatTraits implementation shared by Array and ArrayRef.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, int N, int C>
+struct ArrayFlatTraits {
+    typedef boost::mpl::true_ IsFlat;
+    typedef boost::mpl::bool_<(C == N)> IsRowMajor;
+    typedef boost::mpl::bool_<(C == -N)> IsColumnMajor;
+    typedef T * Cursor;
+    typedef StridedFlatCursor<T> StridedCursor;
+
+    template <typename Array_>
+    static Cursor getCursor(Array_ const & array) { return array.getData(); }
+
+    template <typename Array_>
+    static Cursor getCursor(Array_ const & array, Vector<int,N> const & index) {
+        return array.getData() + computeOffset(index, array.getStrides());
+    }
+
+    template <typename Array_>
+    static StridedCursor getStridedCursor(Array_ const & array, Vector<int,N> const & index,
+                                          int axis) {
+        StridedCursor r = { getCursor(array, index), array.getStrides()[axis] };
+        return r;
+    }
+
+    template <typename Array_, typename Visitor>
+    static void visitStrides(Array_ const & array, Visitor & visitor) {
+        visitor(array.getStrides());
+    }
+
+    template <typename Array_>
+    static bool hasLayout(Array_ const & array, Vector<int,N> const & shape,
+                          Vector<int,N> const & strides) {
+        return array.getShape() == shape && haveSameLayout(shape, array.getStrides(), strides);
+    }
+
+    template <typename Array_>
+    static bool isBroadcast(Array_ const &) { return false; }
+};
+
+template <typename T, int N, int C>
+struct FlatTraits< Array<T,N,C> > : public ArrayFlatTraits<T,N,C> {};
+
+template <typename T, int N, int C>
+struct FlatTraits< ArrayRef<T,N,C> > : public ArrayFlatTraits<T,N,C> {};
+
+#ifndef GCC_45
+
+/**
+ *  @internal @brief Linear cursor for a UnaryOpExpression.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename OperandCursor, typename UnaryFunction>
+struct UnaryOpFlatCursor {
+    typedef typename UnaryFunction::result_type Value;
+
+    Value operator[](int i) const { return functor(operand[i]); }
+
+    OperandCursor operand;
+    UnaryFunction functor;
+};
+
+template <typename Operand, typename UnaryFunction, int N>
+struct FlatTraits< UnaryOpExpression<Operand,UnaryFunction,N> > {
+    typedef UnaryOpExpression<Operand,UnaryFunction,N> Expression;
+    typedef FlatTraits<Operand> OperandTraits;
+    typedef typename OperandTraits::IsFlat IsFlat;
+    typedef typename OperandTraits::IsRowMajor IsRowMajor;
+    typedef typename OperandTraits::IsColumnMajor IsColumnMajor;
+    typedef UnaryOpFlatCursor<typename OperandTraits::Cursor,UnaryFunction> Cursor;
+    typedef UnaryOpFlatCursor<typename OperandTraits::StridedCursor,UnaryFunction> StridedCursor;
+
+    static Cursor getCursor(Expression const & expr) {
+        Cursor r = { OperandTraits::getCursor(expr._operand), expr._functor };
+        return r;
+    }
+
+    static Cursor getCursor(Expression const & expr, Vector<int,N> const & index) {
+        Cursor r = { OperandTraits::getCursor(expr._operand, index), expr._functor };
+        return r;
+    }
+
+    static StridedCursor getStridedCursor(Expression const & expr, Vector<int,N> const & index,
+                                          int axis) {
+        StridedCursor r = { OperandTraits::getStridedCursor(expr._operand, index, axis),
+                            expr._functor };
+        return r;
+    }
+
+    template <typename Visitor>
+    static void visitStrides(Expression const & expr, Visitor & visitor) {
+        OperandTraits::visitStrides(expr._operand, visitor);
+    }
+
+    static bool hasLayout(Expression const & expr, Vector<int,N> const & shape,
+                          Vector<int,N> const & strides) {
+        return OperandTraits::hasLayout(expr._operand, shape, strides);
+    }
+
+    static bool isBroadcast(Expression const & expr) {
+        return OperandTraits::isBroadcast(expr._operand);
+    }
+};
+
+/**
+ *  @internal @brief Linear cursor for a BinaryOpExpression.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename OperandCursor1, typename OperandCursor2, typename BinaryFunction>
+struct BinaryOpFlatCursor {
+    typedef typename BinaryFunction::result_type Value;
+
+    Value operator[](int i) const { return functor(operand1[i], operand2[i]); }
+
+    OperandCursor1 operand1;
+    OperandCursor2 operand2;
+    BinaryFunction functor;
+};
+
+template <typename Operand1, typename Operand2, typename BinaryFunction, int N>
+struct FlatTraits< BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> > {
+    typedef BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> Expression;
+    typedef FlatTraits<Operand1> OperandTraits1;
+    typedef FlatTraits<Operand2> OperandTraits2;
+    typedef boost::mpl::and_<
+        typename OperandTraits1::IsFlat, typename OperandTraits2::IsFlat
+        > IsFlat;
+    typedef boost::mpl::and_<
+        typename OperandTraits1::IsRowMajor, typename OperandTraits2::IsRowMajor
+        > IsRowMajor;
+    typedef boost::mpl::and_<
+        typename OperandTraits1::IsColumnMajor, typename OperandTraits2::IsColumnMajor
+        > IsColumnMajor;
+    typedef BinaryOpFlatCursor<
+        typename OperandTraits1::Cursor, typename OperandTraits2::Cursor, BinaryFunction
+        > Cursor;
+    typedef BinaryOpFlatCursor<
+        typename OperandTraits1::StridedCursor, typename OperandTraits2::StridedCursor,
+        BinaryFunction
+        > StridedCursor;
+
+    static Cursor getCursor(Expression const & expr) {
+        Cursor r = {
+            OperandTraits1::getCursor(expr._operand1),
+            OperandTraits2::getCursor(expr._operand2),
+            expr._functor
+        };
+        return r;
+    }
+
+    static Cursor getCursor(Expression const & expr, Vector<int,N> const & index) {
+        Cursor r = {
+            OperandTraits1::getCursor(expr._operand1, index),
+            OperandTraits2::getCursor(expr._operand2, index),
+            expr._functor
+        };
+        return r;
+    }
+
+    static StridedCursor getStridedCursor(Expression const & expr, Vector<int,N> const & index,
+                                          int axis) {
+        StridedCursor r = {
+            OperandTraits1::getStridedCursor(expr._operand1, index, axis),
+            OperandTraits2::getStridedCursor(expr._operand2, index, axis),
+            expr._functor
+        };
+        return r;
+    }
+
+    template <typename Visitor>
+    static void visitStrides(Expression const & expr, Visitor & visitor) {
+        OperandTraits1::visitStrides(expr._operand1, visitor);
+        OperandTraits2::visitStrides(expr._operand2, visitor);
+    }
+
+    static bool hasLayout(Expression const & expr, Vector<int,N> const & shape,
+                          Vector<int,N> const & strides) {
+        return OperandTraits1::hasLayout(expr._operand1, shape, strides)
+            && OperandTraits2::hasLayout(expr._operand2, shape, strides);
+    }
+
+    static bool isBroadcast(Expression const & expr) {
+        return expr.isBroadcast() || OperandTraits1::isBroadcast(expr._operand1)
+            || OperandTraits2::isBroadcast(expr._operand2);
+    }
+};
+
+#endif // !GCC_45
+
+/**
+ *  @internal @brief Packet loads from a flat cursor.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  IsVectorized is true only if every leaf of the cursor has element type T and every
+ *  function in it has a PacketFunction implementation for T.
+ */
+template <typename Cursor, typename T>
+struct PacketCursor {
+    typedef boost::mpl::false_ IsVectorized;
+};
+
+template <typename T>
+struct PacketCursor<T *,T> {
+    typedef typename Packet<T>::IsVectorized IsVectorized;
+
+    static typename Packet<T>::Type load(T const * cursor, int i) {
+        return Packet<T>::load(cursor + i);
+    }
+};
+
+template <typename T>
+struct PacketCursor<T const *,T> : public PacketCursor<T *,T> {};
+
+#ifndef GCC_45
+
+template <typename OperandCursor, typename UnaryFunction, typename T>
+struct PacketCursor<UnaryOpFlatCursor<OperandCursor,UnaryFunction>,T> {
+    typedef boost::mpl::and_<
+        typename PacketCursor<OperandCursor,T>::IsVectorized,
+        typename PacketFunction<UnaryFunction,T>::IsVectorized
+        > IsVectorized;
+
+    static typename Packet<T>::Type load(
+        UnaryOpFlatCursor<OperandCursor,UnaryFunction> const & cursor, int i
+    ) {
+        return PacketFunction<UnaryFunction,T>::apply(
+            cursor.functor,
+            PacketCursor<OperandCursor,T>::load(cursor.operand, i)
+        );
+    }
+};
+
+template <typename OperandCursor1, typename OperandCursor2, typename BinaryFunction, typename T>
+struct PacketCursor<BinaryOpFlatCursor<OperandCursor1,OperandCursor2,BinaryFunction>,T> {
+    typedef boost::mpl::and_<
+        typename PacketCursor<OperandCursor1,T>::IsVectorized,
+        typename PacketCursor<OperandCursor2,T>::IsVectorized,
+        typename PacketFunction<BinaryFunction,T>::IsVectorized
+        > IsVectorized;
+
+    static typename Packet<T>::Type load(
+        BinaryOpFlatCursor<OperandCursor1,OperandCursor2,BinaryFunction> const & cursor, int i
+    ) {
+        return PacketFunction<BinaryFunction,T>::apply(
+            cursor.functor,
+            PacketCursor<OperandCursor1,T>::load(cursor.operand1, i),
+            PacketCursor<OperandCursor2,T>::load(cursor.operand2, i)
+        );
+    }
+};
+
+#endif // !GCC_45
+
+/**
+ *  @internal @brief Apply an assignment elementwise over a flat range, one element at a time.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, typename Cursor, typename AssignOp>
+inline void flatLoop(T * out, Cursor const & in, int begin, int end, AssignOp const & op,
+                     boost::mpl::false_) {
+    for (int i = begin; i < end; ++i) {
+        op(out[i], in[i]);
+    }
+}
+
+/**
+ *  @internal @brief Apply an assignment elementwise over a flat range, one Packet at a time.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, typename Cursor, typename AssignOp>
+inline void flatLoop(T * out, Cursor const & in, int begin, int end, AssignOp const & op,
+                     boost::mpl::true_) {
+    int i = begin;
+    for (; i + Packet<T>::size <= end; i += Packet<T>::size) {
+        PacketAssign<AssignOp,T>::apply(out + i, PacketCursor<Cursor,T>::load(in, i));
+    }
+    for (; i < end; ++i) {
+        op(out[i], in[i]);
+    }
+}
+
+/**
+ *  @internal @brief Flat cursor that returns the same scalar for every element.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Scalar>
+struct ScalarFlatCursor {
+    Scalar const & operator[](int) const { return value; }
+
+    Scalar value;
+};
+
+template <typename T>
+struct PacketCursor<ScalarFlatCursor<T>,T> {
+    typedef typename Packet<T>::IsVectorized IsVectorized;
+
+    static typename Packet<T>::Type load(ScalarFlatCursor<T> const & cursor, int) {
+        return Packet<T>::set1(cursor.value);
+    }
+};
+
+/**
+ *  @internal @brief Implementation for FlatEvaluator; the primary template handles
+ *         expressions that can never be evaluated flat.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Destination, typename Expression, bool isFlat>
+struct FlatEvaluatorImpl {
+    static bool check(Destination const &, Expression const &) { return false; }
+
+    template <typename AssignOp>
+    static void apply(Destination const &, Expression const &, AssignOp const &, int, int) {}
+};
+
+template <typename Destination, typename Expression>
+struct FlatEvaluatorImpl<Destination,Expression,true> {
+    typedef FlatTraits<Destination> DestinationTraits;
+    typedef FlatTraits<Expression> OperandTraits;
+    typedef boost::mpl::or_<
+        boost::mpl::and_<
+            typename DestinationTraits::IsRowMajor, typename OperandTraits::IsRowMajor
+            >,
+        boost::mpl::and_<
+            typename DestinationTraits::IsColumnMajor, typename OperandTraits::IsColumnMajor
+            >
+        > IsContiguous;
+
+    static bool check(Destination const & dest, Expression const & expr) {
+        if (OperandTraits::isBroadcast(expr)) return false;
+        if (IsContiguous::value) return true;
+        typename Destination::Index shape = dest.getShape();
+        typename Destination::Index strides = dest.getStrides();
+        return isDense(shape, strides) && OperandTraits::hasLayout(expr, shape, strides);
+    }
+
+    template <typename AssignOp>
+    static void apply(Destination const & dest, Expression const & expr, AssignOp const & op,
+                      int begin, int end) {
+        typedef typename Destination::Element Element;
+        typedef typename OperandTraits::Cursor Cursor;
+        flatLoop(
+            dest.getData(), OperandTraits::getCursor(expr), begin, end, op,
+            typename boost::mpl::and_<
+                typename PacketCursor<Cursor,Element>::IsVectorized,
+                typename PacketAssign<AssignOp,Element>::IsVectorized
+            >::type()
+        );
+    }
+};
+
+/**
+ *  @internal @brief Flat evaluation of an array assignment.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  check() returns true if the destination and every leaf of the expression share one dense
+ *  memory layout; only then may apply() be called, which evaluates the elements in the
+ *  half-open range [begin, end) of that layout.  apply() touches only raw data pointers, never
+ *  Core reference counts, so disjoint ranges may be evaluated concurrently.  The expression
+ *  must have the same number of dimensions as the destination, and the destination's shape
+ *  must already have been checked against it.
+ */
+template <typename Destination, typename Expression>
+struct FlatEvaluator : public FlatEvaluatorImpl<
+    Destination, Expression,
+    boost::mpl::and_<
+        typename FlatTraits<Expression>::IsFlat,
+        boost::mpl::bool_<(ExpressionTraits<Expression>::ND::value
+                           == ExpressionTraits<Destination>::ND::value)>
+        >::value
+    >
+{};
+
+/**
+ *  @internal @brief Attempt to evaluate an array assignment with a single loop over raw pointers.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Returns false (without modifying the destination) if FlatEvaluator::check fails; the
+ *  caller should then fall back to nested iteration.
+ */
+template <typename Destination, typename Expression, typename AssignOp>
+inline bool flatEvaluate(Destination const & dest, Expression const & expr, AssignOp const & op) {
+    typedef FlatEvaluator<Destination,Expression> Evaluator;
+    if (!Evaluator::check(dest, expr)) return false;
+    Evaluator::apply(dest, expr, op, 0, dest.getNumElements());
+    return true;
+}
+
+/**
+ *  @internal @brief Apply an assignment elementwise along one dimension of arbitrary stride.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, typename Cursor, typename AssignOp>
+inline void stridedLoop(StridedFlatCursor<T> const & out, Cursor const & in, int size,
+                        AssignOp const & op) {
+    for (int i = 0; i < size; ++i) {
+        op(out[i], in[i]);
+    }
+}
+
+/**
+ *  @internal @brief Stride enumeration for the LoopPlan of an assignment: the destination
+ *         followed by every leaf of the expression.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Destination, typename Expression>
+struct AssignmentOperands {
+
+    AssignmentOperands(Destination const & dest_, Expression const & expr_) :
+        dest(dest_), expr(expr_) {}
+
+    template <typename Visitor>
+    void operator()(Visitor & visitor) const {
+        visitor(dest.getStrides());
+        FlatTraits<Expression>::visitStrides(expr, visitor);
+    }
+
+    Destination const & dest;
+    Expression const & expr;
+};
+
+/**
+ *  @internal @brief Implementation for plannedEvaluate; the primary template handles
+ *         expressions that can never be evaluated with a LoopPlan.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Destination, typename Expression, bool isFlat>
+struct PlannedEvaluatorImpl {
+    template <typename AssignOp>
+    static bool apply(Destination const &, Expression const &, AssignOp const &) { return false; }
+};
+
+template <typename Destination, typename Expression>
+struct PlannedEvaluatorImpl<Destination,Expression,true> {
+    typedef FlatTraits<Expression> OperandTraits;
+    typedef typename Destination::Element Element;
+    typedef typename Destination::Index Index;
+
+    template <typename AssignOp>
+    struct Body {
+        typedef typename boost::mpl::and_<
+            typename PacketCursor<typename OperandTraits::Cursor,Element>::IsVectorized,
+            typename PacketAssign<AssignOp,Element>::IsVectorized
+            >::type IsVectorized;
+
+        void operator()(Index const & index) const {
+            Element * out = data + computeOffset(index, strides);
+            if (isUnit) {
+                flatLoop(out, OperandTraits::getCursor(expr, index), 0, size, op, IsVectorized());
+            } else {
+                StridedFlatCursor<Element> cursor = { out, strides[axis] };
+                stridedLoop(cursor, OperandTraits::getStridedCursor(expr, index, axis), size, op);
+            }
+        }
+
+        Element * data;
+        Index strides;
+        Expression const & expr;
+        AssignOp const & op;
+        int axis;
+        int size;
+        bool isUnit;
+    };
+
+    template <typename AssignOp>
+    static bool apply(Destination const & dest, Expression const & expr, AssignOp const & op) {
+        if (OperandTraits::isBroadcast(expr)) return false;
+        AssignmentOperands<Destination,Expression> operands(dest, expr);
+        LoopPlan<Destination::ND::value> plan(dest.getShape(), operands, true);
+        Body<AssignOp> body = {
+            dest.getData(), dest.getStrides(), expr, op,
+            plan.inner, plan.innerSize, plan.hasUnitStride(operands)
+        };
+        plan.execute(body);
+        return true;
+    }
+};
+
+/**
+ *  @internal @brief Attempt to evaluate an array assignment with a LoopPlan.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  This handles any destination layout and any expression for which FlatTraits is defined,
+ *  as long as it does not broadcast; it returns false (without modifying the destination)
+ *  for all others.  The expression must have the same shape as the destination.
+ */
+template <typename Destination, typename Expression, typename AssignOp>
+inline bool plannedEvaluate(Destination const & dest, Expression const & expr,
+                            AssignOp const & op) {
+    return PlannedEvaluatorImpl<
+        Destination, Expression,
+        boost::mpl::and_<
+            typename FlatTraits<Expression>::IsFlat,
+            boost::mpl::bool_<(ExpressionTraits<Expression>::ND::value
+                               == ExpressionTraits<Destination>::ND::value)>
+            >::value
+        >::apply(dest, expr, op);
+}
+
+/**
+ *  @internal @brief Base case of transposeCopy: a block small enough to stay in cache.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  This overload is used when the element types match and the assignment is a plain copy,
+ *  and it moves PacketTranspose-sized blocks through registers when both arrays are
+ *  contiguous along their own fast dimension.
+ */
+template <typename T, typename AssignOp>
+inline void transposeTile(T * dst, int dI, int dJ, T const * src, int sI, int sJ, int m, int n,
+                          AssignOp const & op, boost::mpl::true_) {
+    typedef PacketTranspose<T> Kernel;
+    int const k = Kernel::size;
+    int mk = 0;
+    int nk = 0;
+    if (dI == 1 && sJ == 1) {
+        mk = m - m % k;
+        nk = n - n % k;
+        for (int i = 0; i < mk; i += k) {
+            for (int j = 0; j < nk; j += k) {
+                Kernel::apply(src + i*sI + j, sI, dst + j*dJ + i, dJ);
+            }
+        }
+    }
+    for (int j = 0; j < n; ++j) {
+        for (int i = (j < nk) ? mk : 0; i < m; ++i) {
+            op(dst[i*dI + j*dJ], src[i*sI + j*sJ]);
+        }
+    }
+}
+
+template <typename T, typename U, typename AssignOp>
+inline void transposeTile(T * dst, int dI, int dJ, U const * src, int sI, int sJ, int m, int n,
+                          AssignOp const & op, boost::mpl::false_) {
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < m; ++i) {
+            op(dst[i*dI + j*dJ], src[i*sI + j*sJ]);
+        }
+    }
+}
+
+/**
+ *  @internal @brief Cache-oblivious assignment of a 2-d block whose two arrays have different
+ *         fast dimensions.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Element (i,j) is dst[i*dI + j*dJ] and src[i*sI + j*sJ]; the block is split in half along
+ *  its longer side until it fits in a tile, so both arrays are traversed a few cache lines at
+ *  a time however large their strides are.
+ */
+template <typename T, typename U, typename AssignOp>
+void transposeCopy(T * dst, int dI, int dJ, U const * src, int sI, int sJ, int m, int n,
+                   AssignOp const & op) {
+    enum { TILE = 32 };
+    while (m > TILE || n > TILE) {
+        if (m >= n) {
+            int const h = m / 2;
+            transposeCopy(dst, dI, dJ, src, sI, sJ, h, n, op);
+            dst += h * dI;
+            src += h * sI;
+            m -= h;
+        } else {
+            int const h = n / 2;
+            transposeCopy(dst, dI, dJ, src, sI, sJ, m, h, op);
+            dst += h * dJ;
+            src += h * sJ;
+            n -= h;
+        }
+    }
+    transposeTile(
+        dst, dI, dJ, src, sI, sJ, m, n, op,
+        typename boost::mpl::and_<
+            boost::is_same<T,typename boost::remove_const<U>::type>,
+            boost::is_same<AssignOp,Assign>,
+            typename PacketTranspose<T>::IsVectorized
+        >::type()
+    );
+}
+
+/**
+ *  @internal @brief Return the dimension with the smallest nonzero stride among those with
+ *         more than one element, or -1 if there is none.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <int N>
+inline int findFastDimension(Vector<int,N> const & shape, Vector<int,N> const & strides) {
+    int result = -1;
+    for (int n = 0; n < N; ++n) {
+        if (shape[n] <= 1 || strides[n] <= 0) continue;
+        if (result < 0 || strides[n] < strides[result]) result = n;
+    }
+    return result;
+}
+
+/**
+ *  @internal @brief Assign one array to another with the fastest-varying dimensions of the
+ *         two in different places (e.g. row-major to column-major).
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Returns false (without modifying the destination) if the arrays share a fast dimension,
+ *  in which case nested iteration is already cache-friendly.  Otherwise the 2-d blocks spanned
+ *  by the two fast dimensions are assigned with transposeCopy, looping over the remaining
+ *  dimensions.
+ */
+template <typename T, typename U, int N, typename AssignOp>
+bool transposeAssign(
+    T * dst, Vector<int,N> const & shape, Vector<int,N> const & dstStrides,
+    U * src, Vector<int,N> const & srcStrides, AssignOp const & op
+) {
+    if (N < 2) return false;
+    int const a = findFastDimension(shape, dstStrides);
+    int const b = findFastDimension(shape, srcStrides);
+    if (a < 0 || b < 0 || a == b) return false;
+    for (int n = 0; n < N; ++n) {
+        if (shape[n] == 0) return true;
+    }
+    // odometer over the other dimensions
+    int outer[N];
+    int nOuter = 0;
+    for (int n = 0; n < N; ++n) {
+        if (n != a && n != b) outer[nOuter++] = n;
+    }
+    int index[N] = {0};
+    while (true) {
+        transposeCopy(
+            dst, dstStrides[a], dstStrides[b], src, srcStrides[a], srcStrides[b],
+            shape[a], shape[b], op
+        );
+        int k = nOuter - 1;
+        for (; k >= 0; --k) {
+            int const d = outer[k];
+            dst += dstStrides[d];
+            src += srcStrides[d];
+            if (++index[k] < shape[d]) break;
+            dst -= dstStrides[d] * shape[d];
+            src -= srcStrides[d] * shape[d];
+            index[k] = 0;
+        }
+        if (k < 0) return true;
+    }
+}
+
+/**
+ *  @internal @brief Attempt an array assignment with transposeAssign.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Only plain arrays are handled; other expressions return false.
+ */
+template <typename Destination, typename Expression, typename AssignOp>
+inline bool transposeEvaluate(Destination const &, Expression const &, AssignOp const &) {
+    return false;
+}
+
+template <typename T, int N, int C, typename U, int D, typename AssignOp>
+inline bool transposeEvaluate(ArrayRef<T,N,C> const & dest, Array<U,N,D> const & src,
+                              AssignOp const & op) {
+    return transposeAssign(dest.getData(), dest.getShape(), dest.getStrides(),
+                           src.getData(), src.getStrides(), op);
+}
+
+template <typename T, int N, int C, typename U, int D, typename AssignOp>
+inline bool transposeEvaluate(ArrayRef<T,N,C> const & dest, ArrayRef<U,N,D> const & src,
+                              AssignOp const & op) {
+    return transposeAssign(dest.getData(), dest.getShape(), dest.getStrides(),
+                           src.getData(), src.getStrides(), op);
+}
+
+/**
+ *  @internal @brief Fill loop for a scalar that can be converted to the element type up front.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, typename Scalar, typename AssignOp>
+inline void flatFillLoop(T * out, Scalar const & scalar, int begin, int end, AssignOp const & op,
+                         boost::mpl::true_) {
+    ScalarFlatCursor<T> cursor = { static_cast<T>(scalar) };
+    flatLoop(
+        out, cursor, begin, end, op,
+        typename boost::mpl::and_<
+            typename PacketCursor<ScalarFlatCursor<T>,T>::IsVectorized,
+            typename PacketAssign<AssignOp,T>::IsVectorized
+        >::type()
+    );
+}
+
+/**
+ *  @internal @brief Fill loop for augmented assignment of a scalar with a different type.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Converting the scalar first could change the precision of the computation, so this is
+ *  always done one element at a time.
+ */
+template <typename T, typename Scalar, typename AssignOp>
+inline void flatFillLoop(T * out, Scalar const & scalar, int begin, int end, AssignOp const & op,
+                         boost::mpl::false_) {
+    ScalarFlatCursor<Scalar> cursor = { scalar };
+    flatLoop(out, cursor, begin, end, op, boost::mpl::false_());
+}
+
+/**
+ *  @internal @brief Return true if the destination of a scalar assignment can be filled flat.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Destination>
+inline bool isFlatFillable(Destination const & dest) {
+    typedef FlatTraits<Destination> DestinationTraits;
+    return DestinationTraits::IsRowMajor::value || DestinationTraits::IsColumnMajor::value
+        || isDense(dest.getShape(), dest.getStrides());
+}
+
+/**
+ *  @internal @brief Apply a scalar assignment to the elements in [begin, end) of a destination
+ *         for which isFlatFillable is true.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Destination, typename Scalar, typename AssignOp>
+inline void flatFillRange(Destination const & dest, Scalar const & scalar, AssignOp const & op,
+                          int begin, int end) {
+    typedef typename Destination::Element Element;
+    flatFillLoop(
+        dest.getData(), scalar, begin, end, op,
+        typename boost::mpl::or_< boost::is_same<Scalar,Element>, boost::is_same<AssignOp,Assign> >::type()
+    );
+}
+
+/**
+ *  @internal @brief Attempt to apply a scalar assignment with a single loop over raw pointers.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Returns false (without modifying the destination) if the destination is not dense.
+ */
+template <typename Destination, typename Scalar, typename AssignOp>
+inline bool flatFill(Destination const & dest, Scalar const & scalar, AssignOp const & op) {
+    if (!isFlatFillable(dest)) return false;
+    flatFillRange(dest, scalar, op, 0, dest.getNumElements());
+    return true;
+}
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_Evaluation_h_INCLUDED
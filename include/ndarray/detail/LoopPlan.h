@@ -0,0 +1,195 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_LoopPlan_h_INCLUDED
+#define NDARRAY_DETAIL_LoopPlan_h_INCLUDED
+
+/**
+ * @file ndarray/detail/LoopPlan.h
+ *
+ * @brief Iteration order planning for elementwise operations on arbitrary memory layouts.
+ *
+ * A LoopPlan plays the role of NumPy's nditer: given a shape and the strides of every
+ * operand, it sorts the dimensions by stride, merges adjacent dimensions that every operand
+ * traverses contiguously into one, and splits the result into a single inner loop of maximal
+ * length and an odometer over the remaining outer dimensions.
+ */
+
+#include "ndarray/Vector.h"
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief Return the offset (in elements) of the given index from the start of an array.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <int N>
+inline int computeOffset(Vector<int,N> const & index, Vector<int,N> const & strides) {
+    int offset = 0;
+    for (int n = 0; n < N; ++n) offset += index[n] * strides[n];
+    return offset;
+}
+
+/**
+ *  @internal @brief Stride visitor that sums the magnitudes of each dimension's strides.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <int N>
+struct StrideMagnitude {
+    void operator()(Vector<int,N> const & strides) {
+        for (int n = 0; n < N; ++n) total[n] += (strides[n] < 0) ? -strides[n] : strides[n];
+    }
+
+    Vector<int,N> total;
+};
+
+/**
+ *  @internal @brief Stride visitor that checks whether a dimension continues a block of
+ *         contiguous inner dimensions in every operand.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <int N>
+struct StrideCoalescence {
+    StrideCoalescence(int outer_, int inner_, int size_) :
+        outer(outer_), inner(inner_), size(size_), isContiguous(true) {}
+
+    void operator()(Vector<int,N> const & strides) {
+        if (strides[outer] != strides[inner] * size) isContiguous = false;
+    }
+
+    int outer;
+    int inner;
+    int size;
+    bool isContiguous;
+};
+
+/**
+ *  @internal @brief Stride visitor that checks whether every operand has unit stride in
+ *         a dimension.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <int N>
+struct UnitStride {
+    explicit UnitStride(int axis_) : axis(axis_), isUnit(true) {}
+
+    void operator()(Vector<int,N> const & strides) {
+        if (strides[axis] != 1) isUnit = false;
+    }
+
+    int axis;
+    bool isUnit;
+};
+
+/**
+ *  @internal @brief Loop nest for an elementwise operation over several operands.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  The operands are described by a functor that, called with a stride visitor, calls that
+ *  visitor once with the strides of each operand.  Dimensions are sorted by decreasing total
+ *  stride magnitude (ties keep their original order), so the inner loop runs along the
+ *  dimension that is closest to contiguous in the most operands.  If the order of traversal
+ *  matters, sorting can be disabled, in which case elements are visited in row-major order.
+ *  Dimensions with unit size are dropped.
+ *
+ *  Each step of the inner loop advances every operand by its stride in dimension inner;
+ *  because the merged dimensions are contiguous in every operand, a single loop of length
+ *  innerSize covers all of them.
+ */
+template <int N>
+struct LoopPlan {
+
+    template <typename Operands>
+    LoopPlan(Vector<int,N> const & shape_, Operands const & operands, bool reorder) :
+        shape(shape_), inner(N - 1), innerSize(1), outerCount(0)
+    {
+        int axes[N];
+        for (int n = 0; n < N; ++n) outer[n] = n;
+        int m = 0;
+        for (int n = 0; n < N; ++n) {
+            if (shape[n] == 0) {
+                innerSize = 0;
+                return;
+            }
+            if (shape[n] != 1) axes[m++] = n;
+        }
+        if (m == 0) return;
+        if (reorder) {
+            StrideMagnitude<N> magnitude;
+            operands(magnitude);
+            // insertion sort (stable) by decreasing stride magnitude
+            for (int j = 1; j < m; ++j) {
+                int const n = axes[j];
+                int k = j;
+                for (; k > 0 && magnitude.total[axes[k-1]] < magnitude.total[n]; --k) {
+                    axes[k] = axes[k-1];
+                }
+                axes[k] = n;
+            }
+        }
+        inner = axes[m - 1];
+        innerSize = shape[inner];
+        int k = m - 1;
+        for (; k > 0; --k) {
+            StrideCoalescence<N> coalescence(axes[k-1], inner, innerSize);
+            operands(coalescence);
+            if (!coalescence.isContiguous) break;
+            innerSize *= shape[axes[k-1]];
+        }
+        outerCount = k;
+        for (int j = 0; j < outerCount; ++j) outer[j] = axes[j];
+    }
+
+    /// @brief Return true if every operand has unit stride in the inner loop.
+    template <typename Operands>
+    bool hasUnitStride(Operands const & operands) const {
+        if (innerSize <= 1) return true;
+        UnitStride<N> unit(inner);
+        operands(unit);
+        return unit.isUnit;
+    }
+
+    /**
+     *  @brief Call body(index) for the first element of every inner loop.
+     *
+     *  Outer dimensions are advanced in odometer order, slowest first.
+     */
+    template <typename Body>
+    void execute(Body & body) const {
+        if (innerSize == 0) return;
+        Vector<int,N> index;
+        while (true) {
+            body(index);
+            int k = outerCount - 1;
+            for (; k >= 0; --k) {
+                int const n = outer[k];
+                if (++index[n] < shape[n]) break;
+                index[n] = 0;
+            }
+            if (k < 0) return;
+        }
+    }
+
+    Vector<int,N> shape;
+    int inner;       ///< Dimension along which the inner loop steps.
+    int innerSize;   ///< Number of elements in each inner loop (zero for empty arrays).
+    int outerCount;  ///< Number of dimensions in the outer loop.
+    int outer[N];    ///< Dimensions in the outer loop, slowest first.
+};
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_LoopPlan_h_INCLUDED
@@ -34,6 +34,9 @@ namespace detail {
  *  <b><tt>pointer</tt></b> types associated with the iterator,
  *  not the types themselves.
  *
+ *  As with StridedIterator, iterators are compared by position rather than by address,
+ *  so zero strides are supported.
+ *
  *  @ingroup ndarrayInternalGroup
  */
 template <typename T, int N, int C>
@@ -58,20 +61,24 @@ public:
 
     Reference const * operator->() { return &_ref; }
 
-    NestedIterator() : _ref(Value()), _stride(0) {}
+    NestedIterator() : _ref(Value()), _stride(0), _index(0) {}
 
-    NestedIterator(Reference const & ref, int stride) : _ref(ref), _stride(stride) {}
+    NestedIterator(Reference const & ref, int stride, int index=0) :
+        _ref(ref), _stride(stride), _index(index) {}
 
-    NestedIterator(NestedIterator const & other) : _ref(other._ref), _stride(other._stride) {}
+    NestedIterator(NestedIterator const & other) :
+        _ref(other._ref), _stride(other._stride), _index(other._index) {}
 
     template <typename T_, int C_>
-    NestedIterator(NestedIterator<T_,N,C_> const & other) : _ref(other._ref), _stride(other._stride) {}
+    NestedIterator(NestedIterator<T_,N,C_> const & other) :
+        _ref(other._ref), _stride(other._stride), _index(other._index) {}
 
     NestedIterator & operator=(NestedIterator const & other) {
         if (&other != this) {
             _ref._data = other._ref._data;
             _ref._core = other._ref._core;
             _stride = other._stride;
+            _index = other._index;
         }
         return *this;
     }
@@ -81,6 +88,7 @@ public:
         _ref._data = other._ref._data;
         _ref._core = other._ref._core;
         _stride = other._stride;
+        _index = other._index;
         return *this;
     }
 
@@ -92,22 +100,23 @@ private:
 
     Reference const & dereference() const { return _ref; }
 
-    void increment() { _ref._data += _stride; }
-    void decrement() { _ref._data -= _stride; }
-    void advance(int n) { _ref._data += _stride * n; }
+    void increment() { _ref._data += _stride; ++_index; }
+    void decrement() { _ref._data -= _stride; --_index; }
+    void advance(int n) { _ref._data += _stride * n; _index += n; }
 
     template <typename T_, int C_>
     int distance_to(NestedIterator<T_,N,C_> const & other) const {
-        return std::distance(_ref._data, other._ref._data) / _stride; 
+        return other._index - _index;
     }
 
     template <typename T_, int C_>
     bool equal(NestedIterator<T_,N,C_> const & other) const {
-        return _ref._data == other._ref._data;
+        return _index == other._index;
     }
 
     Reference _ref;
     int _stride;
+    int _index;
 };
 
 } // namespace detail
@@ -0,0 +1,345 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_Packet_h_INCLUDED
+#define NDARRAY_DETAIL_Packet_h_INCLUDED
+
+/**
+ * @file ndarray/detail/Packet.h
+ *
+ * @brief SIMD packet abstraction used by flat expression evaluation.
+ *
+ * The instruction set is chosen at build time from the compiler's target macros:
+ * AVX-512F, then AVX (which includes AVX2 builds), then SSE2.  Defining
+ * NDARRAY_NO_SIMD disables packet evaluation entirely.
+ */
+
+#include <functional>
+#include <boost/mpl/bool.hpp>
+
+#include "ndarray_fwd.h"
+
+#ifndef NDARRAY_NO_SIMD
+#if defined(__AVX512F__)
+#define NDARRAY_SIMD_AVX512F
+#elif defined(__AVX__)
+#define NDARRAY_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NDARRAY_SIMD_SSE2
+#endif
+#endif
+
+#if defined(NDARRAY_SIMD_AVX512F) || defined(NDARRAY_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(NDARRAY_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief A fixed-size group of elements processed by one SIMD instruction.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  The unspecialized template is a scalar "packet" of size one, so code written against
+ *  Packet compiles for any element type; IsVectorized tells callers whether it is worth
+ *  using.  Loads and stores never require alignment.
+ */
+template <typename T>
+struct Packet {
+    typedef boost::mpl::false_ IsVectorized;
+    typedef T Type;
+    static int const size = 1;
+
+    static Type load(T const * p) { return *p; }
+    static void store(T * p, Type a) { *p = a; }
+    static Type set1(T v) { return v; }
+    static Type add(Type a, Type b) { return a + b; }
+    static Type sub(Type a, Type b) { return a - b; }
+    static Type mul(Type a, Type b) { return a * b; }
+    static Type div(Type a, Type b) { return a / b; }
+    static Type negate(Type a) { return -a; }
+};
+
+#if defined(NDARRAY_SIMD_AVX512F)
+
+template <>
+struct Packet<float> {
+    typedef boost::mpl::true_ IsVectorized;
+    typedef __m512 Type;
+    static int const size = 16;
+
+    static Type load(float const * p) { return _mm512_loadu_ps(p); }
+    static void store(float * p, Type a) { _mm512_storeu_ps(p, a); }
+    static Type set1(float v) { return _mm512_set1_ps(v); }
+    static Type add(Type a, Type b) { return _mm512_add_ps(a, b); }
+    static Type sub(Type a, Type b) { return _mm512_sub_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm512_mul_ps(a, b); }
+    static Type div(Type a, Type b) { return _mm512_div_ps(a, b); }
+    static Type negate(Type a) {
+        return _mm512_castsi512_ps(
+            _mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x80000000))
+        );
+    }
+};
+
+template <>
+struct Packet<double> {
+    typedef boost::mpl::true_ IsVectorized;
+    typedef __m512d Type;
+    static int const size = 8;
+
+    static Type load(double const * p) { return _mm512_loadu_pd(p); }
+    static void store(double * p, Type a) { _mm512_storeu_pd(p, a); }
+    static Type set1(double v) { return _mm512_set1_pd(v); }
+    static Type add(Type a, Type b) { return _mm512_add_pd(a, b); }
+    static Type sub(Type a, Type b) { return _mm512_sub_pd(a, b); }
+    static Type mul(Type a, Type b) { return _mm512_mul_pd(a, b); }
+    static Type div(Type a, Type b) { return _mm512_div_pd(a, b); }
+    static Type negate(Type a) {
+        return _mm512_castsi512_pd(
+            _mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(0x8000000000000000LL))
+        );
+    }
+};
+
+#elif defined(NDARRAY_SIMD_AVX)
+
+template <>
+struct Packet<float> {
+    typedef boost::mpl::true_ IsVectorized;
+    typedef __m256 Type;
+    static int const size = 8;
+
+    static Type load(float const * p) { return _mm256_loadu_ps(p); }
+    static void store(float * p, Type a) { _mm256_storeu_ps(p, a); }
+    static Type set1(float v) { return _mm256_set1_ps(v); }
+    static Type add(Type a, Type b) { return _mm256_add_ps(a, b); }
+    static Type sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+    static Type div(Type a, Type b) { return _mm256_div_ps(a, b); }
+    static Type negate(Type a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+};
+
+template <>
+struct Packet<double> {
+    typedef boost::mpl::true_ IsVectorized;
+    typedef __m256d Type;
+    static int const size = 4;
+
+    static Type load(double const * p) { return _mm256_loadu_pd(p); }
+    static void store(double * p, Type a) { _mm256_storeu_pd(p, a); }
+    static Type set1(double v) { return _mm256_set1_pd(v); }
+    static Type add(Type a, Type b) { return _mm256_add_pd(a, b); }
+    static Type sub(Type a, Type b) { return _mm256_sub_pd(a, b); }
+    static Type mul(Type a, Type b) { return _mm256_mul_pd(a, b); }
+    static Type div(Type a, Type b) { return _mm256_div_pd(a, b); }
+    static Type negate(Type a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+};
+
+#elif defined(NDARRAY_SIMD_SSE2)
+
+template <>
+struct Packet<float> {
+    typedef boost::mpl::true_ IsVectorized;
+    typedef __m128 Type;
+    static int const size = 4;
+
+    static Type load(float const * p) { return _mm_loadu_ps(p); }
+    static void store(float * p, Type a) { _mm_storeu_ps(p, a); }
+    static Type set1(float v) { return _mm_set1_ps(v); }
+    static Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+    static Type sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+    static Type div(Type a, Type b) { return _mm_div_ps(a, b); }
+    static Type negate(Type a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+};
+
+template <>
+struct Packet<double> {
+    typedef boost::mpl::true_ IsVectorized;
+    typedef __m128d Type;
+    static int const size = 2;
+
+    static Type load(double const * p) { return _mm_loadu_pd(p); }
+    static void store(double * p, Type a) { _mm_storeu_pd(p, a); }
+    static Type set1(double v) { return _mm_set1_pd(v); }
+    static Type add(Type a, Type b) { return _mm_add_pd(a, b); }
+    static Type sub(Type a, Type b) { return _mm_sub_pd(a, b); }
+    static Type mul(Type a, Type b) { return _mm_mul_pd(a, b); }
+    static Type div(Type a, Type b) { return _mm_div_pd(a, b); }
+    static Type negate(Type a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+};
+
+#endif
+
+/**
+ *  @internal @brief Packet implementation of an elementwise function object.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Specializations exist only for functions whose arguments and result are all T, and that
+ *  give bitwise-identical results to the scalar function; all others are evaluated one
+ *  element at a time.  Specializations provide IsVectorized and a static apply(functor, ...)
+ *  taking and returning Packet<T>::Type.
+ */
+template <typename Function, typename T>
+struct PacketFunction {
+    typedef boost::mpl::false_ IsVectorized;
+};
+
+template <typename T>
+struct PacketFunction<std::negate<T>,T> {
+    typedef typename Packet<T>::IsVectorized IsVectorized;
+    typedef typename Packet<T>::Type Type;
+
+    static Type apply(std::negate<T> const &, Type a) { return Packet<T>::negate(a); }
+};
+
+/**
+ *  @internal @brief An in-register transpose of a small square block.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  apply(src, srcStride, dst, dstStride) sets dst[j*dstStride + i] = src[i*srcStride + j] for
+ *  i, j in [0, size), where the rows of both blocks are contiguous.  The unspecialized template
+ *  is not vectorized and must not be used.
+ */
+template <typename T>
+struct PacketTranspose {
+    typedef boost::mpl::false_ IsVectorized;
+    static int const size = 1;
+};
+
+#if defined(NDARRAY_SIMD_AVX512F) || defined(NDARRAY_SIMD_AVX)
+
+// AVX-512 builds use the AVX kernels; wider blocks do not fit in a tile's cache lines.
+
+template <>
+struct PacketTranspose<float> {
+    typedef boost::mpl::true_ IsVectorized;
+    static int const size = 8;
+
+    static void apply(float const * src, int srcStride, float * dst, int dstStride) {
+        __m256 r0 = _mm256_loadu_ps(src);
+        __m256 r1 = _mm256_loadu_ps(src + srcStride);
+        __m256 r2 = _mm256_loadu_ps(src + 2*srcStride);
+        __m256 r3 = _mm256_loadu_ps(src + 3*srcStride);
+        __m256 r4 = _mm256_loadu_ps(src + 4*srcStride);
+        __m256 r5 = _mm256_loadu_ps(src + 5*srcStride);
+        __m256 r6 = _mm256_loadu_ps(src + 6*srcStride);
+        __m256 r7 = _mm256_loadu_ps(src + 7*srcStride);
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+        __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+        __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+        __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+        r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1,0,1,0));
+        r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3,2,3,2));
+        r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1,0,1,0));
+        r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3,2,3,2));
+        r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1,0,1,0));
+        r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3,2,3,2));
+        r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1,0,1,0));
+        r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3,2,3,2));
+        _mm256_storeu_ps(dst, _mm256_permute2f128_ps(r0, r4, 0x20));
+        _mm256_storeu_ps(dst + dstStride, _mm256_permute2f128_ps(r1, r5, 0x20));
+        _mm256_storeu_ps(dst + 2*dstStride, _mm256_permute2f128_ps(r2, r6, 0x20));
+        _mm256_storeu_ps(dst + 3*dstStride, _mm256_permute2f128_ps(r3, r7, 0x20));
+        _mm256_storeu_ps(dst + 4*dstStride, _mm256_permute2f128_ps(r0, r4, 0x31));
+        _mm256_storeu_ps(dst + 5*dstStride, _mm256_permute2f128_ps(r1, r5, 0x31));
+        _mm256_storeu_ps(dst + 6*dstStride, _mm256_permute2f128_ps(r2, r6, 0x31));
+        _mm256_storeu_ps(dst + 7*dstStride, _mm256_permute2f128_ps(r3, r7, 0x31));
+    }
+};
+
+template <>
+struct PacketTranspose<double> {
+    typedef boost::mpl::true_ IsVectorized;
+    static int const size = 4;
+
+    static void apply(double const * src, int srcStride, double * dst, int dstStride) {
+        __m256d r0 = _mm256_loadu_pd(src);
+        __m256d r1 = _mm256_loadu_pd(src + srcStride);
+        __m256d r2 = _mm256_loadu_pd(src + 2*srcStride);
+        __m256d r3 = _mm256_loadu_pd(src + 3*srcStride);
+        __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+        __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+        __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+        __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(dst + dstStride, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(dst + 2*dstStride, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(dst + 3*dstStride, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
+
+#elif defined(NDARRAY_SIMD_SSE2)
+
+template <>
+struct PacketTranspose<float> {
+    typedef boost::mpl::true_ IsVectorized;
+    static int const size = 4;
+
+    static void apply(float const * src, int srcStride, float * dst, int dstStride) {
+        __m128 r0 = _mm_loadu_ps(src);
+        __m128 r1 = _mm_loadu_ps(src + srcStride);
+        __m128 r2 = _mm_loadu_ps(src + 2*srcStride);
+        __m128 r3 = _mm_loadu_ps(src + 3*srcStride);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(dst, r0);
+        _mm_storeu_ps(dst + dstStride, r1);
+        _mm_storeu_ps(dst + 2*dstStride, r2);
+        _mm_storeu_ps(dst + 3*dstStride, r3);
+    }
+};
+
+template <>
+struct PacketTranspose<double> {
+    typedef boost::mpl::true_ IsVectorized;
+    static int const size = 4;
+
+    // four 2x2 transposes, one per pair of SSE2 registers
+    static void apply(double const * src, int srcStride, double * dst, int dstStride) {
+        for (int i = 0; i < 4; i += 2) {
+            for (int j = 0; j < 4; j += 2) {
+                __m128d a = _mm_loadu_pd(src + i*srcStride + j);
+                __m128d b = _mm_loadu_pd(src + (i+1)*srcStride + j);
+                _mm_storeu_pd(dst + j*dstStride + i, _mm_unpacklo_pd(a, b));
+                _mm_storeu_pd(dst + (j+1)*dstStride + i, _mm_unpackhi_pd(a, b));
+            }
+        }
+    }
+};
+
+#endif
+
+/**
+ *  @internal @brief Packet implementation of an assignment function object.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Specializations (in ArrayRef.h) provide IsVectorized and a static apply(T * p, Packet<T>::Type)
+ *  that performs the assignment on the packet starting at p.
+ */
+template <typename AssignOp, typename T>
+struct PacketAssign {
+    typedef boost::mpl::false_ IsVectorized;
+};
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_Packet_h_INCLUDED
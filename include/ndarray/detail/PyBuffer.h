@@ -0,0 +1,481 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_PyBuffer_h_INCLUDED
+#define NDARRAY_DETAIL_PyBuffer_h_INCLUDED
+
+/**
+ *  @file ndarray/detail/PyBuffer.h
+ *  @brief Python buffer protocol (PEP 3118) export and import for Array, shared by the
+ *         SWIG and Boost.Python bindings.
+ *
+ *  Arrays are exported as instances of a small Python type, ndarray.Buffer, that holds the
+ *  Array's Manager and describes its shape, strides and element format; memoryview,
+ *  numpy.asarray and other buffer consumers can then use the memory without numpy's C API.
+ *  Any object that exports a strided buffer with a compatible element format can be
+ *  imported without copying; the Py_buffer is released when the last Array using it is
+ *  destroyed.  Imports first create an ndarray.Buffer holding the validated Py_buffer, so
+ *  the two stages of a conversion only request the buffer once.
+ *
+ *  \note This file is not included by the main "ndarray.h" header file, and requires
+ *  "Python.h" (but not numpy).
+ */
+
+#include "Python.h"
+
+#include <cstring>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+#include "ndarray.h"
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Kinds of buffer element formats that can be mapped to C++ types.
+ */
+enum PyBufferKind {
+    PYBUFFER_UNKNOWN = 0,
+    PYBUFFER_BOOL,
+    PYBUFFER_SIGNED,
+    PYBUFFER_UNSIGNED,
+    PYBUFFER_FLOAT,
+    PYBUFFER_COMPLEX
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Traits class that maps a numeric type to a buffer format kind.
+ */
+template <typename T>
+struct PyBufferTraits {
+    static PyBufferKind getKind() {
+        if (boost::is_same<T,bool>::value) return PYBUFFER_BOOL;
+        if (boost::is_floating_point<T>::value) return PYBUFFER_FLOAT;
+        if (boost::is_integral<T>::value) {
+            return boost::is_signed<T>::value ? PYBUFFER_SIGNED : PYBUFFER_UNSIGNED;
+        }
+        return PYBUFFER_UNKNOWN;
+    }
+};
+
+template <typename U>
+struct PyBufferTraits< std::complex<U> > {
+    static PyBufferKind getKind() { return PYBUFFER_COMPLEX; }
+};
+
+/// @internal @brief Return true if this machine stores integers little-endian.
+inline bool isLittleEndian() {
+    int const one = 1;
+    return *reinterpret_cast<char const *>(&one) == 1;
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Return the kind of a struct-module format string with a single element, or
+ *         PYBUFFER_UNKNOWN if it has a non-native byte order or is not a simple number.
+ *
+ *  Sizes are not checked here; formats of a given kind are compatible with any C++ type of
+ *  that kind and the buffer's item size.
+ */
+inline PyBufferKind getPyBufferKind(char const * format) {
+    if (format == NULL) return PYBUFFER_UNSIGNED; // unformatted bytes
+    switch (*format) {
+    case '@':
+    case '=':
+        ++format;
+        break;
+    case '<':
+        if (!isLittleEndian()) return PYBUFFER_UNKNOWN;
+        ++format;
+        break;
+    case '>':
+    case '!':
+        if (isLittleEndian()) return PYBUFFER_UNKNOWN;
+        ++format;
+        break;
+    }
+    if (format[0] == 'Z') {
+        if (format[1] == 0 || format[2] != 0) return PYBUFFER_UNKNOWN;
+        return std::strchr("fdg", format[1]) ? PYBUFFER_COMPLEX : PYBUFFER_UNKNOWN;
+    }
+    if (format[0] == 0 || format[1] != 0) return PYBUFFER_UNKNOWN;
+    if (format[0] == '?') return PYBUFFER_BOOL;
+    if (std::strchr("bhilqn", format[0])) return PYBUFFER_SIGNED;
+    if (std::strchr("BHILQN", format[0])) return PYBUFFER_UNSIGNED;
+    if (std::strchr("efdg", format[0])) return PYBUFFER_FLOAT;
+    return PYBUFFER_UNKNOWN;
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Return the struct-module format string for elements of the given kind and size.
+ */
+inline char const * getPyBufferFormat(PyBufferKind kind, int size) {
+    switch (kind) {
+    case PYBUFFER_BOOL:
+        return "?";
+    case PYBUFFER_SIGNED:
+        return (size == 1) ? "b" : (size == 2) ? "h" : (size == 4) ? "i" : "q";
+    case PYBUFFER_UNSIGNED:
+        return (size == 1) ? "B" : (size == 2) ? "H" : (size == 4) ? "I" : "Q";
+    case PYBUFFER_FLOAT:
+        return (size == 4) ? "f" : (size == 8) ? "d" : "g";
+    case PYBUFFER_COMPLEX:
+        return (size == 8) ? "Zf" : (size == 16) ? "Zd" : "Zg";
+    default:
+        return "B";
+    }
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Owner of a Py_buffer, for use with ExternalManager.
+ *
+ *  The buffer is released (with the GIL held) when the last copy is destroyed, so Arrays
+ *  that use it can be destroyed from any thread.  Buffers still held after the interpreter
+ *  has been finalized are leaked, as their exporters are gone.
+ */
+class PyBufferOwner {
+public:
+
+    /// @brief Take ownership of a heap-allocated, filled-in Py_buffer.
+    explicit PyBufferOwner(Py_buffer * view) : _view(view, &release) {}
+
+    Py_buffer const & getView() const { return *_view; }
+
+private:
+
+    static void release(Py_buffer * view) {
+        if (!Py_IsInitialized()) return;
+        PyGILState_STATE state = PyGILState_Ensure();
+        PyBuffer_Release(view);
+        PyGILState_Release(state);
+        delete view;
+    }
+
+    boost::shared_ptr<Py_buffer> _view;
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Instance layout of the ndarray.Buffer Python type.
+ *
+ *  All members are set by makePyBufferObject(); shape and strides (in bytes) share one
+ *  allocation.
+ */
+struct PyBufferObject {
+    PyObject_HEAD
+    Manager::Ptr * manager;
+    char * data;
+    int ndim;
+    Py_ssize_t * shape;
+    Py_ssize_t * strides;
+    Py_ssize_t itemsize;
+    char const * format;
+    int readonly;
+};
+
+inline void destroyPyBufferObject(PyObject * self) {
+    PyBufferObject * b = reinterpret_cast<PyBufferObject *>(self);
+    delete b->manager;
+    delete [] b->shape;
+    PyObject_Del(self);
+}
+
+/// @internal @brief Return true if the given layout is row-major (or column-major) contiguous.
+inline bool isPyBufferContiguous(PyBufferObject const * b, bool columnMajor=false) {
+    Py_ssize_t expected = b->itemsize;
+    for (int i = 0; i < b->ndim; ++i) {
+        int const n = columnMajor ? i : b->ndim - i - 1;
+        if (b->shape[n] != 1 && b->strides[n] != expected) return false;
+        expected *= b->shape[n];
+    }
+    return true;
+}
+
+inline int getPyBufferObjectBuffer(PyObject * self, Py_buffer * view, int flags) {
+    PyBufferObject * b = reinterpret_cast<PyBufferObject *>(self);
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && b->readonly) {
+        PyErr_SetString(PyExc_BufferError, "ndarray buffer is read-only");
+        return -1;
+    }
+    bool const strided = (flags & PyBUF_STRIDES) == PyBUF_STRIDES;
+    bool contiguous = true;
+    if ((flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS) {
+        contiguous = isPyBufferContiguous(b) || isPyBufferContiguous(b, true);
+    } else if ((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS) {
+        contiguous = isPyBufferContiguous(b, true);
+    } else if ((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS || !strided) {
+        contiguous = isPyBufferContiguous(b);
+    }
+    if (!contiguous) {
+        PyErr_SetString(PyExc_BufferError, "ndarray buffer does not have the requested contiguity");
+        return -1;
+    }
+    Py_ssize_t len = b->itemsize;
+    for (int n = 0; n < b->ndim; ++n) len *= b->shape[n];
+    view->buf = b->data;
+    view->obj = self;
+    Py_INCREF(self);
+    view->len = len;
+    view->readonly = b->readonly;
+    view->itemsize = b->itemsize;
+    view->format = ((flags & PyBUF_FORMAT) == PyBUF_FORMAT) ? const_cast<char *>(b->format) : NULL;
+    view->ndim = b->ndim;
+    view->shape = ((flags & PyBUF_ND) == PyBUF_ND) ? b->shape : NULL;
+    view->strides = strided ? b->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Return the ndarray.Buffer Python type, initializing it on first use.
+ *
+ *  \return the type object (a borrowed reference), or NULL with a Python exception set.
+ */
+inline PyTypeObject * getPyBufferType() {
+    static PyTypeObject type;
+    static PyBufferProcs procs;
+    static bool ready = false;
+    if (!ready) {
+        reinterpret_cast<PyObject *>(&type)->ob_refcnt = 1;
+        type.tp_name = "ndarray.Buffer";
+        type.tp_basicsize = sizeof(PyBufferObject);
+        type.tp_dealloc = &destroyPyBufferObject;
+        type.tp_flags = Py_TPFLAGS_DEFAULT;
+#if PY_MAJOR_VERSION == 2
+        type.tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+        type.tp_doc = "Memory owned by a C++ ndarray::Array, exported with the buffer protocol.";
+        procs.bf_getbuffer = &getPyBufferObjectBuffer;
+        type.tp_as_buffer = &procs;
+        if (PyType_Ready(&type) < 0) return NULL;
+        ready = true;
+    }
+    return &type;
+}
+
+/// @internal @brief Return true if the given object is an ndarray.Buffer.
+inline bool isPyBufferObject(PyObject * obj) {
+    PyTypeObject * type = getPyBufferType();
+    if (type == NULL) {
+        PyErr_Clear();
+        return false;
+    }
+    return PyObject_TypeCheck(obj, type);
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Create an ndarray.Buffer for memory held by the given Manager.
+ *
+ *  Strides are in elements.  \return a new reference, or NULL with a Python exception set.
+ */
+template <int N>
+inline PyObject * makePyBufferObject(
+    Manager::Ptr const & manager, void * data,
+    Vector<int,N> const & shape, Vector<int,N> const & strides,
+    int itemsize, char const * format, bool readonly
+) {
+    PyTypeObject * type = getPyBufferType();
+    if (type == NULL) return NULL;
+    PyBufferObject * b = PyObject_New(PyBufferObject, type);
+    if (b == NULL) return NULL;
+    b->manager = new Manager::Ptr(manager);
+    b->data = reinterpret_cast<char *>(data);
+    b->ndim = N;
+    b->shape = new Py_ssize_t[2 * N];
+    b->strides = b->shape + N;
+    for (int n = 0; n < N; ++n) {
+        b->shape[n] = shape[n];
+        b->strides[n] = Py_ssize_t(strides[n]) * itemsize;
+    }
+    b->itemsize = itemsize;
+    b->format = format;
+    b->readonly = readonly;
+    return reinterpret_cast<PyObject *>(b);
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Check that memory with the given byte strides can be viewed as an Array<T,N,C>.
+ *
+ *  The number of dimensions and element type must already have been checked.
+ *
+ *  \return true on success, or false with a Python exception set.
+ */
+template <typename T, int N, int C>
+bool checkPyBufferLayout(void const * buf, Py_ssize_t const * shape, Py_ssize_t const * strides) {
+    typedef typename boost::remove_const<T>::type U;
+    int const itemsize = sizeof(T);
+    if (reinterpret_cast<std::size_t>(buf) % boost::alignment_of<U>::value != 0) {
+        PyErr_SetString(PyExc_ValueError, "unaligned buffers cannot be converted to C++");
+        return false;
+    }
+    for (int n = 0; n < N; ++n) {
+        if (strides[n] % itemsize != 0) {
+            PyErr_SetString(PyExc_ValueError, "buffer strides are not a multiple of the item size");
+            return false;
+        }
+    }
+    if (C > 0) {
+        Py_ssize_t requiredStride = itemsize;
+        for (int i = 0; i < C; ++i) {
+            if (strides[N-i-1] != requiredStride) {
+                PyErr_SetString(PyExc_ValueError,
+                                "buffer does not have enough row-major contiguous dimensions");
+                return false;
+            }
+            requiredStride *= shape[N-i-1];
+        }
+    } else if (C < 0) {
+        Py_ssize_t requiredStride = itemsize;
+        for (int i = 0; i < -C; ++i) {
+            if (strides[i] != requiredStride) {
+                PyErr_SetString(PyExc_ValueError,
+                                "buffer does not have enough column-major contiguous dimensions");
+                return false;
+            }
+            requiredStride *= shape[i];
+        }
+    }
+    return true;
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Check that a buffer can be viewed as an Array<T,N,C>.
+ *
+ *  \return true on success, or false with a Python exception set.
+ */
+template <typename T, int N, int C>
+bool checkPyBuffer(Py_buffer const & view) {
+    typedef typename boost::remove_const<T>::type U;
+    if (view.ndim != N) {
+        PyErr_SetString(PyExc_ValueError, "buffer has incorrect number of dimensions");
+        return false;
+    }
+    if (view.itemsize != Py_ssize_t(sizeof(T))
+        || getPyBufferKind(view.format) != PyBufferTraits<U>::getKind()) {
+        PyErr_SetString(PyExc_ValueError, "buffer has incorrect data type");
+        return false;
+    }
+    return checkPyBufferLayout<T,N,C>(view.buf, view.shape, view.strides);
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Check that an ndarray.Buffer can be converted to an Array<T,N,C>.
+ *
+ *  \return true on success, or false with a Python exception set.
+ */
+template <typename T, int N, int C>
+bool checkPyBufferObject(PyObject * obj) {
+    PyBufferObject const * b = reinterpret_cast<PyBufferObject const *>(obj);
+    typedef typename boost::remove_const<T>::type U;
+    if (b->ndim != N || b->itemsize != Py_ssize_t(sizeof(T))
+        || std::strcmp(b->format, getPyBufferFormat(PyBufferTraits<U>::getKind(), sizeof(T))) != 0
+        || (b->readonly && !boost::is_const<T>::value)) {
+        PyErr_SetString(PyExc_ValueError, "ndarray.Buffer has incorrect type");
+        return false;
+    }
+    return checkPyBufferLayout<T,N,C>(b->data, b->shape, b->strides);
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Request a buffer from a Python object and check that it can be viewed as an
+ *         Array<T,N,C>.
+ *
+ *  \return a new ndarray.Buffer that holds the Py_buffer, or NULL with a Python exception set.
+ */
+template <typename T, int N, int C>
+PyObject * importPyBuffer(PyObject * obj) {
+    bool const writeable = !boost::is_const<T>::value;
+    Py_buffer * view = new Py_buffer();
+    int flags = PyBUF_STRIDES | PyBUF_FORMAT;
+    if (writeable) flags |= PyBUF_WRITABLE;
+    if (PyObject_GetBuffer(obj, view, flags) < 0) {
+        delete view;
+        return NULL;
+    }
+    PyBufferOwner owner(view);
+    if (!checkPyBuffer<T,N,C>(*view)) return NULL;
+    Vector<int,N> shape;
+    Vector<int,N> strides;
+    for (int n = 0; n < N; ++n) {
+        shape[n] = view->shape[n];
+        strides[n] = view->strides[n] / Py_ssize_t(sizeof(T));
+    }
+    typedef typename boost::remove_const<T>::type U;
+    return makePyBufferObject(
+        makeManager(owner), view->buf, shape, strides, sizeof(T),
+        getPyBufferFormat(PyBufferTraits<U>::getKind(), sizeof(T)), !writeable
+    );
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Construct an Array from an ndarray.Buffer created by importPyBuffer or exportPyBuffer.
+ *
+ *  \return true on success, or false with a Python exception set.
+ */
+template <typename T, int N, int C>
+bool extractPyBuffer(PyObject * obj, Array<T,N,C> & output) {
+    if (!checkPyBufferObject<T,N,C>(obj)) return false;
+    PyBufferObject const * b = reinterpret_cast<PyBufferObject const *>(obj);
+    Vector<int,N> shape;
+    Vector<int,N> strides;
+    for (int n = 0; n < N; ++n) {
+        shape[n] = b->shape[n];
+        strides[n] = b->strides[n] / b->itemsize;
+    }
+    output = external(reinterpret_cast<T *>(b->data), shape, strides, *b->manager);
+    return true;
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Create an ndarray.Buffer that exports the memory of an Array.
+ *
+ *  Arrays without a Manager are copied first.
+ *
+ *  \return a new reference, or NULL with a Python exception set.
+ */
+template <typename T, int N, int C>
+PyObject * exportPyBuffer(Array<T,N,C> const & array) {
+    typedef typename boost::remove_const<T>::type U;
+    if (!array.getManager()) {
+        return exportPyBuffer(Array<T,N,N>(copy(array)));
+    }
+    return makePyBufferObject(
+        array.getManager(), const_cast<U *>(array.getData()), array.getShape(), array.getStrides(),
+        sizeof(T), getPyBufferFormat(PyBufferTraits<U>::getKind(), sizeof(T)),
+        boost::is_const<T>::value
+    );
+}
+
+} // namespace ndarray::detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_PyBuffer_h_INCLUDED
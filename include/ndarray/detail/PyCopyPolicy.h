@@ -0,0 +1,297 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_PyCopyPolicy_h_INCLUDED
+#define NDARRAY_DETAIL_PyCopyPolicy_h_INCLUDED
+
+/**
+ *  @file ndarray/detail/PyCopyPolicy.h
+ *  @brief Opt-in contiguous-copy fallback for Python to Array conversions, shared by the
+ *         SWIG and Boost.Python bindings.
+ *
+ *  \note This file is not included by the main "ndarray.h" header file, and requires
+ *  "Python.h" (but not numpy).
+ */
+
+#include "Python.h"
+
+#include <cstring>
+#include <vector>
+
+#include "ndarray.h"
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Pool of aligned memory blocks for converter copies.
+ *
+ *  Blocks are rounded up to a power of two, and a few freed blocks of each size are kept for
+ *  reuse; blocks larger than the largest size class are allocated and freed directly.  The
+ *  pool is only used with the GIL held.
+ */
+class PyCopyPool {
+public:
+
+    static std::size_t const ALIGNMENT = 64;
+
+    static int const MIN_CLASS = 6;    ///< Smallest block is 2^MIN_CLASS bytes.
+    static int const MAX_CLASS = 24;   ///< Largest pooled block is 2^MAX_CLASS bytes.
+    static std::size_t const MAX_FREE = 4;  ///< Freed blocks kept for each size class.
+
+    /// @brief Return the pool shared by all extension modules (see getPyCopyState()).
+    static PyCopyPool & get();
+
+    /// @brief Return a block of at least the given size, and set its size class.
+    void * acquire(std::size_t bytes, int & sizeClass) {
+        sizeClass = MIN_CLASS;
+        while (sizeClass <= MAX_CLASS && (std::size_t(1) << sizeClass) < bytes) ++sizeClass;
+        if (sizeClass > MAX_CLASS) return alignedAllocate(bytes, ALIGNMENT);
+        std::vector<void*> & free = _free[sizeClass - MIN_CLASS];
+        if (!free.empty()) {
+            void * p = free.back();
+            free.pop_back();
+            return p;
+        }
+        return alignedAllocate(std::size_t(1) << sizeClass, ALIGNMENT);
+    }
+
+    /// @brief Return a block obtained from acquire() to the pool.
+    void release(void * p, int sizeClass) {
+        if (sizeClass <= MAX_CLASS) {
+            std::vector<void*> & free = _free[sizeClass - MIN_CLASS];
+            if (free.size() < MAX_FREE) {
+                free.push_back(p);
+                return;
+            }
+        }
+        alignedFree(p);
+    }
+
+private:
+    std::vector<void*> _free[MAX_CLASS - MIN_CLASS + 1];
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief State of PyCopyPolicy and the PyCopyPool.
+ */
+struct PyCopyState {
+    PyCopyState() : enabled(false), hook(NULL), count(0), bytes(0) {}
+
+    bool enabled;
+    void (*hook)(PyObject *, std::size_t);
+    std::size_t count;
+    std::size_t bytes;
+    PyCopyPool pool;
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Return the PyCopyState shared by all extension modules in the process.
+ *
+ *  Each module built with these headers has its own copies of their function-local
+ *  statics, so the state is created by the first module that needs it, and published to
+ *  the others through a capsule stored as an attribute of the sys module.  The name includes
+ *  a layout version, to be incremented whenever PyCopyState changes.  The state is never
+ *  destroyed, as copies may outlive the interpreter.  Must be called with the GIL held.
+ */
+inline PyCopyState & getPyCopyState() {
+    static PyCopyState * state = NULL;
+    if (state != NULL) return *state;
+    static char name[] = "_ndarray_copy_state_v1";
+    PyObject * existing = PySys_GetObject(name); // borrowed
+    if (existing != NULL) {
+#if PY_MAJOR_VERSION == 2
+        if (PyCObject_Check(existing)) {
+            state = reinterpret_cast<PyCopyState *>(PyCObject_AsVoidPtr(existing));
+        }
+#else
+        state = reinterpret_cast<PyCopyState *>(PyCapsule_GetPointer(existing, name));
+#endif
+        PyErr_Clear();
+        if (state != NULL) return *state;
+    }
+    state = new PyCopyState();
+#if PY_MAJOR_VERSION == 2
+    PyObject * capsule = PyCObject_FromVoidPtr(state, NULL);
+#else
+    PyObject * capsule = PyCapsule_New(state, name, NULL);
+#endif
+    if (capsule == NULL || PySys_SetObject(name, capsule) < 0) {
+        PyErr_Clear(); // this module still works, but with its own state
+    }
+    Py_XDECREF(capsule);
+    return *state;
+}
+
+inline PyCopyPool & PyCopyPool::get() { return getPyCopyState().pool; }
+
+} // namespace ndarray::detail
+
+/**
+ *  @ingroup ndarrayPythonGroup
+ *  @brief Process-wide policy for converting numpy arrays whose strides don't match the
+ *         required Array type.
+ *
+ *  By default, converting an array that is unaligned or doesn't have enough contiguous
+ *  dimensions fails.  When copies are enabled, conversions to Arrays with const elements
+ *  instead make a single aligned, contiguous copy (in memory reused from earlier copies when
+ *  possible) and convert that.  Conversions to Arrays with non-const elements never copy,
+ *  because changes to the copy would not be visible in Python.
+ *
+ *  Every copy is counted, and reported to an optional hook, so that hidden copies can be
+ *  found.  Converters only copy with the GIL held, which serializes access to the counters.
+ *
+ *  The policy, counters and hook are shared by all extension modules that use ndarray's
+ *  converters, whichever module sets them.
+ */
+class PyCopyPolicy {
+public:
+
+    /// @brief Function called after each copy with the object copied and the size of the copy.
+    typedef void (*Hook)(PyObject * source, std::size_t bytes);
+
+    /// @brief Enable or disable contiguous-copy fallbacks in converters.
+    static void setEnabled(bool enabled) { detail::getPyCopyState().enabled = enabled; }
+
+    static bool isEnabled() { return detail::getPyCopyState().enabled; }
+
+    /// @brief Set the function to call after each copy (NULL to disable).
+    static void setHook(Hook hook) { detail::getPyCopyState().hook = hook; }
+
+    static Hook getHook() { return detail::getPyCopyState().hook; }
+
+    /// @brief Return the number of copies made by converters.
+    static std::size_t getCopyCount() { return detail::getPyCopyState().count; }
+
+    /// @brief Return the total number of bytes copied by converters.
+    static std::size_t getBytesCopied() { return detail::getPyCopyState().bytes; }
+
+    static void resetCounters() {
+        detail::PyCopyState & state = detail::getPyCopyState();
+        state.count = 0;
+        state.bytes = 0;
+    }
+
+    /// @internal @brief Record a copy made by a converter.
+    static void record(PyObject * source, std::size_t bytes) {
+        detail::PyCopyState & state = detail::getPyCopyState();
+        ++state.count;
+        state.bytes += bytes;
+        if (state.hook) state.hook(source, bytes);
+    }
+
+};
+
+namespace detail {
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief A Manager for a block from the PyCopyPool.
+ *
+ *  The block is returned to the pool (with the GIL held) when the manager is destroyed, so
+ *  Arrays that use it can be destroyed from any thread.
+ */
+class PyCopyManager : public Manager {
+public:
+
+    static std::pair<Manager::Ptr,void*> allocate(std::size_t bytes) {
+        boost::intrusive_ptr<PyCopyManager> r(new PyCopyManager(bytes));
+        return std::pair<Manager::Ptr,void*>(r, r->_p);
+    }
+
+    virtual bool isUnique() const { return true; }
+
+    virtual int getAlignment() const { return PyCopyPool::ALIGNMENT; }
+
+    virtual ~PyCopyManager() {
+        if (!Py_IsInitialized()) {
+            alignedFree(_p);
+            return;
+        }
+        PyGILState_STATE state = PyGILState_Ensure();
+        PyCopyPool::get().release(_p, _sizeClass);
+        PyGILState_Release(state);
+    }
+
+private:
+
+    explicit PyCopyManager(std::size_t bytes) : _sizeClass(0), _p(PyCopyPool::get().acquire(bytes, _sizeClass)) {}
+
+    int _sizeClass;
+    void * _p;
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Copy strided (and possibly unaligned) memory into a new contiguous Array.
+ *
+ *  The copy is row-major, or column-major if C is negative.  Strides are in bytes.  The copy
+ *  is recorded with PyCopyPolicy.
+ */
+template <typename T, int N, int C>
+Array<T,N,C> copyToContiguous(
+    PyObject * source, void const * data, Py_intptr_t const * shape, Py_intptr_t const * strides
+) {
+    // Copy in row-major order over the dimensions as they will be laid out in the output.
+    Py_intptr_t inShape[N];
+    Py_intptr_t inStrides[N];
+    std::size_t count = 1;
+    for (int i = 0; i < N; ++i) {
+        int const n = (C < 0) ? N - i - 1 : i;
+        inShape[i] = shape[n];
+        inStrides[i] = strides[n];
+        count *= shape[n];
+    }
+    std::size_t const bytes = count * sizeof(T);
+    std::pair<Manager::Ptr,void*> block = PyCopyManager::allocate(bytes);
+    if (count > 0) {
+        char const * in = static_cast<char const *>(data);
+        char * out = static_cast<char *>(block.second);
+        std::size_t const rowBytes = inShape[N-1] * sizeof(T);
+        Py_intptr_t index[N] = { 0 };
+        while (true) {
+            char const * row = in;
+            for (int i = 0; i < N - 1; ++i) row += index[i] * inStrides[i];
+            if (inStrides[N-1] == Py_intptr_t(sizeof(T))) {
+                std::memcpy(out, row, rowBytes);
+                out += rowBytes;
+            } else {
+                for (Py_intptr_t j = 0; j < inShape[N-1]; ++j, out += sizeof(T)) {
+                    std::memcpy(out, row + j * inStrides[N-1], sizeof(T));
+                }
+            }
+            int i = N - 2;
+            for (; i >= 0; --i) {
+                if (++index[i] < inShape[i]) break;
+                index[i] = 0;
+            }
+            if (i < 0) break;
+        }
+    }
+    PyCopyPolicy::record(source, bytes);
+    Vector<int,N> outShape;
+    Vector<int,N> outStrides;
+    int stride = 1;
+    for (int i = N - 1; i >= 0; --i) {
+        int const n = (C < 0) ? N - i - 1 : i;
+        outShape[n] = inShape[i];
+        outStrides[n] = stride;
+        stride *= inShape[i];
+    }
+    return external(static_cast<T*>(block.second), outShape, outStrides, block.first);
+}
+
+} // namespace ndarray::detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_PyCopyPolicy_h_INCLUDED
@@ -27,6 +27,9 @@ namespace detail {
  *  @internal @brief Strided iterator for noncontiguous 1D arrays.
  *
  *  @ingroup ndarrayInternalGroup
+ *
+ *  Iterators are compared by position rather than by address, so a zero stride (as in a
+ *  broadcast view) still gives a range of the right length.
  */
 template <typename T>
 class StridedIterator : public boost::iterator_facade<
@@ -38,14 +41,17 @@ public:
     typedef T Value;
     typedef T & Reference;
     
-    StridedIterator() : _data(0), _stride(0) {}
+    StridedIterator() : _data(0), _stride(0), _index(0) {}
 
-    StridedIterator(T * data, int stride) : _data(data), _stride(stride) {}
+    StridedIterator(T * data, int stride, int index=0) : _data(data), _stride(stride), _index(index) {}
 
-    StridedIterator(StridedIterator const & other) : _data(other._data), _stride(other._stride) {}
+    StridedIterator(StridedIterator const & other) :
+        _data(other._data), _stride(other._stride), _index(other._index) {}
 
     template <typename U>
-    StridedIterator(StridedIterator<U> const & other) : _data(other._data), _stride(other._stride) {
+    StridedIterator(StridedIterator<U> const & other) :
+        _data(other._data), _stride(other._stride), _index(other._index)
+    {
         BOOST_STATIC_ASSERT((boost::is_convertible<U*,T*>::value));
     }
 
@@ -53,6 +59,7 @@ public:
         if (&other != this) {
             _data = other._data;
             _stride = other._stride;
+            _index = other._index;
         }
         return *this;
     }
@@ -62,6 +69,7 @@ public:
         BOOST_STATIC_ASSERT((boost::is_convertible<U*,T*>::value));
         _data = other._data;
         _stride = other._stride;
+        _index = other._index;
         return *this;
     }
 
@@ -73,22 +81,23 @@ private:
 
     Reference dereference() const { return *_data; }
 
-    void increment() { _data += _stride; }
-    void decrement() { _data -= _stride; }
-    void advance(int n) { _data += _stride * n; }
+    void increment() { _data += _stride; ++_index; }
+    void decrement() { _data -= _stride; --_index; }
+    void advance(int n) { _data += _stride * n; _index += n; }
 
     template <typename U>
     int distance_to(StridedIterator<U> const & other) const {
-        return std::distance(_data, other._data) / _stride; 
+        return other._index - _index;
     }
 
     template <typename U>
     bool equal(StridedIterator<U> const & other) const {
-        return _data == other._data;
+        return _index == other._index;
     }
 
     T * _data;
     int _stride;
+    int _index;
 
 };
 
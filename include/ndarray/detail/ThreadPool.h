@@ -0,0 +1,154 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_DETAIL_ThreadPool_h_INCLUDED
+#define NDARRAY_DETAIL_ThreadPool_h_INCLUDED
+
+/**
+ * @file ndarray/detail/ThreadPool.h
+ *
+ * @brief A minimal process-wide thread pool for parallel evaluation.
+ *
+ * Requires linking against Boost.Thread.
+ */
+
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/once.hpp>
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief A process-wide pool of worker threads.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Worker threads are started on demand and live until the process exits.  Only one batch of
+ *  tasks runs on the pool at a time; a batch submitted while another is running (including
+ *  one submitted from inside a task) is simply run serially by the submitting thread.
+ */
+class ThreadPool : private boost::noncopyable {
+public:
+
+    /**
+     *  @brief Call task(i) for every i in [0, nTasks), using up to nThreads threads
+     *         (including the calling thread), and return when all calls have completed.
+     *
+     *  Tasks must not throw.
+     */
+    static void run(int nThreads, int nTasks, boost::function<void(int)> const & task) {
+        if (nThreads > 1 && nTasks > 1) {
+            ThreadPool & pool = getInstance();
+            boost::unique_lock<boost::mutex> busy(pool._busy, boost::try_to_lock);
+            if (busy.owns_lock()) {
+                pool.dispatch(nThreads, nTasks, task);
+                return;
+            }
+        }
+        for (int i = 0; i < nTasks; ++i) {
+            task(i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        _threads.join_all();
+    }
+
+private:
+
+    ThreadPool() : _task(0), _nTasks(0), _next(0), _pending(0), _generation(0), _stopping(false) {}
+
+    static void initialize(ThreadPool ** instance) {
+        static ThreadPool pool;
+        *instance = &pool;
+    }
+
+    static ThreadPool & getInstance() {
+        static boost::once_flag flag = BOOST_ONCE_INIT;
+        static ThreadPool * instance = 0;
+        boost::call_once(flag, boost::bind(&ThreadPool::initialize, &instance));
+        return *instance;
+    }
+
+    void dispatch(int nThreads, int nTasks, boost::function<void(int)> const & task) {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        while (static_cast<int>(_threads.size()) < nThreads - 1) {
+            _threads.create_thread(boost::bind(&ThreadPool::work, this));
+        }
+        _task = &task;
+        _nTasks = nTasks;
+        _next = 0;
+        _pending = nTasks;
+        ++_generation;
+        _wake.notify_all();
+        runTasks(lock);
+        while (_pending > 0) {
+            _done.wait(lock);
+        }
+        _task = 0;
+        _nTasks = 0;
+    }
+
+    // Claim and run tasks from the current batch until there are none left; the lock is
+    // held on entry and exit, but not while a task is running.
+    void runTasks(boost::unique_lock<boost::mutex> & lock) {
+        while (_next < _nTasks) {
+            int i = _next++;
+            boost::function<void(int)> const * task = _task;
+            lock.unlock();
+            (*task)(i);
+            lock.lock();
+            if (--_pending == 0) {
+                _done.notify_all();
+            }
+        }
+    }
+
+    void work() {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        unsigned long seen = _generation;
+        while (true) {
+            while (!_stopping && _generation == seen) {
+                _wake.wait(lock);
+            }
+            if (_stopping) return;
+            seen = _generation;
+            runTasks(lock);
+        }
+    }
+
+    boost::mutex _busy;
+    boost::mutex _mutex;
+    boost::condition_variable _wake;
+    boost::condition_variable _done;
+    boost::thread_group _threads;
+    boost::function<void(int)> const * _task;
+    int _nTasks;
+    int _next;
+    int _pending;
+    unsigned long _generation;
+    bool _stopping;
+};
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_DETAIL_ThreadPool_h_INCLUDED
@@ -85,7 +85,7 @@ public:
         _operand(operand), _functor(functor) {}
 
     Reference operator[](int n) const {
-        return Reference(_operand[n],_functor);
+        return vectorize(_functor, _operand[n]);
     }
 
     Iterator begin() const {
@@ -14,6 +14,7 @@
 #include "ndarray/eigen/bp/EigenView.h"
 #include "ndarray/eigen/bp/Array.h"
 #include "ndarray/eigen/bp/Matrix.h"
+#include "ndarray/eigen/bp/Map.h"
 #include "ndarray/eigen/bp/ReturnInternal.h"
 
 #endif // !NDARRAY_EIGEN_bp_h_INCLUDED
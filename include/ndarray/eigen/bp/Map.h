@@ -0,0 +1,50 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_EIGEN_BP_Map_h_INCLUDED
+#define NDARRAY_EIGEN_BP_Map_h_INCLUDED
+
+#include "ndarray/eigen/bp/EigenView.h"
+
+namespace ndarray {
+
+/**
+ *  @brief Conversion of Eigen::Map objects returned by value.
+ *
+ *  A Map does not own its memory, and nothing ties its lifetime to a Python object here, so it
+ *  is copied.  To share the memory instead, return an EigenView (for memory owned by an
+ *  ndarray::Array) or a reference with the ReturnInternal call policy (for memory owned by
+ *  the wrapped object).
+ */
+template <typename PlainObjectType, int MapOptions, typename StrideType>
+class ToBoostPython< Eigen::Map<PlainObjectType,MapOptions,StrideType> > {
+public:
+
+    typedef Eigen::Map<PlainObjectType,MapOptions,StrideType> Input;
+
+    typedef boost::numpy::ndarray result_type;
+
+    typedef typename boost::remove_const<PlainObjectType>::type Plain;
+
+    typedef typename SelectEigenView<Plain>::Type View;
+
+    static boost::numpy::ndarray apply(Input const & input) {
+        View output(
+            typename SelectEigenView<Plain>::Shallow(allocate(input.rows(), input.cols()))
+        );
+        output = input;
+        return ToBoostPython< View >::apply(output);
+    }
+
+};
+
+} // namespace ndarray
+
+#endif // !NDARRAY_EIGEN_BP_Map_h_INCLUDED
@@ -14,6 +14,7 @@
 #include "ndarray/eigen/bp/auto/EigenView.h"
 #include "ndarray/eigen/bp/auto/Array.h"
 #include "ndarray/eigen/bp/auto/Matrix.h"
+#include "ndarray/eigen/bp/auto/Map.h"
 #include "ndarray/eigen/bp.h"
 
 #endif // !NDARRAY_EIGEN_BP_auto_h_INCLUDED
@@ -0,0 +1,23 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+// THIS FILE IS MACHINE GENERATED BY SCONS. DO NOT EDIT MANUALLY.
+include(`auto_bp_converters.m4')dnl
+changecom(`###')dnl
+#ifndef NDARRAY_EIGEN_BP_AUTO_Map_h_INCLUDED
+#define NDARRAY_EIGEN_BP_AUTO_Map_h_INCLUDED
+
+#include "boost/numpy.hpp"
+#include "ndarray/eigen/bp/Map.h"
+
+BP_AUTO_CONVERTERS(`typename PlainObjectType, int MapOptions, typename StrideType',
+                   `Eigen::Map<PlainObjectType,MapOptions,StrideType>')dnl
+
+#endif // !NDARRAY_EIGEN_BP_AUTO_Map_h_INCLUDED
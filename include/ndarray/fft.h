@@ -22,8 +22,10 @@
 #include "ndarray.h"
 #include "ndarray/fft/FourierTransform.h"
 #include "ndarray/fft/FourierOps.h"
+#include "ndarray/fft/RealToRealTransform.h"
 #ifndef NDARRAY_FFT_MANUAL_INCLUDE
 #include "ndarray/fft/FourierTransform.cc"
+#include "ndarray/fft/RealToRealTransform.cc"
 #endif
 
 #endif // !NDARRAY_fft_h_INCLUDED
@@ -0,0 +1,448 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_FFT_FFTWPlanCache_h_INCLUDED
+#define NDARRAY_FFT_FFTWPlanCache_h_INCLUDED
+
+/**
+ *  @file ndarray/fft/FFTWPlanCache.h
+ *
+ *  @brief A process-wide registry of FFTW plans, shared between FourierTransform instances.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <stdexcept>
+#include <boost/noncopyable.hpp>
+#include <boost/detail/lightweight_mutex.hpp>
+
+#include "ndarray/fft/FFTWTraits.h"
+#include "ndarray/fft/FourierTransform.h"
+
+namespace ndarray {
+/// \cond INTERNAL
+namespace detail {
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief The lock that serializes all calls into the FFTW planner.
+ *
+ *  Only plan execution is thread-safe in FFTW; creating and destroying plans and reading or
+ *  writing wisdom are not, even across precisions.
+ */
+inline boost::detail::lightweight_mutex & getFFTWMutex() {
+    static boost::detail::lightweight_mutex mutex;
+    return mutex;
+}
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief The memory spanned by one of a planner's arrays, in bytes.
+ */
+struct FFTWExtent {
+    std::ptrdiff_t before;  ///< Bytes before the first element (nonzero only for negative strides).
+    std::ptrdiff_t after;   ///< Bytes from the start of the first element to the end of the last.
+
+    FFTWExtent(std::ptrdiff_t before_, std::ptrdiff_t after_) : before(before_), after(after_) {}
+};
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief A planner for r2c, c2r and complex transforms, passed to FFTWPlanCache::get().
+ *
+ *  A planner describes the transform geometry for the cache key, reports how much memory its
+ *  arrays span (for the scratch arrays), and creates the plan on arrays it is given.
+ */
+template <typename T>
+struct FFTWDftPlanner {
+    typedef FFTWTraits<T> Traits;
+    typedef typename Traits::ElementX ElementX;
+    typedef typename Traits::ElementK ElementK;
+
+    bool forward;
+    int rank;
+    int const * n;
+    int howmany;
+    int xDist;
+    int kDist;
+
+    FFTWDftPlanner(bool forward_, int rank_, int const * n_, int howmany_, int xDist_, int kDist_) :
+        forward(forward_), rank(rank_), n(n_), howmany(howmany_),
+        // distances are irrelevant for a single transform
+        xDist(howmany_ == 1 ? 0 : xDist_), kDist(howmany_ == 1 ? 0 : kDist_)
+    {}
+
+    void describe(std::vector<std::ptrdiff_t> & layout) const {
+        layout.push_back(forward ? 0 : 1);
+        layout.push_back(howmany);
+        layout.push_back(xDist);
+        layout.push_back(kDist);
+        layout.insert(layout.end(), n, n + rank);
+    }
+
+    FFTWExtent getInputExtent() const { return FFTWExtent(0, forward ? getBytesX() : getBytesK()); }
+
+    FFTWExtent getOutputExtent() const { return FFTWExtent(0, forward ? getBytesK() : getBytesX()); }
+
+    typename Traits::Plan operator()(char * in, char * out, unsigned int flags) const {
+        if (forward) {
+            return Traits::forward(
+                rank, n, howmany,
+                reinterpret_cast<ElementX*>(in), NULL, 1, xDist,
+                reinterpret_cast<ElementK*>(out), NULL, 1, kDist,
+                flags
+            );
+        }
+        return Traits::inverse(
+            rank, n, howmany,
+            reinterpret_cast<ElementK*>(in), NULL, 1, kDist,
+            reinterpret_cast<ElementX*>(out), NULL, 1, xDist,
+            flags
+        );
+    }
+
+private:
+
+    std::ptrdiff_t getBytesX() const {
+        std::ptrdiff_t size = 1;
+        for (int d = 0; d < rank; ++d) size *= n[d];
+        return (size + std::ptrdiff_t(howmany - 1) * xDist) * sizeof(ElementX);
+    }
+
+    std::ptrdiff_t getBytesK() const {
+        std::ptrdiff_t size = FourierTraits<T>::computeLastDimensionSize(n[rank-1]);
+        for (int d = 0; d < rank - 1; ++d) size *= n[d];
+        return (size + std::ptrdiff_t(howmany - 1) * kDist) * sizeof(ElementK);
+    }
+};
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief A planner for r2c, c2r and complex transforms of arbitrarily strided arrays.
+ *
+ *  This uses FFTW's guru64 interface.  Strides are in elements, batch stride first and then one
+ *  per transform dimension; they may be negative.
+ */
+template <typename T>
+struct FFTWGuruPlanner {
+    typedef FFTWTraits<T> Traits;
+    typedef typename Traits::ElementX ElementX;
+    typedef typename Traits::ElementK ElementK;
+
+    bool forward;
+    int rank;
+    int const * n;
+    int howmany;
+    int const * xStrides;
+    int const * kStrides;
+
+    FFTWGuruPlanner(
+        bool forward_, int rank_, int const * n_, int howmany_,
+        int const * xStrides_, int const * kStrides_
+    ) : forward(forward_), rank(rank_), n(n_), howmany(howmany_),
+        xStrides(xStrides_), kStrides(kStrides_)
+    {}
+
+    void describe(std::vector<std::ptrdiff_t> & layout) const {
+        layout.push_back(forward ? 3 : 4);
+        layout.push_back(howmany);
+        layout.insert(layout.end(), n, n + rank);
+        // batch strides are irrelevant for a single transform
+        layout.push_back(howmany == 1 ? 0 : xStrides[0]);
+        layout.insert(layout.end(), xStrides + 1, xStrides + rank + 1);
+        layout.push_back(howmany == 1 ? 0 : kStrides[0]);
+        layout.insert(layout.end(), kStrides + 1, kStrides + rank + 1);
+    }
+
+    FFTWExtent getInputExtent() const { return forward ? getExtentX() : getExtentK(); }
+
+    FFTWExtent getOutputExtent() const { return forward ? getExtentK() : getExtentX(); }
+
+    typename Traits::Plan operator()(char * in, char * out, unsigned int flags) const {
+        int const * inStrides = forward ? xStrides : kStrides;
+        int const * outStrides = forward ? kStrides : xStrides;
+        std::vector<typename Traits::IoDim> dims(rank);
+        for (int d = 0; d < rank; ++d) {
+            dims[d].n = n[d];
+            dims[d].is = inStrides[d + 1];
+            dims[d].os = outStrides[d + 1];
+        }
+        typename Traits::IoDim batch;
+        batch.n = howmany;
+        batch.is = inStrides[0];
+        batch.os = outStrides[0];
+        int const howmanyRank = (howmany == 1) ? 0 : 1;
+        if (forward) {
+            return Traits::guruForward(
+                rank, &dims.front(), howmanyRank, &batch,
+                reinterpret_cast<ElementX*>(in), reinterpret_cast<ElementK*>(out), flags
+            );
+        }
+        return Traits::guruInverse(
+            rank, &dims.front(), howmanyRank, &batch,
+            reinterpret_cast<ElementK*>(in), reinterpret_cast<ElementX*>(out), flags
+        );
+    }
+
+private:
+
+    // Add the offsets (in elements) spanned by one dimension to the lowest and highest offsets.
+    static void addSpan(std::ptrdiff_t & lo, std::ptrdiff_t & hi, int size, int stride) {
+        std::ptrdiff_t const span = std::ptrdiff_t(size - 1) * stride;
+        if (span < 0) {
+            lo += span;
+        } else {
+            hi += span;
+        }
+    }
+
+    FFTWExtent getExtentX() const {
+        std::ptrdiff_t lo = 0;
+        std::ptrdiff_t hi = 0;
+        addSpan(lo, hi, howmany, xStrides[0]);
+        for (int d = 0; d < rank; ++d) addSpan(lo, hi, n[d], xStrides[d + 1]);
+        return FFTWExtent(-lo * sizeof(ElementX), (hi + 1) * sizeof(ElementX));
+    }
+
+    FFTWExtent getExtentK() const {
+        std::ptrdiff_t lo = 0;
+        std::ptrdiff_t hi = 0;
+        addSpan(lo, hi, howmany, kStrides[0]);
+        for (int d = 0; d < rank - 1; ++d) addSpan(lo, hi, n[d], kStrides[d + 1]);
+        addSpan(lo, hi, FourierTraits<T>::computeLastDimensionSize(n[rank-1]), kStrides[rank]);
+        return FFTWExtent(-lo * sizeof(ElementK), (hi + 1) * sizeof(ElementK));
+    }
+};
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief A planner for real-to-real (DCT/DST) transforms, passed to FFTWPlanCache::get().
+ *
+ *  The kinds are the integer values of FFTW's r2r_kind enum, one per dimension.
+ */
+template <typename T>
+struct FFTWRealToRealPlanner {
+    typedef FFTWTraits<T> Traits;
+    typedef typename Traits::ElementX ElementX;
+
+    int rank;
+    int const * n;
+    int howmany;
+    int inDist;
+    int outDist;
+    int const * kinds;
+
+    FFTWRealToRealPlanner(
+        int rank_, int const * n_, int howmany_, int inDist_, int outDist_, int const * kinds_
+    ) : rank(rank_), n(n_), howmany(howmany_),
+        inDist(howmany_ == 1 ? 0 : inDist_), outDist(howmany_ == 1 ? 0 : outDist_),
+        kinds(kinds_)
+    {}
+
+    void describe(std::vector<std::ptrdiff_t> & layout) const {
+        layout.push_back(2);
+        layout.push_back(howmany);
+        layout.push_back(inDist);
+        layout.push_back(outDist);
+        layout.insert(layout.end(), n, n + rank);
+        layout.insert(layout.end(), kinds, kinds + rank);
+    }
+
+    FFTWExtent getInputExtent() const { return FFTWExtent(0, getBytes(inDist)); }
+
+    FFTWExtent getOutputExtent() const { return FFTWExtent(0, getBytes(outDist)); }
+
+    typename Traits::Plan operator()(char * in, char * out, unsigned int flags) const {
+        return Traits::realToReal(
+            rank, n, howmany,
+            reinterpret_cast<ElementX*>(in), NULL, 1, inDist,
+            reinterpret_cast<ElementX*>(out), NULL, 1, outDist,
+            kinds, flags
+        );
+    }
+
+private:
+
+    std::ptrdiff_t getBytes(int dist) const {
+        std::ptrdiff_t size = 1;
+        for (int d = 0; d < rank; ++d) size *= n[d];
+        return (size + std::ptrdiff_t(howmany - 1) * dist) * sizeof(ElementX);
+    }
+};
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief A cache of FFTW plans keyed by everything that affects their validity.
+ *
+ *  FFTW's new-array execute functions can apply a plan to any arrays with the same shape,
+ *  strides, in-place-ness and alignment (as reported by fftw_alignment_of) as the arrays it
+ *  was created with.  Plans are therefore created once per such key and set of PlannerOptions,
+ *  on scratch arrays with the same alignment as the caller's so the caller's data is never
+ *  touched, and then shared.
+ */
+template <typename T>
+class FFTWPlanCache : private boost::noncopyable {
+public:
+    typedef FFTWTraits<T> Traits;
+    typedef typename Traits::ElementX ElementX;
+    typedef typename Traits::ElementK ElementK;
+    typedef boost::shared_ptr<void> PlanPtr;
+
+    /// @brief Return a plan for an r2c or forward complex transform of x into k.
+    static PlanPtr getForward(
+        int rank, int const * n, int howmany,
+        ElementX * x, int xDist, ElementK * k, int kDist,
+        PlannerOptions const & options
+    ) {
+        return get(FFTWDftPlanner<T>(true, rank, n, howmany, xDist, kDist), x, k, options);
+    }
+
+    /// @brief Return a plan for a c2r or backward complex transform of k into x.
+    static PlanPtr getInverse(
+        int rank, int const * n, int howmany,
+        ElementK * k, int kDist, ElementX * x, int xDist,
+        PlannerOptions const & options
+    ) {
+        return get(FFTWDftPlanner<T>(false, rank, n, howmany, xDist, kDist), k, x, options);
+    }
+
+    /// @brief Return a plan for a real-to-real transform of in into out.
+    static PlanPtr getRealToReal(
+        int rank, int const * n, int howmany,
+        ElementX * in, int inDist, ElementX * out, int outDist, int const * kinds,
+        PlannerOptions const & options
+    ) {
+        return get(FFTWRealToRealPlanner<T>(rank, n, howmany, inDist, outDist, kinds), in, out, options);
+    }
+
+    /**
+     *  @brief Return a plan created by the given planner for the given arrays.
+     *
+     *  The arrays are only used for their alignment and in-place-ness, unless the options
+     *  request PLAN_ESTIMATE, which never touches the arrays.
+     */
+    template <typename Planner>
+    static PlanPtr get(Planner const & planner, void * in, void * out, PlannerOptions const & options) {
+        Key key;
+        planner.describe(key.layout);
+        key.inPlace = (in == out);
+        key.inAlignment = Traits::alignmentOf(in);
+        key.outAlignment = Traits::alignmentOf(out);
+        key.threads = std::max(options.threads, 1);
+        key.rigor = options.rigor;
+        key.preserveInput = options.preserveInput;
+        key.timeLimit = (options.timeLimit < 0.0) ? -1.0 : options.timeLimit;
+
+        boost::detail::lightweight_mutex::scoped_lock lock(getFFTWMutex());
+        typename Map::const_iterator i = getMap().find(key);
+        if (i != getMap().end()) return i->second;
+
+        // FFTW_ESTIMATE never touches the arrays, so only plans that run trial transforms
+        // need scratch memory.
+        typename Traits::OwnerK inScratch;
+        typename Traits::OwnerK outScratch;
+        char * inData = reinterpret_cast<char*>(in);
+        char * outData = reinterpret_cast<char*>(out);
+        if (options.rigor != PLAN_ESTIMATE) {
+            FFTWExtent inExtent = planner.getInputExtent();
+            FFTWExtent outExtent = planner.getOutputExtent();
+            // fftw_malloc returns memory with zero alignment offset, so offsetting the scratch
+            // arrays by the caller's offsets reproduces the caller's alignment exactly; the
+            // room left for negative strides is a multiple of PADDING so it doesn't change that.
+            enum { PADDING = 64 };
+            inExtent.before = (inExtent.before + PADDING - 1) / PADDING * PADDING;
+            outExtent.before = (outExtent.before + PADDING - 1) / PADDING * PADDING;
+            if (key.inPlace) {
+                std::ptrdiff_t const before = std::max(inExtent.before, outExtent.before);
+                std::ptrdiff_t const bytes = before + std::max(inExtent.after, outExtent.after);
+                inScratch = Traits::allocateK((bytes + PADDING) / sizeof(ElementK) + 1);
+                inData = outData = reinterpret_cast<char*>(inScratch.get()) + key.inAlignment + before;
+            } else {
+                inScratch = Traits::allocateK(
+                    (inExtent.before + inExtent.after + PADDING) / sizeof(ElementK) + 1
+                );
+                outScratch = Traits::allocateK(
+                    (outExtent.before + outExtent.after + PADDING) / sizeof(ElementK) + 1
+                );
+                inData = reinterpret_cast<char*>(inScratch.get()) + key.inAlignment + inExtent.before;
+                outData = reinterpret_cast<char*>(outScratch.get()) + key.outAlignment + outExtent.before;
+            }
+        }
+        static unsigned int const rigorFlags[] = {
+            FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT, FFTW_EXHAUSTIVE
+        };
+        unsigned int const flags = rigorFlags[options.rigor]
+            | (options.preserveInput ? FFTW_PRESERVE_INPUT : FFTW_DESTROY_INPUT);
+        Traits::planWithThreads(key.threads);
+        Traits::setTimeLimit(key.timeLimit < 0.0 ? FFTW_NO_TIMELIMIT : key.timeLimit);
+        typename Traits::Plan plan = planner(inData, outData, flags);
+        if (!plan) throw std::runtime_error("FFTW could not create a plan for the given arrays");
+        PlanPtr result(reinterpret_cast<void*>(plan), Deleter());
+        getMap()[key] = result;
+        return result;
+    }
+
+    /// @brief Release the cache's references to all plans.
+    static void clear() {
+        Map released;
+        {
+            boost::detail::lightweight_mutex::scoped_lock lock(getFFTWMutex());
+            released.swap(getMap());
+        }
+        // plans are destroyed here, after the lock is released, as the deleter takes it again
+    }
+
+private:
+
+    struct Key {
+        bool inPlace;
+        int inAlignment;
+        int outAlignment;
+        int threads;
+        int rigor;
+        bool preserveInput;
+        double timeLimit;
+        std::vector<std::ptrdiff_t> layout; // transform type, geometry and kinds, from the planner
+
+        bool operator<(Key const & other) const {
+            if (inPlace != other.inPlace) return inPlace < other.inPlace;
+            if (inAlignment != other.inAlignment) return inAlignment < other.inAlignment;
+            if (outAlignment != other.outAlignment) return outAlignment < other.outAlignment;
+            if (threads != other.threads) return threads < other.threads;
+            if (rigor != other.rigor) return rigor < other.rigor;
+            if (preserveInput != other.preserveInput) return preserveInput < other.preserveInput;
+            if (timeLimit != other.timeLimit) return timeLimit < other.timeLimit;
+            return layout < other.layout;
+        }
+    };
+
+    struct Deleter {
+        void operator()(void * plan) const {
+            boost::detail::lightweight_mutex::scoped_lock lock(getFFTWMutex());
+            Traits::destroy(reinterpret_cast<typename Traits::Plan>(plan));
+        }
+    };
+
+    typedef std::map<Key,PlanPtr> Map;
+
+    static Map & getMap() {
+        static Map map;
+        return map;
+    }
+
+};
+
+} // namespace detail
+/// \endcond
+} // namespace ndarray
+
+#endif // !NDARRAY_FFT_FFTWPlanCache_h_INCLUDED
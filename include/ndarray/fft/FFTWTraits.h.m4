@@ -15,6 +15,7 @@ define(`FFTW_TRAITS',
     template <> struct FFTWTraits<$1> {
         BOOST_STATIC_ASSERT((!boost::is_const<$1>::value));
         typedef $2_plan Plan;
+        typedef $2_iodim64 IoDim;
         typedef FourierTraits<$1>::ElementX ElementX;
         typedef FourierTraits<$1>::ElementK ElementK;
         typedef boost::shared_ptr<ElementX> OwnerX;
@@ -39,8 +40,65 @@ define(`FFTW_TRAITS',
                                         out, onembed, ostride, odist,
                                         flags);			
         }
+        static inline Plan guruForward(int rank, const IoDim *dims,
+                                       int howmanyRank, const IoDim *howmanyDims,
+                                       ElementX *in, ElementK *out, unsigned flags) {
+            return $2_plan_guru64_dft_r2c(rank, dims, howmanyRank, howmanyDims,
+                                          in, reinterpret_cast<$2_complex*>(out), flags);
+        }
+        static inline Plan guruInverse(int rank, const IoDim *dims,
+                                       int howmanyRank, const IoDim *howmanyDims,
+                                       ElementK *in, ElementX *out, unsigned flags) {
+            return $2_plan_guru64_dft_c2r(rank, dims, howmanyRank, howmanyDims,
+                                          reinterpret_cast<$2_complex*>(in), out, flags);
+        }
+        static inline Plan realToReal(int rank, const int *n, int howmany,
+                                      ElementX *in, const int *inembed, int istride, int idist,
+                                      ElementX *out, const int *onembed, int ostride, int odist,
+                                      const int *kinds, unsigned flags) {
+            std::vector<$2_r2r_kind> fftwKinds(rank);
+            for (int i = 0; i < rank; ++i) fftwKinds[i] = static_cast<$2_r2r_kind>(kinds[i]);
+            return $2_plan_many_r2r(rank, n, howmany,
+                                    in, inembed, istride, idist,
+                                    out, onembed, ostride, odist,
+                                    &fftwKinds.front(), flags);
+        }
         static inline void destroy(Plan p) { $2_destroy_plan(p); }
         static inline void execute(Plan p) { $2_execute(p); }	
+        static inline void execute(Plan p, ElementX * in, ElementK * out) {
+            $2_execute_dft_r2c(p, in, reinterpret_cast<$2_complex*>(out));
+        }
+        static inline void execute(Plan p, ElementK * in, ElementX * out) {
+            $2_execute_dft_c2r(p, reinterpret_cast<$2_complex*>(in), out);
+        }
+        static inline void execute(Plan p, ElementX * in, ElementX * out) {
+            $2_execute_r2r(p, in, out);
+        }
+        static inline int alignmentOf(void * p) { return $2_alignment_of(reinterpret_cast<$1*>(p)); }
+        static inline bool importWisdom(char const * filename) {
+            initialize();
+            return $2_import_wisdom_from_filename(filename);
+        }
+        static inline bool exportWisdom(char const * filename) {
+            initialize();
+            return $2_export_wisdom_to_filename(filename);
+        }
+        static inline void forgetWisdom() { initialize(); $2_forget_wisdom(); }
+        static inline bool initialize() {
+#ifdef NDARRAY_FFTW_THREADS
+            // FFTW wants this before any other planner call, and only once
+            static bool initialized = $2_init_threads();
+            return initialized;
+#else
+            return false;
+#endif
+        }
+        static inline void setTimeLimit(double seconds) { $2_set_timelimit(seconds); }
+        static inline void planWithThreads(int n) {
+#ifdef NDARRAY_FFTW_THREADS
+            if (initialize()) $2_plan_with_nthreads(n);
+#endif
+        }
         static inline OwnerX allocateX(int n) {
             return OwnerX(
                 reinterpret_cast<ElementX*>(
@@ -60,6 +118,7 @@ define(`FFTW_TRAITS',
     };
     template <> struct FFTWTraits< std::complex<$1> > {
         typedef $2_plan Plan;
+        typedef $2_iodim64 IoDim;
         typedef FourierTraits< std::complex<$1> >::ElementX ElementX;
         typedef FourierTraits< std::complex<$1> >::ElementK ElementK;
         typedef boost::shared_ptr<ElementX> OwnerX;
@@ -86,8 +145,40 @@ define(`FFTW_TRAITS',
                                     onembed, ostride, odist,
                                     FFTW_BACKWARD,flags);
         }
+        static inline Plan guruForward(int rank, const IoDim *dims,
+                                       int howmanyRank, const IoDim *howmanyDims,
+                                       ElementX *in, ElementK *out, unsigned flags) {
+            return $2_plan_guru64_dft(rank, dims, howmanyRank, howmanyDims,
+                                      reinterpret_cast<$2_complex*>(in),
+                                      reinterpret_cast<$2_complex*>(out),
+                                      FFTW_FORWARD, flags);
+        }
+        static inline Plan guruInverse(int rank, const IoDim *dims,
+                                       int howmanyRank, const IoDim *howmanyDims,
+                                       ElementK *in, ElementX *out, unsigned flags) {
+            return $2_plan_guru64_dft(rank, dims, howmanyRank, howmanyDims,
+                                      reinterpret_cast<$2_complex*>(in),
+                                      reinterpret_cast<$2_complex*>(out),
+                                      FFTW_BACKWARD, flags);
+        }
         static inline void destroy(Plan p) { $2_destroy_plan(p); }
         static inline void execute(Plan p) { $2_execute(p); }	
+        static inline void execute(Plan p, ElementX * in, ElementK * out) {
+            $2_execute_dft(p, reinterpret_cast<$2_complex*>(in), reinterpret_cast<$2_complex*>(out));
+        }
+        static inline int alignmentOf(void * p) { return $2_alignment_of(reinterpret_cast<$1*>(p)); }
+        static inline bool importWisdom(char const * filename) {
+            initialize();
+            return $2_import_wisdom_from_filename(filename);
+        }
+        static inline bool exportWisdom(char const * filename) {
+            initialize();
+            return $2_export_wisdom_to_filename(filename);
+        }
+        static inline void forgetWisdom() { initialize(); $2_forget_wisdom(); }
+        static inline bool initialize() { return FFTWTraits<$1>::initialize(); }
+        static inline void setTimeLimit(double seconds) { $2_set_timelimit(seconds); }
+        static inline void planWithThreads(int n) { FFTWTraits<$1>::planWithThreads(n); }
         static inline OwnerX allocateX(int n) {
             return OwnerX(
                 reinterpret_cast<ElementX*>(
@@ -115,6 +206,7 @@ define(`FFTW_TRAITS',
  */
 
 #include <complex>
+#include <vector>
 #include <fftw3.h>
 #include "ndarray/fft/FourierTraits.h"
 
@@ -11,13 +11,19 @@
 #ifndef NDARRAY_FFT_FourierOps_h_INCLUDED
 #define NDARRAY_FFT_FourierOps_h_INCLUDED
 
-/** 
+/**
  *  @file ndarray/fft/FourierOps.h
  *
  *  @brief Common Fourier-space operations.
+ *
+ *  All of these operate on the half-complex arrays produced by real-data transforms: every
+ *  dimension but the last holds the full set of frequencies in FFTW order, and the last
+ *  holds only the real_last_dim/2 + 1 non-negative ones.
  */
 
-#include <boost/noncopyable.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
 
 #include "ndarray.h"
 
@@ -27,53 +33,167 @@ namespace detail {
 
 /**
  *  @internal @ingroup FFTndarrayInternalGroup
- *  @brief Implementations for the shift() and differentiate() functions.
+ *  @brief Return the signed frequency of element i of a transform of length n (+n/2 for Nyquist).
  */
-template <typename T, int N>
-struct FourierOps {
+inline int getFourierFrequency(int i, int n) { return (2 * i <= n) ? i : i - n; }
 
-    template <int C>
-    static void shift(
-        T const * offset,
-        std::complex<T> const & factor,
-        ArrayRef<std::complex<T>,N,C> const & array,
-        int const real_last_dim
-    ) {
-        typename ArrayRef<std::complex<T>,N,C>::Iterator iter = array.begin();
-        T u = -2.0 * M_PI * (*offset) / array.size();
-        int kMid = (array.size() + 1) / 2;
-        for (int k = 0; k < kMid; ++k, ++iter) {
-            FourierOps<T,N-1>::shift(offset+1, factor * std::polar(static_cast<T>(1), u * k), 
-                                     *iter, real_last_dim);
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief Per-axis factor vectors for separable Fourier-space operations.
+ *
+ *  Each function returns the factors for one axis with real-space length n, of which the
+ *  first size frequencies are stored.
+ */
+template <typename T>
+struct FourierAxis {
+
+    typedef std::vector< std::complex<T> > Factors;
+
+    /// Phase ramp exp(-2 pi i k offset / n); the Nyquist element gets the real part only.
+    static Factors makeShift(T offset, int n, int size) {
+        Factors r(size);
+        T u = -2.0 * M_PI * offset / n;
+        for (int i = 0; i < size; ++i) {
+            int k = getFourierFrequency(i, n);
+            r[i] = (2 * k == n) ? std::complex<T>(std::cos(u * k)) : std::polar(static_cast<T>(1), u * k);
+        }
+        return r;
+    }
+
+    /// 2 pi i k / n if the axis is differentiated, 1 if not; the Nyquist element is zeroed either way.
+    static Factors makeDerivative(bool active, int n, int size) {
+        Factors r(size);
+        T u = 2.0 * M_PI / n;
+        for (int i = 0; i < size; ++i) {
+            int k = getFourierFrequency(i, n);
+            r[i] = (2 * k == n) ? std::complex<T>(0)
+                : (active ? std::complex<T>(static_cast<T>(0), u * T(k)) : std::complex<T>(1));
+        }
+        return r;
+    }
+
+};
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief Multiply row[i] by factor * other[i] for n strided complex elements.
+ *
+ *  This does the complex arithmetic on the real and imaginary parts directly; std::complex
+ *  multiplication has to handle infinities, which keeps the compiler from vectorizing it.
+ */
+template <typename T>
+inline void multiplyRow(
+    std::complex<T> * row, int rowStride,
+    std::complex<T> const * other, int otherStride,
+    std::complex<T> const & factor, int n
+) {
+    T * r = reinterpret_cast<T*>(row);
+    T const * o = reinterpret_cast<T const*>(other);
+    T const fr = factor.real();
+    T const fi = factor.imag();
+    if (rowStride == 1 && otherStride == 1) {
+        for (int i = 0; i < 2 * n; i += 2) {
+            T const tr = fr * o[i] - fi * o[i+1];
+            T const ti = fr * o[i+1] + fi * o[i];
+            T const a = r[i];
+            T const b = r[i+1];
+            r[i] = a * tr - b * ti;
+            r[i+1] = a * ti + b * tr;
         }
-        if (array.size() % 2 == 0) {
-            FourierOps<T,N-1>::shift(offset+1, factor * std::cos(u * kMid), *iter, real_last_dim);
-            ++iter;
-            ++kMid;
+    } else {
+        rowStride *= 2;
+        otherStride *= 2;
+        for (int i = 0; i < n; ++i, r += rowStride, o += otherStride) {
+            T const tr = fr * o[0] - fi * o[1];
+            T const ti = fr * o[1] + fi * o[0];
+            T const a = r[0];
+            T const b = r[1];
+            r[0] = a * tr - b * ti;
+            r[1] = a * ti + b * tr;
         }
-        for (int k_n = kMid - array.size(); k_n < 0; ++k_n, ++iter) {
-            FourierOps<T,N-1>::shift(offset+1, factor * std::polar(static_cast<T>(1), u * k_n),
-                                     *iter, real_last_dim);
+    }
+}
+
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief Index maps used to resample one axis of a Fourier-space array.
+ *
+ *  Output element j takes input element source[j] times weight[j] (zero if the weight is).
+ */
+template <typename T>
+struct FourierResampleAxis {
+    std::vector<int> source;
+    std::vector<T> weight;
+
+    /**
+     *  Map an axis of real-space length nIn to one of length nOut.  If isLast, only the
+     *  non-negative frequencies are stored.
+     *
+     *  Frequencies the output can't represent are dropped, as is the output's Nyquist
+     *  frequency when downsampling (it would alias two input frequencies); the input's
+     *  Nyquist frequency is split evenly between +/- nIn/2 when upsampling.
+     */
+    FourierResampleAxis(int nIn, int nOut, bool isLast)
+        : source(isLast ? nOut / 2 + 1 : nOut, 0), weight(source.size(), static_cast<T>(0))
+    {
+        for (int j = 0; j < int(source.size()); ++j) {
+            int k = getFourierFrequency(j, nOut);
+            if (2 * k == nOut && nOut < nIn) continue;
+            if (2 * std::abs(k) > nIn) continue;
+            source[j] = (k < 0) ? k + nIn : k;
+            weight[j] = (2 * std::abs(k) == nIn && nOut > nIn) ? static_cast<T>(0.5) : static_cast<T>(1);
         }
     }
+};
 
+/**
+ *  @internal @ingroup FFTndarrayInternalGroup
+ *  @brief Recursive implementations of the separable Fourier-space operations.
+ */
+template <typename T, int N>
+struct FourierOps {
+
+    /// Multiply array by the outer product of the per-axis factors (and a scalar).
     template <int C>
-    static void differentiate(int m, ArrayRef<std::complex<T>,N,C> const & array, int const real_last_dim) {
+    static void multiply(
+        std::vector< std::complex<T> > const * factors,
+        std::complex<T> const & scalar,
+        ArrayRef<std::complex<T>,N,C> const & array
+    ) {
         typename ArrayRef<std::complex<T>,N,C>::Iterator iter = array.begin();
-        int kMid = (array.size() + 1) / 2;
-        T u = 2.0 * M_PI / array.size();
-        for (int k = 0; k < kMid; ++k, ++iter) {
-            if (m == N) (*iter) *= std::complex<T>(static_cast<T>(0), u * T(k));
-            FourierOps<T,N-1>::differentiate(m, *iter, real_last_dim);
+        for (int i = 0; i < array.template getSize<0>(); ++i, ++iter) {
+            FourierOps<T,N-1>::multiply(factors + 1, scalar * (*factors)[i], *iter);
         }
-        if (array.size() % 2 == 0) {
-            (*iter) = static_cast<T>(0);
-            ++iter;
-            ++kMid;
+    }
+
+    /// Multiply array elementwise by another array of the same shape.
+    template <int C1, int C2>
+    static void multiply(
+        ArrayRef<std::complex<T>,N,C1> const & array,
+        ArrayRef<std::complex<T>,N,C2> const & other
+    ) {
+        typename ArrayRef<std::complex<T>,N,C1>::Iterator iter = array.begin();
+        typename ArrayRef<std::complex<T>,N,C2>::Iterator otherIter = other.begin();
+        for (; iter != array.end(); ++iter, ++otherIter) {
+            FourierOps<T,N-1>::multiply(*iter, *otherIter);
         }
-        for (int k_n = kMid - array.size(); k_n < 0; ++k_n, ++iter) {
-            if (m == N) (*iter) *= std::complex<T>(static_cast<T>(0), u * T(k_n));
-            FourierOps<T,N-1>::differentiate(m, *iter, real_last_dim);
+    }
+
+    /// Fill output with the input elements selected by the per-axis maps.
+    template <int C1, int C2>
+    static void resample(
+        FourierResampleAxis<T> const * axes,
+        T scale,
+        ArrayRef<std::complex<T>,N,C1> const & input,
+        ArrayRef<std::complex<T>,N,C2> const & output
+    ) {
+        typename ArrayRef<std::complex<T>,N,C2>::Iterator iter = output.begin();
+        for (int j = 0; j < output.template getSize<0>(); ++j, ++iter) {
+            if (axes->weight[j] == static_cast<T>(0)) {
+                (*iter) = static_cast<T>(0);
+            } else {
+                FourierOps<T,N-1>::resample(axes + 1, scale * axes->weight[j], input[axes->source[j]], *iter);
+            }
         }
     }
 
@@ -81,43 +201,42 @@ struct FourierOps {
 
 /**
  *  @internal @ingroup FFTndarrayInternalGroup
- *  @brief Implementations for the shift() and differentiate() functions (1d specialization).
+ *  @brief Recursive implementations of the separable Fourier-space operations (1d specialization).
  */
 template <typename T>
 struct FourierOps<T,1> {
-    
+
     template <int C>
-    static void shift(
-        T const * offset,
-        std::complex<T> const & factor,
-        ArrayRef<std::complex<T>,1,C> const & array,
-        int const real_last_dim
+    static void multiply(
+        std::vector< std::complex<T> > const * factors,
+        std::complex<T> const & scalar,
+        ArrayRef<std::complex<T>,1,C> const & array
     ) {
-        typename ArrayRef<std::complex<T>,1,C>::Iterator iter = array.begin();
-        T u = -2.0 * M_PI * (*offset) / real_last_dim;
-        int kMid = (real_last_dim + 1) / 2;
-        for (int k = 0; k < kMid; ++k, ++iter) {
-            (*iter) *= factor * std::polar(1.0, u * T(k));
-        }
-        if (real_last_dim % 2 == 0) {
-            (*iter) *= factor * std::cos(u * kMid);
-            ++iter;
-        }
+        NDARRAY_ASSERT(array.template getSize<0>() >= int(factors->size()));
+        multiplyRow(array.getData(), array.template getStride<0>(), &factors->front(), 1, scalar,
+                    factors->size());
     }
 
-    template <int C>
-    static void differentiate(int m, ArrayRef<std::complex<T>,1,C> const & array, int const real_last_dim) {
-        typename ArrayRef<std::complex<T>,1,C>::Iterator iter = array.begin();
-        int kMid = (real_last_dim + 1) / 2;
-        if (m == 1) {
-            T u = 2.0 * M_PI / real_last_dim;
-            for (int k = 0; k < kMid; ++k, ++iter) {
-                (*iter) *= std::complex<T>(static_cast<T>(0), u * T(k));
-            }
+    template <int C1, int C2>
+    static void multiply(
+        ArrayRef<std::complex<T>,1,C1> const & array,
+        ArrayRef<std::complex<T>,1,C2> const & other
+    ) {
+        multiplyRow(array.getData(), array.template getStride<0>(),
+                    other.getData(), other.template getStride<0>(),
+                    std::complex<T>(1), array.template getSize<0>());
+    }
+
+    template <int C1, int C2>
+    static void resample(
+        FourierResampleAxis<T> const * axes,
+        T scale,
+        ArrayRef<std::complex<T>,1,C1> const & input,
+        ArrayRef<std::complex<T>,1,C2> const & output
+    ) {
+        for (int j = 0; j < output.template getSize<0>(); ++j) {
+            output[j] = input[axes->source[j]] * (scale * axes->weight[j]);
         }
-        if (real_last_dim % 2 == 0) {
-            array[kMid] = static_cast<T>(0);
-        }            
     }
 
 };
@@ -128,6 +247,8 @@ struct FourierOps<T,1> {
 /**
  *  @brief Perform a Fourier-space translation transform.
  *
+ *  The phase ramp is computed once per axis and applied as a separable product.
+ *
  *  @ingroup FFTGroup
  */
 template <typename T, int N, int C>
@@ -136,17 +257,19 @@ void shift(
     Array<std::complex<T>,N,C> const & array,
     int const real_last_dim
 ) {
-    detail::FourierOps<T,N>::shift(
-        offset.begin(),
-        static_cast< std::complex<T> >(1),
-        array.deep(),
-        real_last_dim
-    );
+    std::vector< std::complex<T> > factors[N];
+    for (int n = 0; n < N - 1; ++n) {
+        factors[n] = detail::FourierAxis<T>::makeShift(offset[n], array.getShape()[n], array.getShape()[n]);
+    }
+    factors[N-1] = detail::FourierAxis<T>::makeShift(offset[N-1], real_last_dim, real_last_dim / 2 + 1);
+    detail::FourierOps<T,N>::multiply(factors, std::complex<T>(1), array.deep());
 }
 
 /**
  *  @brief Numerically differentiate the array in Fourier-space in the given dimension.
  *
+ *  As a side effect the Nyquist frequency of every even-length dimension is zeroed.
+ *
  *  @ingroup FFTGroup
  */
 template <typename T, int N, int C>
@@ -155,7 +278,64 @@ void differentiate(
     Array<std::complex<T>,N,C> const & array,
     int const real_last_dim
 ) {
-    detail::FourierOps<T,N>::differentiate(N-n, array.deep(), real_last_dim);
+    std::vector< std::complex<T> > factors[N];
+    for (int m = 0; m < N - 1; ++m) {
+        factors[m] = detail::FourierAxis<T>::makeDerivative(m == n, array.getShape()[m], array.getShape()[m]);
+    }
+    factors[N-1] = detail::FourierAxis<T>::makeDerivative(n == N - 1, real_last_dim, real_last_dim / 2 + 1);
+    detail::FourierOps<T,N>::multiply(factors, std::complex<T>(1), array.deep());
+}
+
+/**
+ *  @brief Convolve by multiplying a Fourier-space array by the transform of a kernel.
+ *
+ *  The kernel must have the same shape as the array.  As with any product of unnormalized
+ *  FFTW transforms, the inverse transform of the result is the circular convolution scaled
+ *  by the number of real-space elements.
+ *
+ *  @ingroup FFTGroup
+ */
+template <typename T, int N, int C1, int C2>
+void convolve(
+    Array<std::complex<T>,N,C1> const & array,
+    Array<std::complex<T>,N,C2> const & kernel
+) {
+    NDARRAY_ASSERT(array.getShape() == kernel.getShape());
+    detail::FourierOps<T,N>::multiply(array.deep(), kernel.deep());
+}
+
+/**
+ *  @brief Resample a real-space image by copying its Fourier-space array to one of a different size.
+ *
+ *  The output is the array a forward transform of the band-limited interpolation of the input
+ *  onto the output grid would produce: frequencies are copied (and scaled by the ratio of
+ *  the real-space sizes) where both arrays have them, and zeroed where only the output
+ *  does, so the output's inverse transform should be normalized by its own size as usual.
+ *
+ *  Frequencies the output cannot represent are discarded, including the output's Nyquist
+ *  frequency when an even-length dimension shrinks.
+ *
+ *  @ingroup FFTGroup
+ */
+template <typename T, int N, int C1, int C2>
+void resample(
+    Array<std::complex<T>,N,C1> const & input,
+    int const input_real_last_dim,
+    Array<std::complex<T>,N,C2> const & output,
+    int const output_real_last_dim
+) {
+    std::vector< detail::FourierResampleAxis<T> > axes;
+    axes.reserve(N);
+    T scale = static_cast<T>(1);
+    for (int n = 0; n < N - 1; ++n) {
+        axes.push_back(detail::FourierResampleAxis<T>(input.getShape()[n], output.getShape()[n], false));
+        scale *= T(output.getShape()[n]) / T(input.getShape()[n]);
+    }
+    axes.push_back(detail::FourierResampleAxis<T>(input_real_last_dim, output_real_last_dim, true));
+    scale *= T(output_real_last_dim) / T(input_real_last_dim);
+    NDARRAY_ASSERT(output.template getSize<N-1>() == output_real_last_dim / 2 + 1);
+    NDARRAY_ASSERT(input.template getSize<N-1>() == input_real_last_dim / 2 + 1);
+    detail::FourierOps<T,N>::resample(&axes.front(), scale, input.deep(), output.deep());
 }
 
 } // namespace ndarray
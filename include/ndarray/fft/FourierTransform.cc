@@ -8,7 +8,10 @@
  * of the source distribution, or alternately available at:
  * https://github.com/ndarray/ndarray
  */
-#include "ndarray/fft/FFTWTraits.h"
+#include <algorithm>
+#include <stdexcept>
+
+#include "ndarray/fft/FFTWPlanCache.h"
 #include "ndarray/fft/FourierTransform.h"
 
 namespace ndarray {
@@ -45,24 +48,46 @@ FourierTransform<T,N>::initialize(
     NDARRAY_ASSERT(std::equal(shape.begin(), shape.end()-1, k.getShape().begin()));
 }
 
+template <typename T, int N>
+template <int M>
+void
+FourierTransform<T,N>::initializeInPlace(
+    Vector<int,M> const & shape,
+    Array<ElementX,M,1> & x,
+    Array<ElementK,M,M> & k
+) {
+    Vector<int,M> kShape(shape);
+    kShape[M-1] = detail::FourierTraits<T>::computeLastDimensionSize(shape[M-1]);
+    OwnerK kOwner = detail::FFTWTraits<T>::allocateK(kShape.product());
+    k = Array<ElementK,M,M>(external(kOwner.get(), kShape, ROW_MAJOR, kOwner));
+    Vector<int,M> xStrides = k.getStrides() * int(sizeof(ElementK) / sizeof(ElementX));
+    xStrides[M-1] = 1;
+    x = Array<ElementX,M,1>(
+        external(reinterpret_cast<ElementX*>(kOwner.get()), shape, xStrides, kOwner)
+    );
+}
+
 template <typename T, int N> 
 typename FourierTransform<T,N>::Ptr
 FourierTransform<T,N>::planForward(
     Index const & shape, 
     typename FourierTransform<T,N>::ArrayX & x,
-    typename FourierTransform<T,N>::ArrayK & k
+    typename FourierTransform<T,N>::ArrayK & k,
+    PlannerOptions const & options
 ) {
     initialize(shape,x,k);
     return Ptr(
         new FourierTransform(
-            detail::FFTWTraits<T>::forward(
+            detail::FFTWPlanCache<T>::getForward(
                 N, shape.begin(), 1,
-                x.getData(), NULL, 1, 0,
-                k.getData(), NULL, 1, 0,
-                FFTW_MEASURE | FFTW_DESTROY_INPUT
+                x.getData(), 0,
+                k.getData(), 0,
+                options
             ),
-            x.getManager(),
-            k.getManager()
+            true, 0, concatenate(1, shape),
+            x.getData(), concatenate(0, x.getStrides()), x.getManager(),
+            k.getData(), concatenate(0, k.getStrides()), k.getManager(),
+            options
         )
     );
 }
@@ -72,19 +97,22 @@ typename FourierTransform<T,N>::Ptr
 FourierTransform<T,N>::planInverse(
     Index const & shape,
     typename FourierTransform<T,N>::ArrayK & k,
-    typename FourierTransform<T,N>::ArrayX & x
+    typename FourierTransform<T,N>::ArrayX & x,
+    PlannerOptions const & options
 ) {
     initialize(shape,x,k);
     return Ptr(
         new FourierTransform(
-            detail::FFTWTraits<T>::inverse(
+            detail::FFTWPlanCache<T>::getInverse(
                 N, shape.begin(), 1,
-                k.getData(), NULL, 1, 0,
-                x.getData(), NULL, 1, 0,
-                FFTW_MEASURE | FFTW_DESTROY_INPUT
+                k.getData(), 0,
+                x.getData(), 0,
+                options
             ),
-            x.getManager(),
-            k.getManager()
+            false, 0, concatenate(1, shape),
+            x.getData(), concatenate(0, x.getStrides()), x.getManager(),
+            k.getData(), concatenate(0, k.getStrides()), k.getManager(),
+            options
         )
     );
 }
@@ -94,19 +122,22 @@ typename FourierTransform<T,N>::Ptr
 FourierTransform<T,N>::planMultiplexForward(
     MultiplexIndex const & shape,
     typename FourierTransform<T,N>::MultiplexArrayX & x,
-    typename FourierTransform<T,N>::MultiplexArrayK & k
+    typename FourierTransform<T,N>::MultiplexArrayK & k,
+    PlannerOptions const & options
 ) {
     initialize(shape,x,k);
     return Ptr(
         new FourierTransform(
-            detail::FFTWTraits<T>::forward(
+            detail::FFTWPlanCache<T>::getForward(
                 N, shape.begin()+1, shape[0],
-                x.getData(), NULL, 1, x.template getStride<0>(),
-                k.getData(), NULL, 1, k.template getStride<0>(),
-                FFTW_MEASURE | FFTW_DESTROY_INPUT
+                x.getData(), x.template getStride<0>(),
+                k.getData(), k.template getStride<0>(),
+                options
             ),
-            x.getManager(),
-            k.getManager()
+            true, 0, shape,
+            x.getData(), x.getStrides(), x.getManager(),
+            k.getData(), k.getStrides(), k.getManager(),
+            options
         )
     );
 }
@@ -116,35 +147,215 @@ typename FourierTransform<T,N>::Ptr
 FourierTransform<T,N>::planMultiplexInverse(
     MultiplexIndex const & shape,
     typename FourierTransform<T,N>::MultiplexArrayK & k,
-    typename FourierTransform<T,N>::MultiplexArrayX & x
+    typename FourierTransform<T,N>::MultiplexArrayX & x,
+    PlannerOptions const & options
 ) {
     initialize(shape,x,k);
     return Ptr(
         new FourierTransform(
-            detail::FFTWTraits<T>::inverse(
+            detail::FFTWPlanCache<T>::getInverse(
                 N, shape.begin()+1, shape[0],
-                k.getData(), NULL, 1, k.template getStride<0>(),
-                x.getData(), NULL, 1, x.template getStride<0>(),
-                FFTW_MEASURE | FFTW_DESTROY_INPUT
+                k.getData(), k.template getStride<0>(),
+                x.getData(), x.template getStride<0>(),
+                options
+            ),
+            false, 0, shape,
+            x.getData(), x.getStrides(), x.getManager(),
+            k.getData(), k.getStrides(), k.getManager(),
+            options
+        )
+    );
+}
+
+template <typename T, int N>
+template <int C, int D>
+typename FourierTransform<T,N>::Ptr
+FourierTransform<T,N>::planMultiplexForward(
+    Array<ElementX,N+1,C> const & x,
+    Array<ElementK,N+1,D> const & k,
+    int axis,
+    PlannerOptions const & options
+) {
+    NDARRAY_ASSERT(axis >= 0 && axis <= N);
+    Vector<int,N+1> shape = makeBatchFirst(x.getShape(), axis, 1);
+    Vector<int,N+1> xStrides = makeBatchFirst(x.getStrides(), axis, 0);
+    Vector<int,N+1> kStrides = makeBatchFirst(k.getStrides(), axis, 0);
+    Vector<int,N+1> kShape = makeBatchFirst(k.getShape(), axis, 1);
+    NDARRAY_ASSERT(std::equal(shape.begin(), shape.end() - 1, kShape.begin()));
+    NDARRAY_ASSERT(kShape[N] == detail::FourierTraits<T>::computeLastDimensionSize(shape[N]));
+    return Ptr(
+        new FourierTransform(
+            detail::FFTWPlanCache<T>::get(
+                detail::FFTWGuruPlanner<T>(
+                    true, N, shape.begin() + 1, shape[0], xStrides.begin(), kStrides.begin()
+                ),
+                x.getData(), k.getData(), options
+            ),
+            true, axis, shape,
+            x.getData(), xStrides, x.getManager(),
+            k.getData(), kStrides, k.getManager(),
+            options
+        )
+    );
+}
+
+template <typename T, int N>
+template <int C, int D>
+typename FourierTransform<T,N>::Ptr
+FourierTransform<T,N>::planMultiplexInverse(
+    Array<ElementK,N+1,C> const & k,
+    Array<ElementX,N+1,D> const & x,
+    int axis,
+    PlannerOptions const & options
+) {
+    NDARRAY_ASSERT(axis >= 0 && axis <= N);
+    Vector<int,N+1> shape = makeBatchFirst(x.getShape(), axis, 1);
+    Vector<int,N+1> xStrides = makeBatchFirst(x.getStrides(), axis, 0);
+    Vector<int,N+1> kStrides = makeBatchFirst(k.getStrides(), axis, 0);
+    Vector<int,N+1> kShape = makeBatchFirst(k.getShape(), axis, 1);
+    NDARRAY_ASSERT(std::equal(shape.begin(), shape.end() - 1, kShape.begin()));
+    NDARRAY_ASSERT(kShape[N] == detail::FourierTraits<T>::computeLastDimensionSize(shape[N]));
+    return Ptr(
+        new FourierTransform(
+            detail::FFTWPlanCache<T>::get(
+                detail::FFTWGuruPlanner<T>(
+                    false, N, shape.begin() + 1, shape[0], xStrides.begin(), kStrides.begin()
+                ),
+                k.getData(), x.getData(), options
             ),
-            x.getManager(),
-            k.getManager()
+            false, axis, shape,
+            x.getData(), xStrides, x.getManager(),
+            k.getData(), kStrides, k.getManager(),
+            options
         )
     );
 }
 
 template <typename T, int N>
 void FourierTransform<T,N>::execute() {
-    detail::FFTWTraits<T>::execute(
-        reinterpret_cast<typename detail::FFTWTraits<T>::Plan>(_plan)
+    if (_forward) {
+        executePlan(_plan.get(), _xData, _kData);
+    } else {
+        executePlan(_plan.get(), _kData, _xData);
+    }
+}
+
+template <typename T, int N>
+template <int M, int C, int D>
+void FourierTransform<T,N>::execute(Array<ElementX,M,C> const & in, Array<ElementK,M,D> const & out) {
+    NDARRAY_ASSERT(_forward || (boost::is_same<ElementX,ElementK>::value));
+    executeArrays(
+        in.getData(), in.getShape(), in.getStrides(),
+        out.getData(), out.getShape(), out.getStrides()
     );
 }
 
 template <typename T, int N>
-FourierTransform<T,N>::~FourierTransform() {
-    detail::FFTWTraits<T>::destroy(
-        reinterpret_cast<typename detail::FFTWTraits<T>::Plan>(_plan)
+template <int M, int C, int D>
+typename boost::disable_if_c<
+    (boost::is_same<typename FourierTransform<T,N>::ElementX,
+                    typename FourierTransform<T,N>::ElementK>::value && M > 0)
+>::type
+FourierTransform<T,N>::execute(Array<ElementK,M,C> const & in, Array<ElementX,M,D> const & out) {
+    NDARRAY_ASSERT(!_forward);
+    executeArrays(
+        in.getData(), in.getShape(), in.getStrides(),
+        out.getData(), out.getShape(), out.getStrides()
     );
 }
 
+template <typename T, int N>
+template <int M>
+Vector<int,N+1> FourierTransform<T,N>::makeBatchFirst(Vector<int,M> const & v, int axis, int fill) {
+    BOOST_STATIC_ASSERT(M == N || M == N + 1);
+    Vector<int,N+1> result;
+    if (M == N) {
+        result[0] = fill;
+        std::copy(v.begin(), v.begin() + N, result.begin() + 1);
+    } else {
+        result[0] = v[axis];
+        std::copy(v.begin(), v.begin() + axis, result.begin() + 1);
+        std::copy(v.begin() + axis + 1, v.end(), result.begin() + axis + 1);
+    }
+    return result;
+}
+
+template <typename T, int N>
+template <int M>
+void FourierTransform<T,N>::executeArrays(
+    void * in, Vector<int,M> const & inShape, Vector<int,M> const & inStrides,
+    void * out, Vector<int,M> const & outShape, Vector<int,M> const & outStrides
+) {
+    NDARRAY_ASSERT(M == N + 1 || _shape[0] == 1);
+    Vector<int,N+1> xShape = makeBatchFirst(_forward ? inShape : outShape, _axis, 1);
+    Vector<int,N+1> kShape = makeBatchFirst(_forward ? outShape : inShape, _axis, 1);
+    Vector<int,N+1> xStrides = makeBatchFirst(_forward ? inStrides : outStrides, _axis, 0);
+    Vector<int,N+1> kStrides = makeBatchFirst(_forward ? outStrides : inStrides, _axis, 0);
+    NDARRAY_ASSERT(xShape == _shape);
+    NDARRAY_ASSERT(std::equal(_shape.begin(), _shape.end() - 1, kShape.begin()));
+    NDARRAY_ASSERT(kShape[N] == detail::FourierTraits<T>::computeLastDimensionSize(_shape[N]));
+    if (_shape[0] == 1) xStrides[0] = kStrides[0] = 0;
+    void * x = _forward ? in : out;
+    void * k = _forward ? out : in;
+    typedef detail::FFTWTraits<T> Traits;
+    if (
+        xStrides == _xStrides && kStrides == _kStrides
+        && (x == k) == (reinterpret_cast<void*>(_xData) == reinterpret_cast<void*>(_kData))
+        && Traits::alignmentOf(x) == Traits::alignmentOf(_xData)
+        && Traits::alignmentOf(k) == Traits::alignmentOf(_kData)
+    ) {
+        executePlan(_plan.get(), in, out);
+        return;
+    }
+    boost::shared_ptr<void> plan = detail::FFTWPlanCache<T>::get(
+        detail::FFTWGuruPlanner<T>(
+            _forward, N, _shape.begin() + 1, _shape[0], xStrides.begin(), kStrides.begin()
+        ),
+        in, out, _options
+    );
+    executePlan(plan.get(), in, out);
+}
+
+template <typename T, int N>
+void FourierTransform<T,N>::executePlan(void * plan, void * in, void * out) {
+    typedef detail::FFTWTraits<T> Traits;
+    // Plans may have been created for other arrays, so we always use the new-array interface.
+    if (_forward) {
+        Traits::execute(
+            reinterpret_cast<typename Traits::Plan>(plan),
+            reinterpret_cast<ElementX*>(in), reinterpret_cast<ElementK*>(out)
+        );
+    } else {
+        Traits::execute(
+            reinterpret_cast<typename Traits::Plan>(plan),
+            reinterpret_cast<ElementK*>(in), reinterpret_cast<ElementX*>(out)
+        );
+    }
+}
+
+template <typename T>
+bool importWisdom(std::string const & filename) {
+    boost::detail::lightweight_mutex::scoped_lock lock(detail::getFFTWMutex());
+    return detail::FFTWTraits<T>::importWisdom(filename.c_str());
+}
+
+template <typename T>
+void exportWisdom(std::string const & filename) {
+    boost::detail::lightweight_mutex::scoped_lock lock(detail::getFFTWMutex());
+    if (!detail::FFTWTraits<T>::exportWisdom(filename.c_str())) {
+        throw std::runtime_error("Could not write FFTW wisdom to '" + filename + "'");
+    }
+}
+
+template <typename T>
+void forgetWisdom() {
+    boost::detail::lightweight_mutex::scoped_lock lock(detail::getFFTWMutex());
+    detail::FFTWTraits<T>::forgetWisdom();
+}
+
+template <typename T>
+void clearPlanCache() {
+    detail::FFTWPlanCache<T>::clear();
+}
+
 } // namespace ndarray
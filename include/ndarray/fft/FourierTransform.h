@@ -17,13 +17,53 @@
  *  @brief Definitions for FourierTransform.
  */
 
+#include <string>
 #include <boost/noncopyable.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/is_same.hpp>
 
 #include "ndarray.h"
 #include "ndarray/fft/FourierTraits.h"
 
 namespace ndarray {
 
+/**
+ *  @ingroup FFTGroup
+ *  @brief How hard the FFTW planner searches for a fast plan (FFTW_ESTIMATE ... FFTW_EXHAUSTIVE).
+ */
+enum PlannerRigorEnum { PLAN_ESTIMATE=0, PLAN_MEASURE=1, PLAN_PATIENT=2, PLAN_EXHAUSTIVE=3 };
+
+/**
+ *  @ingroup FFTGroup
+ *  @brief Options that control how FourierTransform creates FFTW plans.
+ *
+ *  Plans created with different options are cached separately.
+ */
+struct PlannerOptions {
+    /// How hard to search for a fast plan; anything but PLAN_ESTIMATE runs trial transforms.
+    PlannerRigorEnum rigor;
+
+    /**
+     *  If true, executing the plan does not modify its input array.  FFTW has no
+     *  input-preserving algorithms for multidimensional real inverse transforms, so
+     *  creating one of those with this option throws std::runtime_error.
+     */
+    bool preserveInput;
+
+    /// Approximate upper bound on the time spent planning, in seconds (negative for none).
+    double timeLimit;
+
+    /**
+     *  Maximum number of threads a plan may use.  This requires FFTW's threads library, and
+     *  is ignored unless NDARRAY_FFTW_THREADS is defined (the build defines it when the
+     *  library is found).
+     */
+    int threads;
+
+    explicit PlannerOptions(PlannerRigorEnum rigor_=PLAN_MEASURE)
+        : rigor(rigor_), preserveInput(false), timeLimit(-1.0), threads(1) {}
+};
+
 /**
  *  @ingroup FFTGroup
  *  @brief A wrapper for FFTW plans for fast Fourier transforms.
@@ -32,11 +72,20 @@ namespace ndarray {
  *  inverse FFTs of predetermined arrays.
  *
  *  Multiplex plans can also be generated to perform an N-dimensional FFT on the nested arrays
- *  of an (N+1)-dimensional array.
+ *  of an (N+1)-dimensional array.  These may be contiguous arrays batched over their first
+ *  dimension, or arbitrarily strided views batched over any dimension (using FFTW's guru
+ *  interface), so e.g. every other plane of a larger array can be transformed without a copy.
  *
  *  Static member functions of FourierTransform are used to create instances, and optionally
  *  initialize the involved arrays.
  *
+ *  Plans are kept in a process-wide cache keyed by transform type, shape, multiplex count,
+ *  strides, alignment and PlannerOptions, so creating a FourierTransform for a combination
+ *  that has been seen before is cheap.  PLAN_MEASURE, PLAN_PATIENT and PLAN_EXHAUSTIVE plans
+ *  run trial transforms, so they are created on scratch memory; PLAN_ESTIMATE plans are
+ *  created directly on the caller's arrays, which FFTW does not touch in that mode.  Either
+ *  way, the arrays passed to the plan functions are never modified by planning.  Use
+ *  importWisdom() and exportWisdom() to carry FFTW's measurements across processes.
  */
 template <typename T, int N>
 class FourierTransform : private boost::noncopyable {
@@ -58,49 +107,89 @@ public:
     /**
      *  @brief Create a plan for forward-transforming a single N-dimensional array.
      *   
-     *  Arrays will be initialized with new memory if empty.  If they are not empty,
-     *  existing data may be overwritten when the plan is created.
+     *  Arrays will be initialized with new memory if empty.  Existing data is not modified
+     *  when the plan is created, but executing the plan destroys the input array unless
+     *  options.preserveInput is set.
      */
     static Ptr planForward(
         Index const & shape,  ///< Shape of the real-space array.
         ArrayX & x,           ///< Input real-space array.
-        ArrayK & k            ///< Output Fourier-space array.
+        ArrayK & k,           ///< Output Fourier-space array.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
     );
 
     /**
      *  @brief Create a plan for inverse-transforming a single N-dimensional array.
      *   
-     *  Arrays will be initialized with new memory if empty.  If they are not empty,
-     *  existing data may be overwritten when the plan is created.
+     *  Arrays will be initialized with new memory if empty.  Existing data is not modified
+     *  when the plan is created, but executing the plan destroys the input array unless
+     *  options.preserveInput is set.
      */
     static Ptr planInverse(
         Index const & shape,  ///< Shape of the real-space array.
         ArrayK & k,           ///< Input Fourier-space array.
-        ArrayX & x            ///< Output real-space array.
+        ArrayX & x,           ///< Output real-space array.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
     );
 
     /**
      *  @brief Create a plan for forward-transforming a sequence of nested N-dimensional arrays.
      *   
-     *  Arrays will be initialized with new memory if empty.  If they are not empty,
-     *  existing data may be overwritten when the plan is created.
+     *  Arrays will be initialized with new memory if empty.  Existing data is not modified
+     *  when the plan is created, but executing the plan destroys the input array unless
+     *  options.preserveInput is set.
      */
     static Ptr planMultiplexForward(
         MultiplexIndex const & shape, ///< Shape of the real-space array. First dimension is multiplexed.
         MultiplexArrayX & x,          ///< Input real-space array.
-        MultiplexArrayK & k           ///< Output Fourier-space array.
+        MultiplexArrayK & k,          ///< Output Fourier-space array.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
     );
 
     /**
      *  @brief Create a plan for inverse-transforming a sequence of nested N-dimensional arrays.
      *   
-     *  Arrays will be initialized with new memory if empty.  If they are not empty,
-     *  existing data may be overwritten when the plan is created.
+     *  Arrays will be initialized with new memory if empty.  Existing data is not modified
+     *  when the plan is created, but executing the plan destroys the input array unless
+     *  options.preserveInput is set.
      */
     static Ptr planMultiplexInverse(
         MultiplexIndex const & shape, ///< Shape of the real-space array. First dimension is multiplexed.
         MultiplexArrayK & k,          ///< Input Fourier-space array.
-        MultiplexArrayX & x           ///< Output real-space array.
+        MultiplexArrayX & x,          ///< Output real-space array.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
+    );
+
+    /**
+     *  @brief Create a plan for forward-transforming the N-dimensional arrays nested along any
+     *         dimension of a pair of strided (N+1)-dimensional arrays.
+     *
+     *  The arrays are views of existing memory and must not be empty; the Fourier-space array's
+     *  last transform dimension has the usual reduced size.  They may share memory for an
+     *  in-place transform, as created by initializeInPlace().  Existing data is not modified
+     *  when the plan is created, but executing the plan destroys the input array unless
+     *  options.preserveInput is set.
+     */
+    template <int C, int D>
+    static Ptr planMultiplexForward(
+        Array<ElementX,N+1,C> const & x, ///< Input real-space array.
+        Array<ElementK,N+1,D> const & k, ///< Output Fourier-space array.
+        int axis=0,                      ///< Dimension to multiplex over.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
+    );
+
+    /**
+     *  @brief Create a plan for inverse-transforming the N-dimensional arrays nested along any
+     *         dimension of a pair of strided (N+1)-dimensional arrays.
+     *
+     *  @copydetails planMultiplexForward(Array<ElementX,N+1,C> const &, Array<ElementK,N+1,D> const &, int, PlannerOptions const &)
+     */
+    template <int C, int D>
+    static Ptr planMultiplexInverse(
+        Array<ElementK,N+1,C> const & k, ///< Input Fourier-space array.
+        Array<ElementX,N+1,D> const & x, ///< Output real-space array.
+        int axis=0,                      ///< Dimension to multiplex over.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
     );
 
     /// @brief Create a new real-space array with the given real-space shape.
@@ -119,23 +208,125 @@ public:
     template <int M>
     static void initialize(Vector<int,M> const & shape, Array<ElementX,M,M> & x, Array<ElementK,M,M> & k);
 
+    /**
+     *  @brief Create a Fourier-space array and a real-space view of the same memory, for
+     *         in-place transforms with the given real-space shape.
+     *
+     *  For real-data transforms, the rows of the real-space view are padded to the length of
+     *  the Fourier-space rows, so they are not contiguous.
+     */
+    template <int M>
+    static void initializeInPlace(
+        Vector<int,M> const & shape, Array<ElementX,M,1> & x, Array<ElementK,M,M> & k
+    );
+
     /// @brief Execute the FFTW plan.
     void execute();
 
-    ~FourierTransform();
+    /**
+     *  @brief Execute the plan on a different pair of arrays.
+     *
+     *  The arrays must have the shapes of the arrays the plan was created with; M is N+1 for
+     *  multiplex plans (N is also allowed if the plan multiplexes a single array).  For a
+     *  complex inverse transform, @c in is the Fourier-space array.
+     *
+     *  Multiplexed arrays are batched over the same dimension as the planned arrays.
+     *
+     *  If the arrays' alignment, strides or in-place-ness differ from those of the planned
+     *  arrays, an equivalent plan is obtained from the plan cache (and measured on scratch
+     *  memory the first time such arrays are seen); the arrays are never copied.
+     */
+    template <int M, int C, int D>
+    void execute(Array<ElementX,M,C> const & in, Array<ElementK,M,D> const & out);
+
+    /**
+     *  @brief Execute a real-data inverse plan on a different pair of arrays.
+     *
+     *  @copydetails execute(Array<ElementX,M,C> const &, Array<ElementK,M,D> const &)
+     */
+    template <int M, int C, int D>
+    typename boost::disable_if_c<(boost::is_same<ElementX,ElementK>::value && M > 0)>::type
+    execute(Array<ElementK,M,C> const & in, Array<ElementX,M,D> const & out);
 
 private:
     typedef boost::shared_ptr<ElementX> OwnerX;
     typedef boost::shared_ptr<ElementK> OwnerK;
 
-    FourierTransform(void * plan, Manager::Ptr const & x, Manager::Ptr const & k)
-        : _plan(plan), _x(x), _k(k) {}
+    FourierTransform(
+        boost::shared_ptr<void> const & plan, bool forward, int axis, Vector<int,N+1> const & shape,
+        ElementX * xData, Vector<int,N+1> const & xStrides, Manager::Ptr const & x,
+        ElementK * kData, Vector<int,N+1> const & kStrides, Manager::Ptr const & k,
+        PlannerOptions const & options
+    ) : _plan(plan), _forward(forward), _axis(axis), _shape(shape),
+        _xData(xData), _kData(kData), _xStrides(xStrides), _kStrides(kStrides),
+        _x(x), _k(k), _options(options)
+    {
+        if (_shape[0] == 1) _xStrides[0] = _kStrides[0] = 0;
+    }
+
+    template <int M>
+    static Vector<int,N+1> makeBatchFirst(Vector<int,M> const & v, int axis, int fill);
+
+    template <int M>
+    void executeArrays(
+        void * in, Vector<int,M> const & inShape, Vector<int,M> const & inStrides,
+        void * out, Vector<int,M> const & outShape, Vector<int,M> const & outStrides
+    );
 
-    void * _plan; // 'void' so we don't have to include fftw3.h in the header file
+    void executePlan(void * plan, void * in, void * out);
+
+    boost::shared_ptr<void> _plan; // 'void' so we don't have to include fftw3.h in the header file
+    bool _forward;
+    int _axis;               // dimension of multiplexed arrays holding the nested arrays
+    Vector<int,N+1> _shape;  // multiplex count (1 for single plans), then the transform shape
+    ElementX * _xData;
+    ElementK * _kData;
+    Vector<int,N+1> _xStrides; // multiplex stride (0 for single plans), then transform strides
+    Vector<int,N+1> _kStrides;
     Manager::Ptr _x;
     Manager::Ptr _k;
+    PlannerOptions _options;
 };
 
+/**
+ *  @ingroup FFTGroup
+ *  @brief Load FFTW wisdom from a file, as written by exportWisdom().
+ *
+ *  Wisdom is shared by all transforms with the same precision, so importWisdom<double> and
+ *  importWisdom< std::complex<double> > are equivalent.
+ *
+ *  @returns false if the file could not be read or parsed (e.g. on first startup).
+ */
+template <typename T>
+bool importWisdom(std::string const & filename);
+
+/**
+ *  @ingroup FFTGroup
+ *  @brief Save all FFTW wisdom accumulated with the precision of T to a file.
+ *
+ *  @throw std::runtime_error if the file cannot be written.
+ */
+template <typename T>
+void exportWisdom(std::string const & filename);
+
+/**
+ *  @ingroup FFTGroup
+ *  @brief Discard all FFTW wisdom accumulated with the precision of T.
+ *
+ *  Existing plans, including those in the plan cache, remain valid.
+ */
+template <typename T>
+void forgetWisdom();
+
+/**
+ *  @ingroup FFTGroup
+ *  @brief Release the plan cache's references to all plans for transforms of type T.
+ *
+ *  Plans still held by a FourierTransform are destroyed when it is.
+ */
+template <typename T>
+void clearPlanCache();
+
 } // namespace ndarray
 
 #endif // !NDARRAY_FFT_FourierTransform_h_INCLUDED
@@ -0,0 +1,146 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#include <algorithm>
+
+#include "ndarray/fft/FFTWPlanCache.h"
+#include "ndarray/fft/RealToRealTransform.h"
+
+namespace ndarray {
+
+template <typename T, int N>
+typename RealToRealTransform<T,N>::Ptr
+RealToRealTransform<T,N>::plan(
+    Index const & shape,
+    Kinds const & kinds,
+    ArrayT & in,
+    ArrayT & out,
+    PlannerOptions const & options
+) {
+    if (in.empty()) in = FourierTransform<T,N>::initializeX(shape);
+    if (out.empty()) out = FourierTransform<T,N>::initializeX(shape);
+    NDARRAY_ASSERT(in.getShape() == shape);
+    NDARRAY_ASSERT(out.getShape() == shape);
+    Vector<int,N> fftwKinds = makeFFTWKinds(kinds);
+    return Ptr(
+        new RealToRealTransform(
+            detail::FFTWPlanCache<T>::getRealToReal(
+                N, shape.begin(), 1,
+                in.getData(), 0,
+                out.getData(), 0,
+                fftwKinds.begin(), options
+            ),
+            concatenate(1, shape), fftwKinds,
+            in.getData(), 0, in.getManager(),
+            out.getData(), 0, out.getManager(),
+            options
+        )
+    );
+}
+
+template <typename T, int N>
+typename RealToRealTransform<T,N>::Ptr
+RealToRealTransform<T,N>::planMultiplex(
+    MultiplexIndex const & shape,
+    Kinds const & kinds,
+    MultiplexArrayT & in,
+    MultiplexArrayT & out,
+    PlannerOptions const & options
+) {
+    if (in.empty()) in = FourierTransform<T,N>::initializeX(shape);
+    if (out.empty()) out = FourierTransform<T,N>::initializeX(shape);
+    NDARRAY_ASSERT(in.getShape() == shape);
+    NDARRAY_ASSERT(out.getShape() == shape);
+    Vector<int,N> fftwKinds = makeFFTWKinds(kinds);
+    return Ptr(
+        new RealToRealTransform(
+            detail::FFTWPlanCache<T>::getRealToReal(
+                N, shape.begin()+1, shape[0],
+                in.getData(), in.template getStride<0>(),
+                out.getData(), out.template getStride<0>(),
+                fftwKinds.begin(), options
+            ),
+            shape, fftwKinds,
+            in.getData(), in.template getStride<0>(), in.getManager(),
+            out.getData(), out.template getStride<0>(), out.getManager(),
+            options
+        )
+    );
+}
+
+template <typename T, int N>
+RealToRealKindEnum RealToRealTransform<T,N>::getInverseKind(RealToRealKindEnum kind) {
+    switch (kind) {
+    case DCT_II: return DCT_III;
+    case DCT_III: return DCT_II;
+    case DST_II: return DST_III;
+    case DST_III: return DST_II;
+    default: return kind;
+    }
+}
+
+template <typename T, int N>
+double RealToRealTransform<T,N>::computeNormalization(Index const & shape, Kinds const & kinds) {
+    double result = 1.0;
+    for (int d = 0; d < N; ++d) {
+        switch (kinds[d]) {
+        case DCT_I: result *= 2.0 * (shape[d] - 1); break;
+        case DST_I: result *= 2.0 * (shape[d] + 1); break;
+        default: result *= 2.0 * shape[d];
+        }
+    }
+    return result;
+}
+
+template <typename T, int N>
+Vector<int,N> RealToRealTransform<T,N>::makeFFTWKinds(Kinds const & kinds) {
+    static int const fftwKinds[] = {
+        FFTW_REDFT00, FFTW_REDFT10, FFTW_REDFT01, FFTW_REDFT11,
+        FFTW_RODFT00, FFTW_RODFT10, FFTW_RODFT01, FFTW_RODFT11
+    };
+    Vector<int,N> result;
+    for (int d = 0; d < N; ++d) result[d] = fftwKinds[kinds[d]];
+    return result;
+}
+
+template <typename T, int N>
+void RealToRealTransform<T,N>::execute() {
+    typedef detail::FFTWTraits<T> Traits;
+    Traits::execute(reinterpret_cast<typename Traits::Plan>(_plan.get()), _inData, _outData);
+}
+
+template <typename T, int N>
+template <int M>
+void RealToRealTransform<T,N>::execute(Array<Element,M,M> const & in, Array<Element,M,M> const & out) {
+    BOOST_STATIC_ASSERT(M == N || M == N + 1);
+    NDARRAY_ASSERT(M == N + 1 || _shape[0] == 1);
+    NDARRAY_ASSERT(M == N || in.template getSize<0>() == _shape[0]);
+    NDARRAY_ASSERT(std::equal(_shape.begin() + 1, _shape.end(), in.getShape().begin() + (M - N)));
+    NDARRAY_ASSERT(in.getShape() == out.getShape());
+    int inDist = in.template getStride<0>();
+    int outDist = out.template getStride<0>();
+    if (M == N || _shape[0] == 1) inDist = outDist = 0;
+    typedef detail::FFTWTraits<T> Traits;
+    boost::shared_ptr<void> plan = _plan;
+    if (
+        inDist != _inDist || outDist != _outDist
+        || (in.getData() == out.getData()) != (_inData == _outData)
+        || Traits::alignmentOf(in.getData()) != Traits::alignmentOf(_inData)
+        || Traits::alignmentOf(out.getData()) != Traits::alignmentOf(_outData)
+    ) {
+        plan = detail::FFTWPlanCache<T>::getRealToReal(
+            N, _shape.begin() + 1, _shape[0],
+            in.getData(), inDist, out.getData(), outDist, _fftwKinds.begin(), _options
+        );
+    }
+    Traits::execute(reinterpret_cast<typename Traits::Plan>(plan.get()), in.getData(), out.getData());
+}
+
+} // namespace ndarray
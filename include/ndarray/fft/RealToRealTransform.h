@@ -0,0 +1,153 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_FFT_RealToRealTransform_h_INCLUDED
+#define NDARRAY_FFT_RealToRealTransform_h_INCLUDED
+
+/** 
+ *  @file ndarray/fft/RealToRealTransform.h
+ *
+ *  @brief Definitions for RealToRealTransform.
+ */
+
+#include "ndarray/fft/FourierTransform.h"
+
+namespace ndarray {
+
+/**
+ *  @ingroup FFTGroup
+ *  @brief The real-to-real transform types of RealToRealTransform (FFTW's REDFT and RODFT kinds).
+ *
+ *  All are unnormalized: applying a transform and then its inverse multiplies the data by the
+ *  logical size 2(n-1) for DCT_I, 2(n+1) for DST_I and 2n for the others.  DCT_I, DCT_IV, DST_I
+ *  and DST_IV are their own inverses; DCT_III inverts DCT_II and DST_III inverts DST_II.
+ */
+enum RealToRealKindEnum {
+    DCT_I,   ///< FFTW_REDFT00; even around j=0 and even around j=n-1.
+    DCT_II,  ///< FFTW_REDFT10; even around j=-0.5 and even around j=n-0.5 ("the" DCT).
+    DCT_III, ///< FFTW_REDFT01; even around j=0 and odd around j=n ("the" inverse DCT).
+    DCT_IV,  ///< FFTW_REDFT11; even around j=-0.5 and odd around j=n-0.5.
+    DST_I,   ///< FFTW_RODFT00; odd around j=-1 and odd around j=n.
+    DST_II,  ///< FFTW_RODFT10; odd around j=-0.5 and odd around j=n-0.5.
+    DST_III, ///< FFTW_RODFT01; odd around j=-1 and even around j=n-1.
+    DST_IV   ///< FFTW_RODFT11; odd around j=-0.5 and even around j=n-0.5.
+};
+
+/**
+ *  @ingroup FFTGroup
+ *  @brief A wrapper for FFTW plans for real-to-real (discrete cosine and sine) transforms.
+ *
+ *  RealToRealTransform is the real-to-real counterpart of FourierTransform: plans are created
+ *  by static member functions that allocate empty arrays with FourierTransform::initializeX,
+ *  share FourierTransform's process-wide plan cache and PlannerOptions, and may multiplex an
+ *  N-dimensional transform over the first dimension of an (N+1)-dimensional array.  Each
+ *  dimension has its own transform kind.
+ *
+ *  T must be a real floating-point type; complex-to-complex transforms are provided by
+ *  FourierTransform< std::complex<U>, N >.
+ */
+template <typename T, int N>
+class RealToRealTransform : private boost::noncopyable {
+    BOOST_STATIC_ASSERT((!boost::is_const<T>::value));
+public:
+
+    typedef boost::shared_ptr<RealToRealTransform> Ptr;
+
+    typedef T Element; ///< Array data type.
+
+    typedef Vector<int,N> Index; ///< Shape type for arrays.
+    typedef Vector<int,N> Kinds; ///< RealToRealKindEnum values, one per dimension.
+    typedef Array<Element,N,N> ArrayT; ///< Array type.
+    typedef Vector<int,N+1> MultiplexIndex; ///< Shape type for multiplexed arrays.
+    typedef Array<Element,N+1,N+1> MultiplexArrayT; ///< Multiplexed array type.
+
+    /**
+     *  @brief Create a plan for transforming a single N-dimensional array.
+     *
+     *  Arrays will be initialized with new memory if empty, and may be the same array for an
+     *  in-place transform.  Existing data is not modified when the plan is created, but
+     *  executing the plan destroys the input array unless options.preserveInput is set.
+     */
+    static Ptr plan(
+        Index const & shape, ///< Shape of the arrays.
+        Kinds const & kinds, ///< Transform kind for each dimension.
+        ArrayT & in,         ///< Input array.
+        ArrayT & out,        ///< Output array.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
+    );
+
+    /**
+     *  @brief Create a plan for transforming a sequence of nested N-dimensional arrays.
+     *
+     *  @copydetails plan()
+     */
+    static Ptr planMultiplex(
+        MultiplexIndex const & shape, ///< Shape of the arrays. First dimension is multiplexed.
+        Kinds const & kinds,          ///< Transform kind for each non-multiplexed dimension.
+        MultiplexArrayT & in,         ///< Input array.
+        MultiplexArrayT & out,        ///< Output array.
+        PlannerOptions const & options=PlannerOptions() ///< How to create the plan.
+    );
+
+    /// @brief Return the transform kind that inverts the given one (up to normalization).
+    static RealToRealKindEnum getInverseKind(RealToRealKindEnum kind);
+
+    /**
+     *  @brief Return the factor by which a transform followed by its inverse scales the data.
+     *
+     *  This is the product of the logical (periodic) sizes of all dimensions.
+     */
+    static double computeNormalization(Index const & shape, Kinds const & kinds);
+
+    /// @brief Execute the FFTW plan.
+    void execute();
+
+    /**
+     *  @brief Execute the plan on a different pair of arrays.
+     *
+     *  The arrays must have the shape of the arrays the plan was created with; M is N+1 for
+     *  multiplex plans (N is also allowed if the plan multiplexes a single array).
+     *
+     *  If the arrays' alignment, strides or in-place-ness differ from those of the planned
+     *  arrays, an equivalent plan is obtained from the plan cache; the arrays are never copied.
+     */
+    template <int M>
+    void execute(Array<Element,M,M> const & in, Array<Element,M,M> const & out);
+
+private:
+
+    RealToRealTransform(
+        boost::shared_ptr<void> const & plan, Vector<int,N+1> const & shape,
+        Vector<int,N> const & fftwKinds,
+        Element * inData, int inDist, Manager::Ptr const & in,
+        Element * outData, int outDist, Manager::Ptr const & out,
+        PlannerOptions const & options
+    ) : _plan(plan), _shape(shape), _fftwKinds(fftwKinds),
+        _inData(inData), _outData(outData),
+        _inDist(shape[0] == 1 ? 0 : inDist), _outDist(shape[0] == 1 ? 0 : outDist),
+        _in(in), _out(out), _options(options) {}
+
+    static Vector<int,N> makeFFTWKinds(Kinds const & kinds);
+
+    boost::shared_ptr<void> _plan; // 'void' so we don't have to include fftw3.h in the header file
+    Vector<int,N+1> _shape;  // multiplex count (1 for single plans), then the transform shape
+    Vector<int,N> _fftwKinds;
+    Element * _inData;
+    Element * _outData;
+    int _inDist;
+    int _outDist;
+    Manager::Ptr _in;
+    Manager::Ptr _out;
+    PlannerOptions _options;
+};
+
+} // namespace ndarray
+
+#endif // !NDARRAY_FFT_RealToRealTransform_h_INCLUDED
@@ -38,6 +38,7 @@ template <typename T> struct FFTWTraits;
 } // namespace detail
 
 template <typename T, int N> class FourierTransform;
+template <typename T, int N> class RealToRealTransform;
 
 } // namespace ndarray
 
@@ -60,6 +60,37 @@ private:
     Vector<int,N> _shape;
 };
 
+template <int N>
+class AlignedInitializer : public Initializer< N, AlignedInitializer<N> > {
+public:
+
+    template <typename Target>
+    Target apply() const {
+        typedef detail::ArrayAccess< Target > Access;
+        typedef typename Access::Core Core;
+        typedef typename Access::Element Element;
+        int const rmc = ExpressionTraits< Target >::RMC::value;
+        DataOrderEnum order = (rmc < 0) ? COLUMN_MAJOR : ROW_MAJOR;
+        Vector<int,N> padded(_shape);
+        if (N > 1 && _policy.getPadRows() && (rmc == 0 || rmc == 1 || rmc == -1)
+            && _policy.getAlignment() % int(sizeof(Element)) == 0) {
+            // round the fastest dimension up so every row starts on an alignment boundary
+            int const fast = (order == ROW_MAJOR) ? N - 1 : 0;
+            int const block = _policy.getAlignment() / int(sizeof(Element));
+            padded[fast] = ((padded[fast] + block - 1) / block) * block;
+        }
+        std::pair<Manager::Ptr,Element*> p = AlignedManager<Element>::allocate(padded.product(), _policy);
+        return Access::construct(p.second, Core::create(_shape, computeStrides(padded, order), p.first));
+    }
+
+    AlignedInitializer(Vector<int,N> const & shape, AllocationPolicy const & policy) :
+        _shape(shape), _policy(policy) {}
+
+private:
+    Vector<int,N> _shape;
+    AllocationPolicy _policy;
+};
+
 template <typename T, int N, typename Owner>
 class ExternalInitializer : public Initializer< N, ExternalInitializer<T,N,Owner> > {
 public:
@@ -132,6 +163,42 @@ inline detail::SimpleInitializer<3> allocate(int n1, int n2, int n3) {
     return detail::SimpleInitializer<3>(ndarray::makeVector(n1, n2, n3)); 
 }
 
+/**
+ *  @brief Create an expression that allocates uninitialized memory for an array according
+ *         to the given AllocationPolicy.
+ *
+ *  @returns A temporary object convertible to an Array with row-major strides (column-major
+ *           for column-major Array types), which are contiguous unless rows are padded.
+ */
+template <int N>
+inline detail::AlignedInitializer<N> allocate(Vector<int,N> const & shape, AllocationPolicy const & policy) {
+    return detail::AlignedInitializer<N>(shape, policy);
+}
+
+/**
+ *  @brief Create an expression that allocates uninitialized memory for a 1-d array according
+ *         to the given AllocationPolicy.
+ */
+inline detail::AlignedInitializer<1> allocate(int n, AllocationPolicy const & policy) {
+    return detail::AlignedInitializer<1>(ndarray::makeVector(n), policy);
+}
+
+/**
+ *  @brief Create an expression that allocates uninitialized memory for a 2-d array according
+ *         to the given AllocationPolicy.
+ */
+inline detail::AlignedInitializer<2> allocate(int n1, int n2, AllocationPolicy const & policy) {
+    return detail::AlignedInitializer<2>(ndarray::makeVector(n1, n2), policy);
+}
+
+/**
+ *  @brief Create an expression that allocates uninitialized memory for a 3-d array according
+ *         to the given AllocationPolicy.
+ */
+inline detail::AlignedInitializer<3> allocate(int n1, int n2, int n3, AllocationPolicy const & policy) {
+    return detail::AlignedInitializer<3>(ndarray::makeVector(n1, n2, n3), policy);
+}
+
 /** 
  *  @brief Create a new Array by copying an Expression.
  */
@@ -249,6 +316,41 @@ inline detail::ExternalInitializer<T,N,detail::NullOwner> external(
     );
 }
 
+#ifdef NDARRAY_HAVE_MMAP
+
+/**
+ *  @brief Create a row-major contiguous Array backed by a memory-mapped file.
+ *
+ *  No data is read until it is accessed; the operating system pages it in on demand.
+ *  The element type should be const for MAPPED_READ_ONLY mappings, because writing to
+ *  read-only pages is undefined behavior.  The data is interpreted in native byte order.
+ *
+ *  @param[in] path    File to map.
+ *  @param[in] shape   Shape of the new Array.
+ *  @param[in] mode    Access mode; see MapModeEnum.  MAPPED_READ_WRITE creates or extends the file
+ *                     as necessary.
+ *  @param[in] offset  Offset in bytes of the first element from the start of the file (for
+ *                     instance, to skip a header).  Should be a multiple of sizeof(T).
+ *
+ *  @throw std::runtime_error if the file cannot be mapped.
+ */
+template <typename T, int N>
+Array<T,N,N> mapFile(
+    std::string const & path,
+    Vector<int,N> const & shape,
+    MapModeEnum mode = MAPPED_READ_ONLY,
+    std::size_t offset = 0
+) {
+    typedef detail::ArrayAccess< Array<T,N,N> > Access;
+    typedef typename Access::Core Core;
+    std::pair<Manager::Ptr,void*> p = MappedManager::map(
+        path, offset, std::size_t(shape.product()) * sizeof(T), mode
+    );
+    return Access::construct(static_cast<T*>(p.second), Core::create(shape, ROW_MAJOR, p.first));
+}
+
+#endif // NDARRAY_HAVE_MMAP
+
 /// @}
 
 template <typename T, int N, int C>
@@ -267,6 +369,13 @@ Array<T,N,C>::Array(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int
     this->operator=(ndarray::allocate(shape));
 }
 
+template <typename T, int N, int C>
+Array<T,N,C>::Array(Vector<int,N> const & shape, AllocationPolicy const & policy)
+    : Super(0, CorePtr())
+{
+    this->operator=(ndarray::allocate(shape, policy));
+}
+
 template <typename T, int N, int C>
 ArrayRef<T,N,C>::ArrayRef(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8)
     : Super(Array<T,N,C>(n1, n2, n3, n4, n5, n6, n7, n8))
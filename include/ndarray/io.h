@@ -0,0 +1,28 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_io_h_INCLUDED
+#define NDARRAY_io_h_INCLUDED
+
+/**
+ * @file ndarray/io.h
+ *
+ * @brief Main public header file for reading and writing array files.
+ *
+ *  \note This file is not included by the main "ndarray.h" header file.
+ */
+
+#include "ndarray.h"
+#include "ndarray/io/DType.h"
+#include "ndarray/io/ArrayFile.h"
+#include "ndarray/io/Native.h"
+#include "ndarray/io/Npy.h"
+
+#endif // !NDARRAY_io_h_INCLUDED
@@ -0,0 +1,327 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_IO_ArrayFile_h_INCLUDED
+#define NDARRAY_IO_ArrayFile_h_INCLUDED
+
+/**
+ *  @file ndarray/io/ArrayFile.h
+ *
+ *  @brief Machinery shared by the array file formats: streaming writers, bulk readers,
+ *         and mapped readers.
+ *
+ *  Each format is a class with two static member functions:
+ *   - writeHeader(std::ostream &, DType const &, std::vector<int> const & shape) writes
+ *     everything before the data of a row-major contiguous array;
+ *   - readHeader(std::istream &) returns an ArrayFileHeader and leaves the stream at the
+ *     start of the data.
+ */
+
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/mpl/int.hpp>
+
+#include "ndarray.h"
+#include "ndarray/io/DType.h"
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief The layout of an array as described by a file header.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Strides are in elements; dataOffset is the position of the first element in bytes
+ *  from the start of the file.
+ */
+struct ArrayFileHeader {
+    DType dtype;
+    std::vector<int> shape;
+    std::vector<int> strides;
+    std::size_t dataOffset;
+};
+
+/// @internal @brief Throw std::runtime_error if the last stream operation failed.
+inline void checkStream(std::ios const & stream, char const * what) {
+    if (!stream) throw std::runtime_error(what);
+}
+
+/// @internal @brief Write an unsigned integer as the given number of little-endian bytes.
+inline void writeLittleEndian(std::ostream & stream, boost::uint64_t value, int nBytes) {
+    char buffer[8];
+    for (int i = 0; i < nBytes; ++i) buffer[i] = char((value >> (8 * i)) & 0xFF);
+    stream.write(buffer, nBytes);
+}
+
+/// @internal @brief Read an unsigned integer from the given number of little-endian bytes.
+inline boost::uint64_t readLittleEndian(std::istream & stream, int nBytes) {
+    unsigned char buffer[8];
+    stream.read(reinterpret_cast<char*>(buffer), nBytes);
+    checkStream(stream, "Unexpected end of array file header");
+    boost::uint64_t r = 0;
+    for (int i = nBytes - 1; i >= 0; --i) r = (r << 8) | buffer[i];
+    return r;
+}
+
+/// @internal @brief Return true if the given dimensions are contiguous in the order required by RMC.
+template <int C, int N>
+inline bool hasRMC(Vector<int,N> const & shape, Vector<int,N> const & strides) {
+    return hasRMC(C, N, shape.begin(), strides.begin());
+}
+
+/**
+ *  @internal @brief Buffers elements of an expression and writes them to a stream in blocks.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T>
+class ElementWriter {
+public:
+
+    ElementWriter(std::ostream & stream, DType const & dtype) :
+        _stream(stream), _swapSize(dtype.bigEndian != isBigEndian() ? dtype.getSwapSize() : 0)
+    {
+        _buffer.reserve(BUFFER_SIZE);
+    }
+
+    void push(T const & value) {
+        _buffer.push_back(value);
+        if (int(_buffer.size()) == BUFFER_SIZE) flush();
+    }
+
+    /// @brief Write n contiguous elements, bypassing the buffer when no byte swapping is needed.
+    void write(T const * data, std::size_t n) {
+        if (_swapSize) {
+            for (std::size_t i = 0; i < n; ++i) push(data[i]);
+        } else {
+            flush();
+            _stream.write(reinterpret_cast<char const *>(data), n * sizeof(T));
+        }
+    }
+
+    void flush() {
+        if (_buffer.empty()) return;
+        if (_swapSize) swapBytes(&_buffer.front(), _buffer.size() * sizeof(T) / _swapSize, _swapSize);
+        _stream.write(reinterpret_cast<char const *>(&_buffer.front()), _buffer.size() * sizeof(T));
+        _buffer.clear();
+    }
+
+private:
+    enum { BUFFER_SIZE = 4096 };
+    std::ostream & _stream;
+    int _swapSize;
+    std::vector<T> _buffer;
+};
+
+template <typename Expression, typename T>
+inline void streamElements(Expression const & expr, ElementWriter<T> & writer, boost::mpl::int_<1>) {
+    typename Expression::Iterator const end = expr.end();
+    for (typename Expression::Iterator i = expr.begin(); i != end; ++i) writer.push(*i);
+}
+
+template <typename Expression, typename T, int N>
+inline void streamElements(Expression const & expr, ElementWriter<T> & writer, boost::mpl::int_<N>) {
+    typename Expression::Iterator const end = expr.end();
+    for (typename Expression::Iterator i = expr.begin(); i != end; ++i) {
+        streamElements(*i, writer, boost::mpl::int_<N-1>());
+    }
+}
+
+/// @internal @brief Write the elements of an expression in row-major order.
+template <typename Derived, typename T>
+inline void writeElements(ExpressionBase<Derived> const & expr, ElementWriter<T> & writer) {
+    streamElements(static_cast<Derived const &>(expr), writer, boost::mpl::int_<Derived::ND::value>());
+}
+
+/// @internal @brief Write the elements of an array in row-major order, in one block if possible.
+template <typename Derived, typename T>
+inline void writeElements(ArrayBase<Derived> const & array, ElementWriter<T> & writer) {
+    if (array.getStrides() == computeStrides(array.getShape())) {
+        writer.write(array.getData(), array.getNumElements());
+    } else {
+        streamElements(static_cast<Derived const &>(array), writer, boost::mpl::int_<Derived::ND::value>());
+    }
+}
+
+/**
+ *  @internal @brief Write an expression to a stream in the given format, without evaluating
+ *         it into a temporary array.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Format, typename Derived>
+void saveExpression(std::ostream & stream, ExpressionBase<Derived> const & expr) {
+    typedef typename boost::remove_const<typename ExpressionTraits<Derived>::Element>::type Value;
+    DType dtype = DTypeTraits<Value>::get(isBigEndian());
+    typename Derived::Index shape = expr.getShape();
+    Format::writeHeader(stream, dtype, std::vector<int>(shape.begin(), shape.end()));
+    ElementWriter<Value> writer(stream, dtype);
+    writeElements(static_cast<Derived const &>(expr), writer);
+    writer.flush();
+    checkStream(stream, "Failed to write array data");
+}
+
+/// @internal @brief Open a file and write an expression to it in the given format.
+template <typename Format, typename Derived>
+void saveExpression(std::string const & path, ExpressionBase<Derived> const & expr) {
+    std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!stream) throw std::runtime_error("Failed to open '" + path + "' for writing");
+    saveExpression<Format>(stream, expr);
+    stream.close();
+    checkStream(stream, "Failed to write array file");
+}
+
+/**
+ *  @internal @brief Validate a file header against the requested array type, returning its
+ *         shape and strides as Vectors.
+ */
+template <typename T, int N>
+void checkHeader(ArrayFileHeader const & header, Vector<int,N> & shape, Vector<int,N> & strides) {
+    if (int(header.shape.size()) != N) {
+        throw std::runtime_error("Number of dimensions in file does not match the requested type");
+    }
+    if (!header.dtype.isEquivalent(DTypeTraits<T>::get(false))) {
+        throw std::runtime_error("Element type in file does not match the requested type");
+    }
+    std::copy(header.shape.begin(), header.shape.end(), shape.begin());
+    std::copy(header.strides.begin(), header.strides.end(), strides.begin());
+    for (int n = 0; n < N; ++n) {
+        if (shape[n] < 0 || strides[n] < 0) throw std::runtime_error("Invalid shape or strides in file");
+    }
+    if (!isDense(shape, strides)) throw std::runtime_error("Array data in file is not contiguous");
+}
+
+/**
+ *  @internal @brief Read an array's data from a stream positioned at its start into a new
+ *         array with the requested element type and RMC.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  The data is read with a single bulk read into memory owned by a SimpleManager.  If its
+ *  memory order does not satisfy the requested RMC it is then copied into one that does.
+ */
+template <typename T, int N, int C>
+Array<T,N,C> readElements(std::istream & stream, ArrayFileHeader const & header) {
+    typedef typename boost::remove_const<T>::type U;
+    typedef detail::ArrayAccess< Array<U,N,0> > Access;
+    Vector<int,N> shape;
+    Vector<int,N> strides;
+    checkHeader<U>(header, shape, strides);
+    std::size_t const n = shape.product();
+    std::pair<Manager::Ptr,U*> p = SimpleManager<U>::allocate(n);
+    stream.read(reinterpret_cast<char*>(p.second), n * sizeof(U));
+    checkStream(stream, "Unexpected end of array data");
+    if (header.dtype.bigEndian != isBigEndian()) {
+        int const swapSize = header.dtype.getSwapSize();
+        swapBytes(p.second, n * sizeof(U) / swapSize, swapSize);
+    }
+    Array<U,N,0> file = Access::construct(p.second, Access::Core::create(shape, strides, p.first));
+    if (hasRMC<C>(shape, strides)) {
+        return detail::ArrayAccess< Array<T,N,C> >::construct(file.getData(), Access::getCore(file));
+    }
+    Array<U,N,C> r = allocate(shape);
+    r.deep() = file;
+    return r;
+}
+
+/**
+ *  @internal @brief Deferred bulk read of an array file, convertible to any Array type.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Nothing is read until the conversion, when the file's element type and number of
+ *  dimensions are checked against the target type.
+ */
+template <typename Format>
+class ArrayLoader {
+public:
+
+    explicit ArrayLoader(std::string const & path) : _path(path), _stream(0) {}
+
+    explicit ArrayLoader(std::istream & stream) : _path(), _stream(&stream) {}
+
+    template <typename T, int N, int C>
+    operator Array<T,N,C> () const {
+        if (_stream) return load<T,N,C>(*_stream);
+        std::ifstream stream(_path.c_str(), std::ios::binary);
+        if (!stream) throw std::runtime_error("Failed to open '" + _path + "' for reading");
+        return load<T,N,C>(stream);
+    }
+
+private:
+
+    template <typename T, int N, int C>
+    static Array<T,N,C> load(std::istream & stream) {
+        ArrayFileHeader header = Format::readHeader(stream);
+        return readElements<T,N,C>(stream, header);
+    }
+
+    std::string _path;
+    std::istream * _stream;
+};
+
+#ifdef NDARRAY_HAVE_MMAP
+
+/**
+ *  @internal @brief Deferred memory mapping of an array file, convertible to any Array type.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  The conversion throws std::runtime_error if the data is not in native byte order or its
+ *  memory order does not satisfy the target's RMC, as neither can be fixed without a copy.
+ */
+template <typename Format>
+class ArrayMapper {
+public:
+
+    ArrayMapper(std::string const & path, MapModeEnum mode) : _path(path), _mode(mode) {}
+
+    template <typename T, int N, int C>
+    operator Array<T,N,C> () const {
+        typedef detail::ArrayAccess< Array<T,N,C> > Access;
+        ArrayFileHeader header;
+        {
+            std::ifstream stream(_path.c_str(), std::ios::binary);
+            if (!stream) throw std::runtime_error("Failed to open '" + _path + "' for reading");
+            header = Format::readHeader(stream);
+        }
+        Vector<int,N> shape;
+        Vector<int,N> strides;
+        checkHeader<T>(header, shape, strides);
+        if (header.dtype.bigEndian != isBigEndian() && header.dtype.getSwapSize() > 1) {
+            throw std::runtime_error("Cannot map '" + _path + "': data is not in native byte order");
+        }
+        if (!hasRMC<C>(shape, strides)) {
+            throw std::runtime_error("Cannot map '" + _path + "': memory order does not match the array type");
+        }
+        std::pair<Manager::Ptr,void*> p = MappedManager::map(
+            _path, header.dataOffset, std::size_t(shape.product()) * sizeof(T), _mode
+        );
+        return Access::construct(static_cast<T*>(p.second), Access::Core::create(shape, strides, p.first));
+    }
+
+private:
+    std::string _path;
+    MapModeEnum _mode;
+};
+
+#endif // NDARRAY_HAVE_MMAP
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_IO_ArrayFile_h_INCLUDED
@@ -0,0 +1,108 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_IO_DType_h_INCLUDED
+#define NDARRAY_IO_DType_h_INCLUDED
+
+/**
+ *  @file ndarray/io/DType.h
+ *
+ *  @brief Runtime descriptions of array element types.
+ */
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+namespace ndarray {
+
+/**
+ *  @brief A runtime description of an array element type, using NumPy's conventions.
+ *
+ *  @ingroup MainGroup
+ */
+struct DType {
+    char kind;         ///< 'b' (bool), 'i' (signed integer), 'u' (unsigned integer), 'f' (float), 'c' (complex)
+    int size;          ///< Size of one element in bytes.
+    bool bigEndian;    ///< Byte order of the data described.
+
+    /// @brief Return the size of the units whose bytes must be reversed to change byte order.
+    int getSwapSize() const { return (kind == 'c') ? size / 2 : size; }
+
+    /// @brief Return true if the two types differ only in byte order.
+    bool isEquivalent(DType const & other) const { return kind == other.kind && size == other.size; }
+};
+
+/**
+ *  @brief Traits class mapping a C++ element type to a DType.
+ *
+ *  @ingroup MainGroup
+ *
+ *  Defined for all arithmetic types and std::complex of floating-point types (const is ignored).
+ */
+template <typename T>
+struct DTypeTraits {
+    typedef typename boost::remove_const<T>::type Value;
+    BOOST_STATIC_ASSERT(boost::is_arithmetic<Value>::value);
+
+    static DType get(bool bigEndian) {
+        DType r;
+        r.kind = boost::is_same<Value,bool>::value ? 'b'
+            : boost::is_floating_point<Value>::value ? 'f'
+            : boost::is_signed<Value>::value ? 'i' : 'u';
+        r.size = sizeof(Value);
+        r.bigEndian = bigEndian;
+        return r;
+    }
+};
+
+template <typename U>
+struct DTypeTraits< std::complex<U> > {
+    BOOST_STATIC_ASSERT(boost::is_floating_point<U>::value);
+
+    static DType get(bool bigEndian) {
+        DType r;
+        r.kind = 'c';
+        r.size = sizeof(std::complex<U>);
+        r.bigEndian = bigEndian;
+        return r;
+    }
+};
+
+template <typename U>
+struct DTypeTraits< std::complex<U> const > : public DTypeTraits< std::complex<U> > {};
+
+namespace detail {
+
+/// @internal @brief Return true if the native byte order is big-endian.
+inline bool isBigEndian() {
+    union { unsigned int i; unsigned char c[sizeof(unsigned int)]; } u;
+    u.i = 1;
+    return u.c[0] == 0;
+}
+
+/// @internal @brief Reverse the byte order of n units of the given size, in place.
+inline void swapBytes(void * data, std::size_t n, int unitSize) {
+    if (unitSize <= 1) return;
+    unsigned char * p = static_cast<unsigned char*>(data);
+    for (std::size_t i = 0; i < n; ++i, p += unitSize) std::reverse(p, p + unitSize);
+}
+
+} // namespace detail
+} // namespace ndarray
+
+#endif // !NDARRAY_IO_DType_h_INCLUDED
@@ -0,0 +1,165 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_IO_Native_h_INCLUDED
+#define NDARRAY_IO_Native_h_INCLUDED
+
+/**
+ *  @file ndarray/io/Native.h
+ *
+ *  @brief Reading and writing arrays in ndarray's native binary format.
+ *
+ *  A native array file consists of:
+ *   - the 8-byte magic string "\x89NDARRAY";
+ *   - one byte each for the format version (1), the element kind (as in DType), the element
+ *     size in bytes, and the byte order of the data ('<' or '>');
+ *   - the number of dimensions as a 4-byte unsigned integer;
+ *   - the offset of the data from the start of the file as an 8-byte unsigned integer;
+ *   - the shape, then the strides (in elements), each as 8-byte signed integers;
+ *   - zero padding up to the data offset, which is a multiple of 64 bytes;
+ *   - the data.
+ *  All integers in the header are little-endian, regardless of the byte order of the data.
+ */
+
+#include <cstring>
+
+#include "ndarray/io/ArrayFile.h"
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief Header reader and writer for the native array file format.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+struct NativeFormat {
+
+    enum { VERSION = 1, ALIGNMENT = 64 };
+
+    static char const * getMagic() { return "\x89NDARRAY"; }
+
+    static void writeHeader(std::ostream & stream, DType const & dtype, std::vector<int> const & shape) {
+        std::size_t const nDim = shape.size();
+        std::size_t const headerSize = 8 + 4 + 4 + 8 + 16 * nDim;
+        std::size_t const dataOffset = ((headerSize + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+        std::vector<int> strides(nDim, 1);
+        for (int n = int(nDim) - 1; n > 0; --n) strides[n-1] = strides[n] * shape[n];
+        stream.write(getMagic(), 8);
+        char const info[4] = { char(VERSION), dtype.kind, char(dtype.size), dtype.bigEndian ? '>' : '<' };
+        stream.write(info, 4);
+        writeLittleEndian(stream, nDim, 4);
+        writeLittleEndian(stream, dataOffset, 8);
+        for (std::size_t n = 0; n < nDim; ++n) writeLittleEndian(stream, boost::int64_t(shape[n]), 8);
+        for (std::size_t n = 0; n < nDim; ++n) writeLittleEndian(stream, boost::int64_t(strides[n]), 8);
+        std::vector<char> padding(dataOffset - headerSize, '\0');
+        if (!padding.empty()) stream.write(&padding.front(), padding.size());
+    }
+
+    static ArrayFileHeader readHeader(std::istream & stream) {
+        char magic[8];
+        stream.read(magic, 8);
+        checkStream(stream, "Unexpected end of array file header");
+        if (std::memcmp(magic, getMagic(), 8) != 0) throw std::runtime_error("Not a native ndarray file");
+        char info[4];
+        stream.read(info, 4);
+        checkStream(stream, "Unexpected end of array file header");
+        if (info[0] != char(VERSION)) throw std::runtime_error("Unsupported native ndarray file version");
+        if (info[3] != '<' && info[3] != '>') throw std::runtime_error("Invalid byte order in array file header");
+        ArrayFileHeader header;
+        header.dtype.kind = info[1];
+        header.dtype.size = static_cast<unsigned char>(info[2]);
+        header.dtype.bigEndian = (info[3] == '>');
+        std::size_t const nDim = readLittleEndian(stream, 4);
+        header.dataOffset = readLittleEndian(stream, 8);
+        std::size_t const headerSize = 8 + 4 + 4 + 8 + 16 * nDim;
+        if (nDim > 32 || header.dataOffset < headerSize) {
+            throw std::runtime_error("Invalid native ndarray file header");
+        }
+        header.shape.resize(nDim);
+        header.strides.resize(nDim);
+        for (std::size_t n = 0; n < nDim; ++n) header.shape[n] = int(boost::int64_t(readLittleEndian(stream, 8)));
+        for (std::size_t n = 0; n < nDim; ++n) header.strides[n] = int(boost::int64_t(readLittleEndian(stream, 8)));
+        stream.ignore(header.dataOffset - headerSize);
+        checkStream(stream, "Unexpected end of array file header");
+        return header;
+    }
+
+};
+
+} // namespace detail
+
+/// @addtogroup MainGroup
+/// @{
+
+/**
+ *  @brief Write an array or array expression to a stream in the native format.
+ *
+ *  Expressions are evaluated element by element as they are written, without a temporary array.
+ *
+ *  @throw std::runtime_error if writing fails.
+ */
+template <typename Derived>
+inline void saveArray(std::ostream & stream, ExpressionBase<Derived> const & expr) {
+    detail::saveExpression<detail::NativeFormat>(stream, expr);
+}
+
+/**
+ *  @brief Write an array or array expression to a file in the native format.
+ *
+ *  @throw std::runtime_error if the file cannot be opened or writing fails.
+ */
+template <typename Derived>
+inline void saveArray(std::string const & path, ExpressionBase<Derived> const & expr) {
+    detail::saveExpression<detail::NativeFormat>(path, expr);
+}
+
+/**
+ *  @brief Read a native-format array from a stream.
+ *
+ *  @returns A temporary object convertible to an Array with any element type matching the
+ *           file's and the file's number of dimensions.  The stream is read during the
+ *           conversion, which throws std::runtime_error on any mismatch or read failure.
+ */
+inline detail::ArrayLoader<detail::NativeFormat> loadArray(std::istream & stream) {
+    return detail::ArrayLoader<detail::NativeFormat>(stream);
+}
+
+/**
+ *  @brief Read a native-format array file with a single bulk read.
+ *
+ *  @returns A temporary object convertible to an Array; see loadArray(std::istream &).
+ */
+inline detail::ArrayLoader<detail::NativeFormat> loadArray(std::string const & path) {
+    return detail::ArrayLoader<detail::NativeFormat>(path);
+}
+
+#ifdef NDARRAY_HAVE_MMAP
+
+/**
+ *  @brief Map a native-format array file into memory without reading it.
+ *
+ *  @returns A temporary object convertible to an Array backed by a MappedManager.  The
+ *           conversion throws std::runtime_error if the file's element type, number of
+ *           dimensions, byte order or memory order are incompatible with the Array type.
+ */
+inline detail::ArrayMapper<detail::NativeFormat> mapArray(
+    std::string const & path, MapModeEnum mode = MAPPED_READ_ONLY
+) {
+    return detail::ArrayMapper<detail::NativeFormat>(path, mode);
+}
+
+#endif // NDARRAY_HAVE_MMAP
+
+/// @}
+
+} // namespace ndarray
+
+#endif // !NDARRAY_IO_Native_h_INCLUDED
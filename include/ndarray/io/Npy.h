@@ -0,0 +1,208 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_IO_Npy_h_INCLUDED
+#define NDARRAY_IO_Npy_h_INCLUDED
+
+/**
+ *  @file ndarray/io/Npy.h
+ *
+ *  @brief Reading and writing NumPy .npy files.
+ *
+ *  Versions 1.0, 2.0 and 3.0 of the format are read; files are written as version 1.0
+ *  unless the header is too large for it.  Only the simple numeric dtypes described by
+ *  DType are supported (no structured or object arrays).
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "ndarray/io/ArrayFile.h"
+
+namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief Header reader and writer for the NumPy .npy format.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+struct NpyFormat {
+
+    enum { ALIGNMENT = 64 };
+
+    static char const * getMagic() { return "\x93NUMPY"; }
+
+    static void writeHeader(std::ostream & stream, DType const & dtype, std::vector<int> const & shape) {
+        std::ostringstream dict;
+        dict << "{'descr': '" << (dtype.getSwapSize() == 1 ? '|' : (dtype.bigEndian ? '>' : '<'))
+             << dtype.kind << dtype.size << "', 'fortran_order': False, 'shape': (";
+        for (std::size_t n = 0; n < shape.size(); ++n) {
+            dict << shape[n] << ((shape.size() == 1 || n + 1 < shape.size()) ? "," : "");
+            if (n + 1 < shape.size()) dict << " ";
+        }
+        dict << "), }";
+        std::string header = dict.str();
+        // version 1.0 has a 2-byte header length; the total size including the trailing
+        // newline is padded with spaces to the alignment
+        int version = (header.size() + 11 + ALIGNMENT > 65535) ? 2 : 1;
+        std::size_t const prefix = (version == 1) ? 10 : 12;
+        std::size_t const total = ((prefix + header.size() + 1 + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+        header.append(total - prefix - header.size() - 1, ' ');
+        header.push_back('\n');
+        stream.write(getMagic(), 6);
+        char const versionBytes[2] = { char(version), 0 };
+        stream.write(versionBytes, 2);
+        writeLittleEndian(stream, header.size(), (version == 1) ? 2 : 4);
+        stream.write(header.data(), header.size());
+    }
+
+    static ArrayFileHeader readHeader(std::istream & stream) {
+        char magic[8];
+        stream.read(magic, 8);
+        checkStream(stream, "Unexpected end of .npy header");
+        if (std::memcmp(magic, getMagic(), 6) != 0) throw std::runtime_error("Not a .npy file");
+        int const version = magic[6];
+        if (version < 1 || version > 3) throw std::runtime_error("Unsupported .npy format version");
+        std::size_t const length = readLittleEndian(stream, (version == 1) ? 2 : 4);
+        std::string dict(length, ' ');
+        stream.read(&dict[0], length);
+        checkStream(stream, "Unexpected end of .npy header");
+
+        ArrayFileHeader header;
+        header.dataOffset = ((version == 1) ? 10 : 12) + length;
+        std::string const descr = getValue(dict, "descr");
+        if (descr.size() < 4 || (descr[0] != '\'' && descr[0] != '"')) {
+            throw std::runtime_error("Unsupported .npy dtype: " + descr);
+        }
+        char const order = descr[1];
+        if (order != '<' && order != '>' && order != '|' && order != '=') {
+            throw std::runtime_error("Unsupported .npy dtype: " + descr);
+        }
+        header.dtype.kind = descr[2];
+        header.dtype.size = std::atoi(descr.c_str() + 3);
+        header.dtype.bigEndian = (order == '>') || (order == '=' && isBigEndian());
+        if (std::strchr("biufc", header.dtype.kind) == 0 || header.dtype.size <= 0) {
+            throw std::runtime_error("Unsupported .npy dtype: " + descr);
+        }
+        bool const fortranOrder = getValue(dict, "fortran_order").compare(0, 4, "True") == 0;
+        std::string const shape = getValue(dict, "shape");
+        if (shape.empty() || shape[0] != '(') throw std::runtime_error("Invalid .npy shape: " + shape);
+        char const * p = shape.c_str() + 1;
+        while (true) {
+            while (*p == ' ' || *p == ',') ++p;
+            if (*p == ')' || *p == '\0') break;
+            char * end = 0;
+            long n = std::strtol(p, &end, 10);
+            if (end == p) throw std::runtime_error("Invalid .npy shape: " + shape);
+            header.shape.push_back(int(n));
+            p = end;
+        }
+        std::size_t const nDim = header.shape.size();
+        header.strides.resize(nDim, 1);
+        if (fortranOrder) {
+            for (std::size_t n = 1; n < nDim; ++n) header.strides[n] = header.strides[n-1] * header.shape[n-1];
+        } else {
+            for (int n = int(nDim) - 1; n > 0; --n) header.strides[n-1] = header.strides[n] * header.shape[n];
+        }
+        return header;
+    }
+
+private:
+
+    // Return the text of the value for the given key in a Python dict literal, up to (not
+    // including) the comma or brace that ends it.
+    static std::string getValue(std::string const & dict, char const * key) {
+        std::string::size_type i = dict.find(std::string("'") + key + "'");
+        if (i == std::string::npos) i = dict.find(std::string("\"") + key + "\"");
+        if (i == std::string::npos) throw std::runtime_error(std::string("Missing '") + key + "' in .npy header");
+        i = dict.find(':', i);
+        if (i == std::string::npos) throw std::runtime_error("Invalid .npy header");
+        i = dict.find_first_not_of(' ', i + 1);
+        if (i == std::string::npos) throw std::runtime_error("Invalid .npy header");
+        std::string::size_type end = (dict[i] == '(') ? dict.find(')', i) + 1 : dict.find_first_of(",}", i);
+        if (dict[i] == '\'' || dict[i] == '"') end = dict.find(dict[i], i + 1) + 1;
+        if (end == std::string::npos || end == 0) throw std::runtime_error("Invalid .npy header");
+        return dict.substr(i, end - i);
+    }
+
+};
+
+} // namespace detail
+
+/// @addtogroup MainGroup
+/// @{
+
+/**
+ *  @brief Write an array or array expression to a stream in NumPy's .npy format.
+ *
+ *  Expressions are evaluated element by element as they are written, without a temporary array.
+ *
+ *  @throw std::runtime_error if writing fails.
+ */
+template <typename Derived>
+inline void saveNpy(std::ostream & stream, ExpressionBase<Derived> const & expr) {
+    detail::saveExpression<detail::NpyFormat>(stream, expr);
+}
+
+/**
+ *  @brief Write an array or array expression to a .npy file.
+ *
+ *  @throw std::runtime_error if the file cannot be opened or writing fails.
+ */
+template <typename Derived>
+inline void saveNpy(std::string const & path, ExpressionBase<Derived> const & expr) {
+    detail::saveExpression<detail::NpyFormat>(path, expr);
+}
+
+/**
+ *  @brief Read a .npy array from a stream.
+ *
+ *  @returns A temporary object convertible to an Array with any element type matching the
+ *           file's and the file's number of dimensions.  The stream is read during the
+ *           conversion, which throws std::runtime_error on any mismatch or read failure.
+ */
+inline detail::ArrayLoader<detail::NpyFormat> loadNpy(std::istream & stream) {
+    return detail::ArrayLoader<detail::NpyFormat>(stream);
+}
+
+/**
+ *  @brief Read a .npy file with a single bulk read.
+ *
+ *  @returns A temporary object convertible to an Array; see loadNpy(std::istream &).
+ */
+inline detail::ArrayLoader<detail::NpyFormat> loadNpy(std::string const & path) {
+    return detail::ArrayLoader<detail::NpyFormat>(path);
+}
+
+#ifdef NDARRAY_HAVE_MMAP
+
+/**
+ *  @brief Map a .npy file into memory without reading it.
+ *
+ *  @returns A temporary object convertible to an Array backed by a MappedManager.  The
+ *           conversion throws std::runtime_error if the file's element type, number of
+ *           dimensions, byte order or memory order are incompatible with the Array type
+ *           (Fortran-ordered files can be mapped to column-major Arrays).
+ */
+inline detail::ArrayMapper<detail::NpyFormat> mapNpy(
+    std::string const & path, MapModeEnum mode = MAPPED_READ_ONLY
+) {
+    return detail::ArrayMapper<detail::NpyFormat>(path, mode);
+}
+
+#endif // NDARRAY_HAVE_MMAP
+
+/// @}
+
+} // namespace ndarray
+
+#endif // !NDARRAY_IO_Npy_h_INCLUDED
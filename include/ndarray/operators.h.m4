@@ -23,6 +23,17 @@ define(`FUNCTION_TAG',
             }
         };
     };')dnl
+define(`PACKET_FUNCTION',
+`
+    template <typename T>
+    struct PacketFunction<$1::ScalarFunction<T,T>,T> {
+        typedef typename Packet<T>::IsVectorized IsVectorized;
+        typedef typename Packet<T>::Type Type;
+
+        static Type apply($1::ScalarFunction<T,T> const &, Type a, Type b) {
+            return Packet<T>::$2(a, b);
+        }
+    };')dnl
 define(`BINARY_OP',
 `
     template <typename Operand, typename Scalar>
@@ -91,6 +102,7 @@ define(`UNARY_OP',
 
 #include "ndarray/detail/UnaryOp.h"
 #include "ndarray/detail/BinaryOp.h"
+#include "ndarray/detail/Packet.h"
 #include "ndarray/types.h"
 
 namespace ndarray {
@@ -132,6 +144,69 @@ struct BinaryPredicate {
     typedef bool result_type;
 };
 
+/** 
+ *  \internal @class BindFirst
+ *  \brief A unary function object that binds the first argument of a binary function.
+ *
+ *  Unlike boost::binder1st, the bound function and value are public, so packet evaluation
+ *  can broadcast the bound scalar.
+ *
+ *  \ingroup InternalGroup
+ */
+template <typename BinaryFunction>
+struct BindFirst {
+    typedef typename BinaryFunction::second_argument_type argument_type;
+    typedef typename BinaryFunction::result_type result_type;
+
+    BindFirst(BinaryFunction const & functor_, typename BinaryFunction::ParamA value_) :
+        functor(functor_), value(value_) {}
+
+    result_type operator()(typename BinaryFunction::ParamB arg) const { return functor(value, arg); }
+
+    BinaryFunction functor;
+    typename BinaryFunction::first_argument_type value;
+};
+
+/** 
+ *  \internal @class BindSecond
+ *  \brief A unary function object that binds the second argument of a binary function.
+ *
+ *  \ingroup InternalGroup
+ */
+template <typename BinaryFunction>
+struct BindSecond {
+    typedef typename BinaryFunction::first_argument_type argument_type;
+    typedef typename BinaryFunction::result_type result_type;
+
+    BindSecond(BinaryFunction const & functor_, typename BinaryFunction::ParamB value_) :
+        functor(functor_), value(value_) {}
+
+    result_type operator()(typename BinaryFunction::ParamA arg) const { return functor(arg, value); }
+
+    BinaryFunction functor;
+    typename BinaryFunction::second_argument_type value;
+};
+
+template <typename BinaryFunction, typename T>
+struct PacketFunction<BindFirst<BinaryFunction>,T> {
+    typedef typename PacketFunction<BinaryFunction,T>::IsVectorized IsVectorized;
+    typedef typename Packet<T>::Type Type;
+
+    static Type apply(BindFirst<BinaryFunction> const & f, Type arg) {
+        return PacketFunction<BinaryFunction,T>::apply(f.functor, Packet<T>::set1(f.value), arg);
+    }
+};
+
+template <typename BinaryFunction, typename T>
+struct PacketFunction<BindSecond<BinaryFunction>,T> {
+    typedef typename PacketFunction<BinaryFunction,T>::IsVectorized IsVectorized;
+    typedef typename Packet<T>::Type Type;
+
+    static Type apply(BindSecond<BinaryFunction> const & f, Type arg) {
+        return PacketFunction<BinaryFunction,T>::apply(f.functor, arg, Packet<T>::set1(f.value));
+    }
+};
+
 /** 
  *  \internal @class AdaptableFunctionTag
  *  \brief A CRTP base class for non-template classes that contain a templated functor.
@@ -146,7 +221,7 @@ struct AdaptableFunctionTag {
         typedef typename Derived::template ScalarFunction<
             A, typename ExpressionTraits<OperandB>::Element
             > BinaryFunction;
-        typedef boost::binder1st<BinaryFunction> Bound;
+        typedef BindFirst<BinaryFunction> Bound;
         static Bound bind(A const & scalar) {
             return Bound(BinaryFunction(),scalar);
         }
@@ -157,7 +232,7 @@ struct AdaptableFunctionTag {
         typedef typename Derived::template ScalarFunction<
             typename ExpressionTraits<OperandA>::Element, B
             > BinaryFunction;
-        typedef boost::binder2nd<BinaryFunction> Bound;
+        typedef BindSecond<BinaryFunction> Bound;
         static Bound bind(B const & scalar) {
             return Bound(BinaryFunction(),scalar);
         }
@@ -206,6 +281,11 @@ FUNCTION_TAG(GreaterEqualTag,BinaryPredicate,>=)
 FUNCTION_TAG(LogicalAnd,BinaryPredicate,&&)
 FUNCTION_TAG(LogicalOr,BinaryPredicate,||)
 
+PACKET_FUNCTION(PlusTag,add)
+PACKET_FUNCTION(MinusTag,sub)
+PACKET_FUNCTION(MultipliesTag,mul)
+PACKET_FUNCTION(DividesTag,div)
+
 } // namespace detail
 /// \endcond
 
@@ -321,28 +401,6 @@ allclose(ExpressionBase<Derived1> const & expr1, ExpressionBase<Derived2> const
 }
 
 
-template <typename Scalar>
-inline typename boost::enable_if<typename ExpressionTraits<Scalar>::IsScalar, Scalar>::type
-sum(Scalar const & scalar) { return scalar; }
-
-
-/**
- *  \brief Return the sum of all elements of the given expression.
- *
- *  \ingroup MainGroup
- */
-template <typename Derived>
-inline typename Derived::Element
-sum(ExpressionBase<Derived> const & expr) {
-    typename Derived::Iterator const i_end = expr.end();
-    typename Derived::Element total = static_cast<typename Derived::Element>(0);
-    for (typename Derived::Iterator i = expr.begin(); i != i_end; ++i) {
-        total += sum(*i);
-    }
-    return total;
-}
-
-
 } // namespace ndarray
 
 #endif // !NDARRAY_operators_h_INCLUDED
@@ -0,0 +1,473 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+// THIS FILE IS MACHINE GENERATED BY SCONS. DO NOT EDIT MANUALLY.
+changecom(`###')dnl
+define(`PARALLEL_ASSIGN',
+`
+    /// @brief Parallel $1 assignment of arrays and array expressions.
+    template <typename Other>
+    ParallelArrayRef const &
+    operator $1(ExpressionBase<Other> const & expr) const {
+        NDARRAY_ASSERT(expr.getShape()
+                         == _target.getShape().template first<ExpressionBase<Other>::ND::value>());
+        detail::parallelEvaluate(_target, static_cast<Other const &>(expr), detail::$2(), _policy);
+        return *this;
+    }
+
+    /// @brief Parallel $1 assignment of scalars.
+    template <typename Scalar>
+#ifndef DOXYGEN
+    typename boost::enable_if<boost::is_convertible<Scalar,T>, ParallelArrayRef const &>::type
+#else
+    ParallelArrayRef const &
+#endif
+    operator $1(Scalar const & scalar) const {
+        detail::parallelEvaluate(_target, scalar, detail::$2(), _policy);
+        return *this;
+    }')dnl
+#ifndef NDARRAY_parallel_h_INCLUDED
+#define NDARRAY_parallel_h_INCLUDED
+
+/**
+ *  @file ndarray/parallel.h
+ *
+ *  @brief Multithreaded deep assignment and reductions.
+ *
+ *  This file is not included by the main ndarray.h header file, and it requires
+ *  linking against Boost.Thread.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/static_assert.hpp>
+
+#include "ndarray.h"
+#include "ndarray/detail/ThreadPool.h"
+
+namespace ndarray {
+
+/**
+ *  @brief Controls how parallel() assignments are divided among threads.
+ *
+ *  @ingroup MainGroup
+ */
+class ParallelPolicy {
+public:
+
+    /**
+     *  @brief Construct a policy.
+     *
+     *  @param[in] threads    Maximum number of threads to use, including the calling thread;
+     *                        zero selects boost::thread::hardware_concurrency().
+     *  @param[in] threshold  Assignments to fewer elements than this are done serially.
+     */
+    explicit ParallelPolicy(int threads=0, int threshold=65536) :
+        _threads(threads > 0 ? threads : std::max(1, int(boost::thread::hardware_concurrency()))),
+        _threshold(threshold)
+    {}
+
+    /// @brief Return the maximum number of threads, including the calling thread.
+    int getThreads() const { return _threads; }
+
+    /// @brief Return the minimum number of elements for an assignment to be parallelized.
+    int getThreshold() const { return _threshold; }
+
+    /// @brief Return the policy used by parallel() when none is given.
+    static ParallelPolicy getDefault() { return _getDefault(); }
+
+    /**
+     *  @brief Set the policy used by parallel() when none is given.
+     *
+     *  This is not synchronized with concurrent calls to parallel(), and should generally be
+     *  called once at startup.
+     */
+    static void setDefault(ParallelPolicy const & policy) { _getDefault() = policy; }
+
+private:
+
+    static ParallelPolicy & _getDefault() {
+        static ParallelPolicy policy;
+        return policy;
+    }
+
+    int _threads;
+    int _threshold;
+};
+
+namespace detail {
+
+/**
+ *  @internal @brief Make a copy of an expression whose arrays do not share Cores with the original.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Each thread in a parallel evaluation works on its own copy, so the Core reference count
+ *  updates made when iterating over subarrays never touch a Core used by another thread.
+ *  The unspecialized template handles expressions that do not hold Cores.
+ */
+template <typename Expression>
+struct IsolatedCopy {
+    static Expression apply(Expression const & expr) { return expr; }
+};
+
+template <typename T, int N, int C>
+struct IsolatedCopy< Array<T,N,C> > {
+    static Array<T,N,C> apply(Array<T,N,C> const & array) {
+        typedef ArrayAccess< Array<T,N,C> > Access;
+        return Access::construct(array.getData(), Access::getCore(array)->copy());
+    }
+};
+
+template <typename T, int N, int C>
+struct IsolatedCopy< ArrayRef<T,N,C> > {
+    static ArrayRef<T,N,C> apply(ArrayRef<T,N,C> const & array) {
+        typedef ArrayAccess< ArrayRef<T,N,C> > Access;
+        return Access::construct(array.getData(), Access::getCore(array)->copy());
+    }
+};
+
+template <typename Operand, typename UnaryFunction, int N>
+struct IsolatedCopy< UnaryOpExpression<Operand,UnaryFunction,N> > {
+    typedef UnaryOpExpression<Operand,UnaryFunction,N> Expression;
+    static Expression apply(Expression const & expr) {
+        return Expression(IsolatedCopy<Operand>::apply(expr._operand), expr._functor);
+    }
+};
+
+template <typename Operand1, typename Operand2, typename BinaryFunction, int N>
+struct IsolatedCopy< BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> > {
+    typedef BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> Expression;
+    static Expression apply(Expression const & expr) {
+        return Expression(
+            IsolatedCopy<Operand1>::apply(expr._operand1),
+            IsolatedCopy<Operand2>::apply(expr._operand2),
+            expr._functor
+        );
+    }
+};
+
+/**
+ *  @internal @brief Parallel task that evaluates a contiguous range of rows.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, int N, int C, typename Expression, typename AssignOp>
+class RowTask {
+public:
+
+    RowTask(ArrayRef<T,N,C> const & dest, Expression const & expr, int nTasks) :
+        _nRows(dest.template getSize<0>()), _nTasks(nTasks)
+    {
+        _dest.reserve(nTasks);
+        _expr.reserve(nTasks);
+        for (int i = 0; i < nTasks; ++i) {
+            _dest.push_back(IsolatedCopy< ArrayRef<T,N,C> >::apply(dest));
+            _expr.push_back(IsolatedCopy<Expression>::apply(expr));
+        }
+    }
+
+    void operator()(int i) const {
+        apply(
+            _dest[i], _expr[i], (_nRows * i) / _nTasks, (_nRows * (i + 1)) / _nTasks,
+            typename ExpressionTraits<Expression>::IsScalar()
+        );
+    }
+
+private:
+
+    typedef typename ArrayRef<T,N,C>::Iterator Iterator;
+
+    static void apply(ArrayRef<T,N,C> const & dest, Expression const & expr, int begin, int end,
+                      boost::mpl::false_) {
+        AssignOp op;
+        Iterator const i_end = dest.begin() + end;
+        typename Expression::Iterator j = expr.begin() + begin;
+        for (Iterator i = dest.begin() + begin; i != i_end; ++i, ++j) op(*i, *j);
+    }
+
+    static void apply(ArrayRef<T,N,C> const & dest, Expression const & scalar, int begin, int end,
+                      boost::mpl::true_) {
+        AssignOp op;
+        Iterator const i_end = dest.begin() + end;
+        for (Iterator i = dest.begin() + begin; i != i_end; ++i) op(*i, scalar);
+    }
+
+    int _nRows;
+    int _nTasks;
+    std::vector< ArrayRef<T,N,C> > _dest;
+    std::vector<Expression> _expr;
+};
+
+/**
+ *  @internal @brief Parallel task that evaluates a range of a flat (dense) assignment.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, int N, int C, typename Expression, typename AssignOp>
+class FlatTask {
+public:
+
+    FlatTask(ArrayRef<T,N,C> const & dest, Expression const & expr, int nTasks) :
+        _dest(dest), _expr(expr), _nTasks(nTasks),
+        // chunks are a multiple of 64 elements, so they start on packet boundaries
+        _chunk(((dest.getNumElements() + nTasks - 1) / nTasks + 63) & ~63) {}
+
+    void operator()(int i) const {
+        int const size = _dest.getNumElements();
+        int const begin = std::min(i * _chunk, size);
+        int const end = std::min(begin + _chunk, size);
+        apply(begin, end, typename ExpressionTraits<Expression>::IsScalar());
+    }
+
+private:
+
+    void apply(int begin, int end, boost::mpl::false_) const {
+        FlatEvaluator<ArrayRef<T,N,C>,Expression>::apply(_dest, _expr, AssignOp(), begin, end);
+    }
+
+    void apply(int begin, int end, boost::mpl::true_) const {
+        flatFillRange(_dest, _expr, AssignOp(), begin, end);
+    }
+
+    ArrayRef<T,N,C> const & _dest;
+    Expression const & _expr;
+    int _nTasks;
+    int _chunk;
+};
+
+template <typename T, int N, int C, typename Expression>
+inline bool isFlatAssignment(ArrayRef<T,N,C> const & dest, Expression const & expr, boost::mpl::false_) {
+    return FlatEvaluator<ArrayRef<T,N,C>,Expression>::check(dest, expr);
+}
+
+template <typename T, int N, int C, typename Scalar>
+inline bool isFlatAssignment(ArrayRef<T,N,C> const & dest, Scalar const &, boost::mpl::true_) {
+    return isFlatFillable(dest);
+}
+
+/**
+ *  @internal @brief Evaluate an assignment (of an expression or a scalar) using multiple threads.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  If the destination and every array in the expression share one dense layout, the flat
+ *  element range is divided among threads, and no thread touches a Core.  Otherwise the
+ *  outermost dimension is divided, and each thread iterates over its own IsolatedCopy of the
+ *  destination and the expression.
+ */
+template <typename T, int N, int C, typename Expression, typename AssignOp>
+void parallelEvaluate(
+    ArrayRef<T,N,C> const & dest, Expression const & expr, AssignOp const & op,
+    ParallelPolicy const & policy
+) {
+    typedef typename ExpressionTraits<Expression>::IsScalar IsScalar;
+    int const size = dest.getNumElements();
+    int nTasks = policy.getThreads();
+    if (nTasks > 1 && size >= policy.getThreshold() && size > 0) {
+        if (isFlatAssignment(dest, expr, IsScalar())) {
+            FlatTask<T,N,C,Expression,AssignOp> task(dest, expr, nTasks);
+            ThreadPool::run(nTasks, nTasks, boost::cref(task));
+            return;
+        }
+        nTasks = std::min(nTasks, dest.template getSize<0>());
+        if (nTasks > 1) {
+            RowTask<T,N,C,Expression,AssignOp> task(dest, expr, nTasks);
+            ThreadPool::run(nTasks, nTasks, boost::cref(task));
+            return;
+        }
+    }
+    ArrayRef<T,N,C> target(dest);
+    op(target, expr);
+}
+
+/**
+ *  @internal @brief Parallel task that passes part of an expression to its own reduction visitor.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Expression, typename Visitor>
+class ReductionTask {
+public:
+
+    ReductionTask(Expression const & expr, std::vector<Visitor> & visitors, bool isFlat) :
+        _expr(expr), _visitors(visitors), _isFlat(isFlat),
+        _size(expr.getShape().product()), _nRows(expr.getShape()[0])
+    {
+        if (!_isFlat) {
+            _copies.reserve(_visitors.size());
+            for (std::size_t i = 0; i < _visitors.size(); ++i) {
+                _copies.push_back(IsolatedCopy<Expression>::apply(expr));
+            }
+        }
+    }
+
+    void operator()(int i) const {
+        int const nTasks = _visitors.size();
+        if (_isFlat) {
+            // chunks are a multiple of the block size, so each task sums whole blocks
+            int const chunk = ((_size + nTasks - 1) / nTasks + REDUCTION_BLOCK_SIZE - 1)
+                / REDUCTION_BLOCK_SIZE * REDUCTION_BLOCK_SIZE;
+            int const begin = std::min(i * chunk, _size);
+            FlatReduction<Expression>::apply(_expr, _visitors[i], begin, std::min(begin + chunk, _size));
+        } else {
+            typedef ExpressionTraits<Expression> Traits;
+            ReductionBuffer<typename ReductionTraits<typename Traits::Element>::Value,Visitor> buffer(
+                _visitors[i]
+            );
+            Expression const & expr = _copies[i];
+            gatherRows(
+                expr.begin() + (_nRows * i) / nTasks, expr.begin() + (_nRows * (i + 1)) / nTasks,
+                buffer, boost::mpl::int_<Traits::ND::value>()
+            );
+            buffer.flush();
+        }
+    }
+
+private:
+    Expression const & _expr;
+    std::vector<Visitor> & _visitors;
+    std::vector<Expression> _copies;
+    bool _isFlat;
+    int _size;
+    int _nRows;
+};
+
+/**
+ *  @internal @brief Pass every element of an expression to a reduction visitor using multiple
+ *         threads.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Each thread reduces part of the expression into its own copy of the visitor, and the
+ *  partial results are merged into the original visitor in order.  As with parallelEvaluate,
+ *  a flat expression is divided by element and any other expression by its outermost
+ *  dimension.  The visitor must not require ordered traversal.
+ */
+template <typename Expression, typename Visitor>
+void parallelVisitElements(Expression const & expr, Visitor & visitor, ParallelPolicy const & policy) {
+    BOOST_STATIC_ASSERT(!Visitor::IsOrdered::value);
+    int const size = expr.getShape().product();
+    int nTasks = policy.getThreads();
+    if (nTasks > 1 && size >= policy.getThreshold() && size > 0) {
+        bool const isFlat = FlatReduction<Expression>::check(expr, false);
+        if (!isFlat) nTasks = std::min(nTasks, expr.getShape()[0]);
+        if (nTasks > 1) {
+            std::vector<Visitor> visitors(nTasks, visitor);
+            ReductionTask<Expression,Visitor> task(expr, visitors, isFlat);
+            ThreadPool::run(nTasks, nTasks, boost::cref(task));
+            for (int i = 0; i < nTasks; ++i) visitor.merge(visitors[i]);
+            return;
+        }
+    }
+    visitElements(expr, visitor);
+}
+
+} // namespace detail
+
+/**
+ *  @brief A proxy for an ArrayRef whose assignment operators evaluate their right-hand side
+ *         using multiple threads.
+ *
+ *  @ingroup MainGroup
+ *
+ *  ParallelArrayRef is returned by parallel(); it is not intended to be stored.
+ */
+template <typename T, int N, int C>
+class ParallelArrayRef {
+public:
+
+    ParallelArrayRef(ArrayRef<T,N,C> const & target, ParallelPolicy const & policy) :
+        _target(target), _policy(policy) {}
+
+PARALLEL_ASSIGN(=,Assign)
+PARALLEL_ASSIGN(+=,PlusAssign)
+PARALLEL_ASSIGN(-=,MinusAssign)
+PARALLEL_ASSIGN(*=,MultipliesAssign)
+PARALLEL_ASSIGN(/=,DividesAssign)
+PARALLEL_ASSIGN(%=,ModulusAssign)
+PARALLEL_ASSIGN(^=,BitwiseXorAssign)
+PARALLEL_ASSIGN(&=,BitwiseAndAssign)
+PARALLEL_ASSIGN(|=,BitwiseOrAssign)
+PARALLEL_ASSIGN(<<=,BitwiseLeftShiftAssign)
+PARALLEL_ASSIGN(>>=,BitwiseRightShiftAssign)
+
+private:
+    ArrayRef<T,N,C> _target;
+    ParallelPolicy _policy;
+};
+
+/// @addtogroup MainGroup
+/// @{
+
+/**
+ *  @brief Return a proxy whose assignment operators evaluate in parallel.
+ *
+ *  For example,
+ *  @code
+ *  ndarray::parallel(image) = a * b + c;
+ *  ndarray::parallel(image, ndarray::ParallelPolicy(4)) += d;
+ *  @endcode
+ *  The result is the same as deep assignment to image.deep().
+ */
+template <typename Derived>
+ParallelArrayRef<
+    typename ExpressionTraits<Derived>::Element,
+    ExpressionTraits<Derived>::ND::value,
+    ExpressionTraits<Derived>::RMC::value
+    >
+parallel(ArrayBase<Derived> const & array, ParallelPolicy const & policy = ParallelPolicy::getDefault()) {
+    return ParallelArrayRef<
+        typename ExpressionTraits<Derived>::Element,
+        ExpressionTraits<Derived>::ND::value,
+        ExpressionTraits<Derived>::RMC::value
+        >(array.deep(), policy);
+}
+
+/**
+ *  @brief Return the sum of all elements of an expression, computed with multiple threads.
+ *
+ *  Partial sums are computed in parallel and combined pairwise; the result may differ from
+ *  sum(expr) by rounding.
+ */
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Value
+sum(ExpressionBase<Derived> const & expr, ParallelPolicy const & policy) {
+    detail::SumVisitor<typename detail::ReductionTraits<typename Derived::Element>::Value> visitor;
+    detail::parallelVisitElements(static_cast<Derived const &>(expr), visitor, policy);
+    return visitor.get();
+}
+
+/// @brief Return the mean of all elements of an expression, computed with multiple threads.
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Mean
+mean(ExpressionBase<Derived> const & expr, ParallelPolicy const & policy) {
+    typedef detail::ReductionTraits<typename Derived::Element> Traits;
+    detail::SumVisitor<typename Traits::Mean> visitor;
+    detail::parallelVisitElements(static_cast<Derived const &>(expr), visitor, policy);
+    return visitor.get() / typename Traits::Real(expr.getShape().product());
+}
+
+/// @brief Return the variance of all elements of an expression, computed with multiple threads.
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Real
+variance(ExpressionBase<Derived> const & expr, ParallelPolicy const & policy, int ddof=0) {
+    typedef detail::ReductionTraits<typename Derived::Element> Traits;
+    detail::DeviationVisitor<typename Traits::Mean> visitor(mean(expr, policy));
+    detail::parallelVisitElements(static_cast<Derived const &>(expr), visitor, policy);
+    return visitor.get() / typename Traits::Real(expr.getShape().product() - ddof);
+}
+
+/// @}
+
+} // namespace ndarray
+
+#endif // !NDARRAY_parallel_h_INCLUDED
@@ -0,0 +1,886 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#ifndef NDARRAY_reductions_h_INCLUDED
+#define NDARRAY_reductions_h_INCLUDED
+
+/**
+ *  @file ndarray/reductions.h
+ *
+ *  @brief Sums, means, variances and extrema of arrays and array expressions.
+ *
+ *  Reductions operate directly on lazy expressions, so sum(a * b) never allocates a
+ *  temporary for a * b.  Full reductions use the same flat, packet-vectorized loops as
+ *  assignment when every array in the expression shares one dense layout, or the loops
+ *  of a LoopPlan when the layouts differ, and sum blocks of elements pairwise for
+ *  accuracy.  Reductions along a single axis use compensated (Kahan) summation and
+ *  Welford's algorithm for variances.
+ */
+
+#include <algorithm>
+#include <complex>
+#include <utility>
+
+#include <boost/mpl/if.hpp>
+#include <boost/mpl/int.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+#include "ndarray/Array.h"
+#include "ndarray/initialization.h"
+#include "ndarray/detail/Packet.h"
+
+namespace ndarray {
+namespace detail {
+
+/// @internal @brief Number of elements summed directly before pairwise combination.
+enum { REDUCTION_BLOCK_SIZE = 128 };
+
+/**
+ *  @internal @brief Result types for reductions over elements of type T.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Means of integers are computed in double precision; variances of complex numbers are real.
+ */
+template <typename T>
+struct ReductionTraits {
+    typedef typename boost::remove_const<T>::type Value;
+    typedef typename boost::mpl::if_<boost::is_integral<Value>,double,Value>::type Mean;
+    typedef Mean Real;
+};
+
+template <typename U>
+struct ReductionTraits< std::complex<U> > {
+    typedef std::complex<U> Value;
+    typedef std::complex<U> Mean;
+    typedef U Real;
+};
+
+template <typename U>
+struct ReductionTraits< std::complex<U> const > : public ReductionTraits< std::complex<U> > {};
+
+/// @internal @brief Return the real part of conj(a) * b (just a * b for real numbers).
+template <typename T>
+inline T conjugateProduct(T const & a, T const & b) { return a * b; }
+
+template <typename U>
+inline U conjugateProduct(std::complex<U> const & a, std::complex<U> const & b) {
+    return a.real() * b.real() + a.imag() * b.imag();
+}
+
+/**
+ *  @internal @brief Accumulates a sequence of partial sums with pairwise summation.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Partial sums are kept on a stack tagged by the number of inputs they represent (as a
+ *  power of two), and equal-sized neighbors are merged as soon as both exist, exactly like
+ *  carrying in a binary counter.  The rounding error then grows with the logarithm of the
+ *  number of inputs rather than linearly, with no recursion and constant storage.
+ */
+template <typename T>
+class PairwiseSum {
+public:
+
+    PairwiseSum() : _n(0) {}
+
+    void add(T const & value) {
+        T total = value;
+        int level = 0;
+        for (; _n > 0 && _levels[_n - 1] == level; ++level) {
+            total = _partials[--_n] + total;
+        }
+        _partials[_n] = total;
+        _levels[_n] = level;
+        ++_n;
+    }
+
+    T get() const {
+        T total = T(0);
+        for (int i = _n; i > 0; --i) total = _partials[i - 1] + total;
+        return total;
+    }
+
+private:
+    T _partials[64];
+    int _levels[64];
+    int _n;
+};
+
+/**
+ *  @internal @brief Sum a block of elements from a flat cursor with several independent
+ *         accumulators.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, typename Cursor>
+inline T blockSum(Cursor const & cursor, int begin, int end, boost::mpl::false_) {
+    T a0 = T(0), a1 = T(0), a2 = T(0), a3 = T(0);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        a0 += T(cursor[i]);
+        a1 += T(cursor[i + 1]);
+        a2 += T(cursor[i + 2]);
+        a3 += T(cursor[i + 3]);
+    }
+    for (; i < end; ++i) a0 += T(cursor[i]);
+    return (a0 + a1) + (a2 + a3);
+}
+
+template <typename T, typename Cursor>
+inline T blockSum(Cursor const & cursor, int begin, int end, boost::mpl::true_) {
+    typedef Packet<T> P;
+    typedef PacketCursor<Cursor,T> Loader;
+    typename P::Type a0 = P::set1(T(0));
+    typename P::Type a1 = a0;
+    int i = begin;
+    for (; i + 2 * P::size <= end; i += 2 * P::size) {
+        a0 = P::add(a0, Loader::load(cursor, i));
+        a1 = P::add(a1, Loader::load(cursor, i + P::size));
+    }
+    T lanes[P::size];
+    P::store(lanes, P::add(a0, a1));
+    T total = T(0);
+    for (int k = 0; k < P::size; ++k) total += lanes[k];
+    for (; i < end; ++i) total += cursor[i];
+    return total;
+}
+
+/**
+ *  @internal @brief Flat cursor adaptor that yields squared deviations from a mean.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Cursor, typename T>
+struct DeviationCursor {
+    typedef typename ReductionTraits<T>::Real Real;
+
+    Real operator[](int i) const {
+        T const d = T(cursor[i]) - mean;
+        return conjugateProduct(d, d);
+    }
+
+    Cursor cursor;
+    T mean;
+};
+
+/**
+ *  @internal @brief Reduction visitor that sums elements pairwise.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Reduction visitors are called with a flat cursor and a half-open range of indices into
+ *  it, once or several times, and must be copyable.  IsOrdered is true if the visitor
+ *  requires the calls to cover the elements in row-major order.
+ */
+template <typename T>
+class SumVisitor {
+public:
+    typedef boost::mpl::false_ IsOrdered;
+
+    template <typename Cursor>
+    void operator()(Cursor const & cursor, int begin, int end) {
+        for (int i = begin; i < end; i += REDUCTION_BLOCK_SIZE) {
+            _sum.add(
+                blockSum<T>(cursor, i, std::min(i + int(REDUCTION_BLOCK_SIZE), end),
+                            typename PacketCursor<Cursor,T>::IsVectorized())
+            );
+        }
+    }
+
+    void merge(SumVisitor const & other) { _sum.add(other.get()); }
+
+    T get() const { return _sum.get(); }
+
+private:
+    PairwiseSum<T> _sum;
+};
+
+/**
+ *  @internal @brief Reduction visitor that sums squared deviations from a known mean.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T>
+class DeviationVisitor {
+public:
+    typedef boost::mpl::false_ IsOrdered;
+    typedef typename ReductionTraits<T>::Real Real;
+
+    explicit DeviationVisitor(T const & mean) : _mean(mean) {}
+
+    template <typename Cursor>
+    void operator()(Cursor const & cursor, int begin, int end) {
+        DeviationCursor<Cursor,T> deviations = { cursor, _mean };
+        for (int i = begin; i < end; i += REDUCTION_BLOCK_SIZE) {
+            _sum.add(
+                blockSum<Real>(deviations, i, std::min(i + int(REDUCTION_BLOCK_SIZE), end),
+                               boost::mpl::false_())
+            );
+        }
+    }
+
+    void merge(DeviationVisitor const & other) { _sum.add(other.get()); }
+
+    Real get() const { return _sum.get(); }
+
+private:
+    T _mean;
+    PairwiseSum<Real> _sum;
+};
+
+/**
+ *  @internal @brief Reduction visitor that finds the minimum and maximum and their positions.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Elements are compared with operator<; the first of several equal extrema wins.
+ */
+template <typename T>
+class ExtremaVisitor {
+public:
+    typedef boost::mpl::true_ IsOrdered;
+
+    ExtremaVisitor() : _min(), _max(), _argMin(0), _argMax(0), _count(0) {}
+
+    template <typename Cursor>
+    void operator()(Cursor const & cursor, int begin, int end) {
+        int i = begin;
+        if (_count == 0 && i < end) {
+            _min = _max = cursor[i];
+            ++i;
+        }
+        for (; i < end; ++i) {
+            T const x = cursor[i];
+            if (x < _min) {
+                _min = x;
+                _argMin = _count + i - begin;
+            }
+            if (_max < x) {
+                _max = x;
+                _argMax = _count + i - begin;
+            }
+        }
+        _count += end - begin;
+    }
+
+    T const & getMin() const { return _min; }
+    T const & getMax() const { return _max; }
+    int getArgMin() const { return _argMin; }
+    int getArgMax() const { return _argMax; }
+    int getCount() const { return _count; }
+
+private:
+    T _min;
+    T _max;
+    int _argMin;
+    int _argMax;
+    int _count;
+};
+
+/**
+ *  @internal @brief Flat traversal of an expression for reductions.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  check() returns true if every array in the expression is dense with the same row-major
+ *  layout, or (if the reduction does not care about order) the same column-major layout;
+ *  apply() may then pass any range of the flat cursor to a visitor.
+ */
+template <typename Expression, bool isFlat = FlatTraits<Expression>::IsFlat::value>
+struct FlatReduction {
+    static bool check(Expression const &, bool) { return false; }
+
+    template <typename Visitor>
+    static void apply(Expression const &, Visitor &, int, int) {}
+};
+
+template <typename Expression>
+struct FlatReduction<Expression,true> {
+    typedef FlatTraits<Expression> Traits;
+
+    static bool check(Expression const & expr, bool ordered) {
+        if (Traits::isBroadcast(expr)) return false;
+        if (Traits::IsRowMajor::value || (!ordered && Traits::IsColumnMajor::value)) return true;
+        Vector<int,ExpressionTraits<Expression>::ND::value> shape = expr.getShape();
+        return Traits::hasLayout(expr, shape, computeStrides(shape, ROW_MAJOR))
+            || (!ordered && Traits::hasLayout(expr, shape, computeStrides(shape, COLUMN_MAJOR)));
+    }
+
+    template <typename Visitor>
+    static void apply(Expression const & expr, Visitor & visitor, int begin, int end) {
+        visitor(Traits::getCursor(expr), begin, end);
+    }
+};
+
+/**
+ *  @internal @brief Stride enumeration for the LoopPlan of a reduction.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Expression>
+struct ReductionOperands {
+
+    explicit ReductionOperands(Expression const & expr_) : expr(expr_) {}
+
+    template <typename StrideVisitor>
+    void operator()(StrideVisitor & visitor) const {
+        FlatTraits<Expression>::visitStrides(expr, visitor);
+    }
+
+    Expression const & expr;
+};
+
+/**
+ *  @internal @brief Traversal of an expression for reductions with a LoopPlan.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  apply() passes each inner loop of the plan to the visitor as a separate range, and
+ *  returns false if the expression cannot be planned (because it is not made of arrays,
+ *  or broadcasts).  Dimensions are only reordered if the visitor does not require
+ *  row-major order.
+ */
+template <typename Expression, bool isFlat = FlatTraits<Expression>::IsFlat::value>
+struct PlannedReduction {
+    template <typename Visitor>
+    static bool apply(Expression const &, Visitor &) { return false; }
+};
+
+template <typename Expression>
+struct PlannedReduction<Expression,true> {
+    typedef FlatTraits<Expression> Traits;
+    typedef Vector<int,ExpressionTraits<Expression>::ND::value> Index;
+
+    template <typename Visitor>
+    struct Body {
+        void operator()(Index const & index) const {
+            if (isUnit) {
+                visitor(Traits::getCursor(expr, index), 0, size);
+            } else {
+                visitor(Traits::getStridedCursor(expr, index, axis), 0, size);
+            }
+        }
+
+        Expression const & expr;
+        Visitor & visitor;
+        int axis;
+        int size;
+        bool isUnit;
+    };
+
+    template <typename Visitor>
+    static bool apply(Expression const & expr, Visitor & visitor) {
+        if (Traits::isBroadcast(expr)) return false;
+        ReductionOperands<Expression> operands(expr);
+        LoopPlan<ExpressionTraits<Expression>::ND::value> plan(
+            expr.getShape(), operands, !Visitor::IsOrdered::value
+        );
+        Body<Visitor> body = {
+            expr, visitor, plan.inner, plan.innerSize, plan.hasUnitStride(operands)
+        };
+        plan.execute(body);
+        return true;
+    }
+};
+
+/**
+ *  @internal @brief Fixed-size buffer that passes gathered elements to a reduction visitor
+ *         one block at a time.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, typename Visitor>
+class ReductionBuffer {
+public:
+
+    explicit ReductionBuffer(Visitor & visitor) : _visitor(visitor), _n(0) {}
+
+    void push(T const & x) {
+        _data[_n++] = x;
+        if (_n == REDUCTION_BLOCK_SIZE) flush();
+    }
+
+    void flush() {
+        if (_n > 0) {
+            _visitor(static_cast<T const *>(_data), 0, _n);
+            _n = 0;
+        }
+    }
+
+private:
+    Visitor & _visitor;
+    T _data[REDUCTION_BLOCK_SIZE];
+    int _n;
+};
+
+/**
+ *  @internal @brief Push the elements of a range of rows into a ReductionBuffer in row-major order.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename Iterator, typename Buffer>
+inline void gatherRows(Iterator i, Iterator const & end, Buffer & buffer, boost::mpl::int_<1>) {
+    for (; i != end; ++i) buffer.push(*i);
+}
+
+template <typename Iterator, typename Buffer, int N>
+inline void gatherRows(Iterator i, Iterator const & end, Buffer & buffer, boost::mpl::int_<N>) {
+    for (; i != end; ++i) gatherRows((*i).begin(), (*i).end(), buffer, boost::mpl::int_<N-1>());
+}
+
+/**
+ *  @internal @brief Pass every element of an expression to a reduction visitor.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Expressions over arrays that cannot be traversed flat are traversed with a LoopPlan;
+ *  all others are evaluated with nested iteration into a small buffer.
+ */
+template <typename Expression, typename Visitor>
+inline void visitElements(Expression const & expr, Visitor & visitor) {
+    typedef ExpressionTraits<Expression> Traits;
+    typedef FlatReduction<Expression> Flat;
+    if (Flat::check(expr, Visitor::IsOrdered::value)) {
+        Flat::apply(expr, visitor, 0, expr.getShape().product());
+        return;
+    }
+    if (PlannedReduction<Expression>::apply(expr, visitor)) return;
+    ReductionBuffer<typename ReductionTraits<typename Traits::Element>::Value,Visitor> buffer(visitor);
+    gatherRows(expr.begin(), expr.end(), buffer, boost::mpl::int_<Traits::ND::value>());
+    buffer.flush();
+}
+
+/// @internal @brief Convert a row-major flat index into an index vector.
+template <int N>
+inline Vector<int,N> unravelIndex(int flat, Vector<int,N> const & shape) {
+    Vector<int,N> r;
+    for (int n = N - 1; n >= 0; --n) {
+        r[n] = flat % shape[n];
+        flat /= shape[n];
+    }
+    return r;
+}
+
+/**
+ *  @internal @brief Axis reduction accumulator for sums, using Kahan summation.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Axis accumulators define a State type held for each output element, init() and add()
+ *  to start and continue a reduction with an input element, and get() to compute the result.
+ */
+template <typename T>
+struct SumAccumulator {
+    struct State {
+        T sum;
+        T compensation;
+    };
+    typedef T Result;
+
+    template <typename U>
+    void init(State & s, U const & x) const {
+        s.sum = x;
+        s.compensation = T(0);
+    }
+
+    template <typename U>
+    void add(State & s, U const & x) const {
+        T const y = T(x) - s.compensation;
+        T const t = s.sum + y;
+        s.compensation = (t - s.sum) - y;
+        s.sum = t;
+    }
+
+    Result get(State const & s) const { return s.sum; }
+};
+
+/**
+ *  @internal @brief Axis reduction accumulator for means.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T>
+struct MeanAccumulator : public SumAccumulator<T> {
+    typedef typename SumAccumulator<T>::State State;
+
+    explicit MeanAccumulator(int n) : _n(n) {}
+
+    T get(State const & s) const { return s.sum / typename ReductionTraits<T>::Real(_n); }
+
+private:
+    int _n;
+};
+
+/**
+ *  @internal @brief Axis reduction accumulator for variances, using Welford's algorithm.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T>
+struct VarianceAccumulator {
+    typedef typename ReductionTraits<T>::Real Result;
+    struct State {
+        T mean;
+        Result m2;
+        int n;
+    };
+
+    explicit VarianceAccumulator(int ddof) : _ddof(ddof) {}
+
+    template <typename U>
+    void init(State & s, U const & x) const {
+        s.mean = x;
+        s.m2 = Result(0);
+        s.n = 1;
+    }
+
+    template <typename U>
+    void add(State & s, U const & x) const {
+        ++s.n;
+        T const d = T(x) - s.mean;
+        s.mean += d / Result(s.n);
+        s.m2 += conjugateProduct(d, T(T(x) - s.mean));
+    }
+
+    Result get(State const & s) const { return s.m2 / Result(s.n - _ddof); }
+
+private:
+    int _ddof;
+};
+
+/**
+ *  @internal @brief Axis reduction accumulator for minima (or maxima, if isMax).
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, bool isMax>
+struct ExtremumAccumulator {
+    typedef T State;
+    typedef T Result;
+
+    template <typename U>
+    void init(State & s, U const & x) const { s = x; }
+
+    template <typename U>
+    void add(State & s, U const & x) const {
+        if (isMax ? (s < x) : (x < s)) s = x;
+    }
+
+    Result get(State const & s) const { return s; }
+};
+
+/// @internal @brief Elementwise operation used to start an axis reduction with a row.
+template <typename Accumulator>
+struct AxisInit {
+    template <typename U>
+    void operator()(typename Accumulator::State & s, U const & x) const { accumulator.init(s, x); }
+    Accumulator const & accumulator;
+};
+
+/// @internal @brief Elementwise operation used to continue an axis reduction with a row.
+template <typename Accumulator>
+struct AxisAdd {
+    template <typename U>
+    void operator()(typename Accumulator::State & s, U const & x) const { accumulator.add(s, x); }
+    Accumulator const & accumulator;
+};
+
+/// @internal @brief Elementwise operation used to compute the results of an axis reduction.
+template <typename Accumulator>
+struct AxisGet {
+    void operator()(typename Accumulator::Result & r, typename Accumulator::State const & s) const {
+        r = accumulator.get(s);
+    }
+    Accumulator const & accumulator;
+};
+
+/**
+ *  @internal @brief Apply a binary operation to corresponding elements of an array and an
+ *         expression with the same shape, modifying the array's elements.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <typename T, int C, typename Expression, typename Op>
+inline void applyElementwise(ArrayRef<T,1,C> const & out, Expression const & in, Op const & op) {
+    typename ArrayRef<T,1,C>::Iterator const i_end = out.end();
+    typename ArrayRef<T,1,C>::Iterator i = out.begin();
+    typename Expression::Iterator j = in.begin();
+    for (; i != i_end; ++i, ++j) op(*i, *j);
+}
+
+template <typename T, int N, int C, typename Expression, typename Op>
+inline void applyElementwise(ArrayRef<T,N,C> const & out, Expression const & in, Op const & op) {
+    typename ArrayRef<T,N,C>::Iterator const i_end = out.end();
+    typename ArrayRef<T,N,C>::Iterator i = out.begin();
+    typename Expression::Iterator j = in.begin();
+    for (; i != i_end; ++i, ++j) applyElementwise(*i, *j, op);
+}
+
+/**
+ *  @internal @brief Reduce an expression along dimension P into an array of accumulator states.
+ *
+ *  @ingroup ndarrayInternalGroup
+ *
+ *  Dimensions before P are iterated over in lockstep with the states; when P is reached,
+ *  either whole rows are accumulated elementwise into the states (if other dimensions
+ *  follow), or a one-dimensional expression is folded into a single state.
+ */
+template <int P>
+struct AxisReduction {
+    template <typename Expression, typename S, int M, int C, typename Accumulator>
+    static void apply(Expression const & expr, ArrayRef<S,M,C> const & states,
+                      Accumulator const & accumulator) {
+        typename Expression::Iterator const i_end = expr.end();
+        typename Expression::Iterator i = expr.begin();
+        typename ArrayRef<S,M,C>::Iterator j = states.begin();
+        for (; i != i_end; ++i, ++j) AxisReduction<P-1>::apply(*i, *j, accumulator);
+    }
+};
+
+template <>
+struct AxisReduction<0> {
+    template <typename Expression, typename S, int M, int C, typename Accumulator>
+    static void apply(Expression const & expr, ArrayRef<S,M,C> const & states,
+                      Accumulator const & accumulator) {
+        typename Expression::Iterator const i_end = expr.end();
+        typename Expression::Iterator i = expr.begin();
+        AxisInit<Accumulator> const init = { accumulator };
+        applyElementwise(states, *i, init);
+        AxisAdd<Accumulator> const add = { accumulator };
+        for (++i; i != i_end; ++i) applyElementwise(states, *i, add);
+    }
+
+    template <typename Expression, typename Accumulator>
+    static void apply(Expression const & expr, typename Accumulator::State & state,
+                      Accumulator const & accumulator) {
+        typename Expression::Iterator const i_end = expr.end();
+        typename Expression::Iterator i = expr.begin();
+        accumulator.init(state, *i);
+        for (++i; i != i_end; ++i) accumulator.add(state, *i);
+    }
+};
+
+/**
+ *  @internal @brief Reduce an expression along dimension P with the given accumulator.
+ *
+ *  @ingroup ndarrayInternalGroup
+ */
+template <int P, typename Expression, typename Accumulator>
+inline Array<
+    typename Accumulator::Result,
+    ExpressionTraits<Expression>::ND::value - 1,
+    ExpressionTraits<Expression>::ND::value - 1
+    >
+reduceAxis(Expression const & expr, Accumulator const & accumulator) {
+    static int const N = ExpressionTraits<Expression>::ND::value;
+    BOOST_STATIC_ASSERT(N > 1 && P >= 0 && P < N);
+    Vector<int,N> const shape = expr.getShape();
+    NDARRAY_ASSERT(shape[P] > 0);
+    Vector<int,N-1> reduced;
+    for (int n = 0; n < N - 1; ++n) reduced[n] = shape[n < P ? n : n + 1];
+    Array<typename Accumulator::State,N-1,N-1> states = allocate(reduced);
+    Array<typename Accumulator::Result,N-1,N-1> result = allocate(reduced);
+    if (reduced.product() > 0) {
+        AxisReduction<P>::apply(expr, states.deep(), accumulator);
+        AxisGet<Accumulator> const get = { accumulator };
+        applyElementwise(result.deep(), states, get);
+    }
+    return result;
+}
+
+} // namespace detail
+
+/// @addtogroup MainGroup
+/// @{
+
+template <typename Scalar>
+inline typename boost::enable_if<typename ExpressionTraits<Scalar>::IsScalar, Scalar>::type
+sum(Scalar const & scalar) { return scalar; }
+
+/**
+ *  @brief Return the sum of all elements of the given expression.
+ *
+ *  Elements are summed in blocks whose totals are combined pairwise.
+ */
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Value
+sum(ExpressionBase<Derived> const & expr) {
+    detail::SumVisitor<typename detail::ReductionTraits<typename Derived::Element>::Value> visitor;
+    detail::visitElements(static_cast<Derived const &>(expr), visitor);
+    return visitor.get();
+}
+
+/**
+ *  @brief Return the mean of all elements of the given expression.
+ *
+ *  The mean of an integer expression is a double.
+ */
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Mean
+mean(ExpressionBase<Derived> const & expr) {
+    typedef detail::ReductionTraits<typename Derived::Element> Traits;
+    detail::SumVisitor<typename Traits::Mean> visitor;
+    detail::visitElements(static_cast<Derived const &>(expr), visitor);
+    return visitor.get() / typename Traits::Real(expr.getShape().product());
+}
+
+/**
+ *  @brief Return the variance of all elements of the given expression.
+ *
+ *  @param[in] expr   Expression to reduce; it is evaluated twice.
+ *  @param[in] ddof   "Delta degrees of freedom": the sum of squared deviations from the mean
+ *                    is divided by the number of elements minus ddof (1 gives the unbiased
+ *                    estimate).
+ *
+ *  The variance of a complex expression is the (real) mean squared modulus of its deviations.
+ */
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Real
+variance(ExpressionBase<Derived> const & expr, int ddof=0) {
+    typedef detail::ReductionTraits<typename Derived::Element> Traits;
+    detail::DeviationVisitor<typename Traits::Mean> visitor(mean(expr));
+    detail::visitElements(static_cast<Derived const &>(expr), visitor);
+    return visitor.get() / typename Traits::Real(expr.getShape().product() - ddof);
+}
+
+/**
+ *  @brief Return the smallest and largest elements of a nonempty expression.
+ */
+template <typename Derived>
+inline std::pair<
+    typename detail::ReductionTraits<typename Derived::Element>::Value,
+    typename detail::ReductionTraits<typename Derived::Element>::Value
+    >
+minmax(ExpressionBase<Derived> const & expr) {
+    detail::ExtremaVisitor<typename detail::ReductionTraits<typename Derived::Element>::Value> visitor;
+    detail::visitElements(static_cast<Derived const &>(expr), visitor);
+    NDARRAY_ASSERT(visitor.getCount() > 0);
+    return std::make_pair(visitor.getMin(), visitor.getMax());
+}
+
+/// @brief Return the smallest element of a nonempty expression.
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Value
+min(ExpressionBase<Derived> const & expr) {
+    return minmax(expr).first;
+}
+
+/// @brief Return the largest element of a nonempty expression.
+template <typename Derived>
+inline typename detail::ReductionTraits<typename Derived::Element>::Value
+max(ExpressionBase<Derived> const & expr) {
+    return minmax(expr).second;
+}
+
+/**
+ *  @brief Return the index of the smallest element of a nonempty expression.
+ *
+ *  If the minimum occurs more than once, the first index in row-major order is returned.
+ */
+template <typename Derived>
+inline Vector<int,Derived::ND::value>
+argmin(ExpressionBase<Derived> const & expr) {
+    detail::ExtremaVisitor<typename detail::ReductionTraits<typename Derived::Element>::Value> visitor;
+    detail::visitElements(static_cast<Derived const &>(expr), visitor);
+    NDARRAY_ASSERT(visitor.getCount() > 0);
+    return detail::unravelIndex(visitor.getArgMin(), expr.getShape());
+}
+
+/**
+ *  @brief Return the index of the largest element of a nonempty expression.
+ *
+ *  If the maximum occurs more than once, the first index in row-major order is returned.
+ */
+template <typename Derived>
+inline Vector<int,Derived::ND::value>
+argmax(ExpressionBase<Derived> const & expr) {
+    detail::ExtremaVisitor<typename detail::ReductionTraits<typename Derived::Element>::Value> visitor;
+    detail::visitElements(static_cast<Derived const &>(expr), visitor);
+    NDARRAY_ASSERT(visitor.getCount() > 0);
+    return detail::unravelIndex(visitor.getArgMax(), expr.getShape());
+}
+
+/**
+ *  @brief Return the sums of an expression along dimension P.
+ *
+ *  The result has one fewer dimension than the expression, with dimension P removed; for
+ *  example, sum<0>(m) returns the column sums of a matrix.  The expression must have at
+ *  least two dimensions, and dimension P must not be empty.
+ */
+template <int P, typename Derived>
+inline Array<
+    typename detail::ReductionTraits<typename Derived::Element>::Value,
+    Derived::ND::value - 1, Derived::ND::value - 1
+    >
+sum(ExpressionBase<Derived> const & expr) {
+    typedef typename detail::ReductionTraits<typename Derived::Element>::Value Value;
+    return detail::reduceAxis<P>(static_cast<Derived const &>(expr), detail::SumAccumulator<Value>());
+}
+
+/// @brief Return the means of an expression along dimension P; see sum<P>().
+template <int P, typename Derived>
+inline Array<
+    typename detail::ReductionTraits<typename Derived::Element>::Mean,
+    Derived::ND::value - 1, Derived::ND::value - 1
+    >
+mean(ExpressionBase<Derived> const & expr) {
+    typedef typename detail::ReductionTraits<typename Derived::Element>::Mean Mean;
+    return detail::reduceAxis<P>(
+        static_cast<Derived const &>(expr), detail::MeanAccumulator<Mean>(expr.getShape()[P])
+    );
+}
+
+/// @brief Return the variances of an expression along dimension P; see sum<P>() and variance().
+template <int P, typename Derived>
+inline Array<
+    typename detail::ReductionTraits<typename Derived::Element>::Real,
+    Derived::ND::value - 1, Derived::ND::value - 1
+    >
+variance(ExpressionBase<Derived> const & expr, int ddof=0) {
+    typedef typename detail::ReductionTraits<typename Derived::Element>::Mean Mean;
+    return detail::reduceAxis<P>(
+        static_cast<Derived const &>(expr), detail::VarianceAccumulator<Mean>(ddof)
+    );
+}
+
+/// @brief Return the minima of an expression along dimension P; see sum<P>().
+template <int P, typename Derived>
+inline Array<
+    typename detail::ReductionTraits<typename Derived::Element>::Value,
+    Derived::ND::value - 1, Derived::ND::value - 1
+    >
+min(ExpressionBase<Derived> const & expr) {
+    typedef typename detail::ReductionTraits<typename Derived::Element>::Value Value;
+    return detail::reduceAxis<P>(
+        static_cast<Derived const &>(expr), detail::ExtremumAccumulator<Value,false>()
+    );
+}
+
+/// @brief Return the maxima of an expression along dimension P; see sum<P>().
+template <int P, typename Derived>
+inline Array<
+    typename detail::ReductionTraits<typename Derived::Element>::Value,
+    Derived::ND::value - 1, Derived::ND::value - 1
+    >
+max(ExpressionBase<Derived> const & expr) {
+    typedef typename detail::ReductionTraits<typename Derived::Element>::Value Value;
+    return detail::reduceAxis<P>(
+        static_cast<Derived const &>(expr), detail::ExtremumAccumulator<Value,true>()
+    );
+}
+
+/// @}
+
+} // namespace ndarray
+
+#endif // !NDARRAY_reductions_h_INCLUDED
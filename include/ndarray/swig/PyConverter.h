@@ -88,7 +88,7 @@ struct PyConverterBase {
     ) {
         PyPtr p(arg,true);
         if (!PyConverter<T>::fromPythonStage1(p)) return false;
-        return PyConverter<T>::fromPythonStage2(arg,*output);
+        return PyConverter<T>::fromPythonStage2(p,*output);
     }
     
 };
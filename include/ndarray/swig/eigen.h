@@ -29,7 +29,8 @@ namespace ndarray {
 template <typename T, int N, int C, typename XprKind_, int Rows_, int Cols_>
 struct PyConverter< EigenView<T,N,C,XprKind_,Rows_,Cols_> > {
     
-    static bool fromPythonStage1(PyPtr & p) {
+    /// @brief Begin a conversion; see PyConverter<Array>::fromPythonStage1() for checkOnly.
+    static bool fromPythonStage1(PyPtr & p, bool checkOnly=false) {
         // add or remove dimensions with size one so we have the right number of dimensions
         if (PyArray_Check(p.get())) {
             if ((Rows_ == 1 || Cols_ == 1) && N == 2) {
@@ -49,20 +50,26 @@ struct PyConverter< EigenView<T,N,C,XprKind_,Rows_,Cols_> > {
                 p.swap(r);
             }
         } // else let the Array converter raise the exception
-        if (!PyConverter< Array<T,N,C> >::fromPythonStage1(p)) return false;
-        // check whether the size is correct if it's static
+        if (!PyConverter< Array<T,N,C> >::fromPythonStage1(p, checkOnly)) return false;
+        // check whether the size is correct if it's static; p is now either a numpy array
+        // or an ndarray.Buffer holding an imported buffer or a copy
+        Py_ssize_t shape[N];
+        for (int n = 0; n < N; ++n) {
+            shape[n] = PyArray_Check(p.get()) ? PyArray_DIM(p.get(), n)
+                : reinterpret_cast<detail::PyBufferObject const *>(p.get())->shape[n];
+        }
         if (N == 2) {
-            if (Rows_ != Eigen::Dynamic && PyArray_DIM(p.get(), 0) != Rows_) {
+            if (Rows_ != Eigen::Dynamic && shape[0] != Rows_) {
                 PyErr_SetString(PyExc_ValueError, "incorrect number of rows for matrix");
                 return false;
             }
-            if (Cols_ != Eigen::Dynamic && PyArray_DIM(p.get(), 1) != Cols_) {
+            if (Cols_ != Eigen::Dynamic && shape[N-1] != Cols_) {
                 PyErr_SetString(PyExc_ValueError, "incorrect number of columns for matrix");
                 return false;
             }
         } else {
             int requiredSize = Rows_ * Cols_;
-            if (requiredSize != Eigen::Dynamic && PyArray_SIZE(p.get()) != requiredSize) {
+            if (requiredSize != Eigen::Dynamic && shape[0] != requiredSize) {
                 PyErr_SetString(PyExc_ValueError, "incorrect number of elements for vector");
                 return false;
             }
@@ -80,6 +87,16 @@ struct PyConverter< EigenView<T,N,C,XprKind_,Rows_,Cols_> > {
         return true;
     }
 
+    /// @brief Check convertibility without copying; see PyConverter<Array>::matches().
+    static bool matches(PyObject * arg) {
+        PyPtr p(arg,true);
+        if (!fromPythonStage1(p, true)) {
+            PyErr_Clear();
+            return false;
+        }
+        return true;
+    }
+
     static PyObject * toPython(EigenView<T,N,C,XprKind_,Rows_,Cols_> const & m, PyObject * owner=NULL) {
         PyPtr r(PyConverter< Array<T,N,C> >::toPython(m.shallow(), owner));
         if (!r) return NULL;
@@ -92,26 +109,67 @@ struct PyConverter< EigenView<T,N,C,XprKind_,Rows_,Cols_> > {
 
 namespace detail {
 
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Convert a direct-access Eigen object to a numpy array.
+ *
+ *  EigenViews already hold the Manager of their memory, and are converted by their own
+ *  PyConverter without copying.  Other Eigen objects (plain matrices and arrays, and Maps)
+ *  carry no ownership information, so they are shared only if the caller supplies the Python
+ *  object that owns their memory (as for a reference to a data member of a wrapped object);
+ *  the resulting numpy array is then read-only and holds a reference to the owner.  Without
+ *  an owner the input may be a temporary, and is copied.
+ */
+template <typename Plain, typename Input>
+inline PyObject * eigenToPython(Input const & input, PyObject * owner) {
+    if (owner == NULL) {
+        typedef typename SelectEigenView<Plain>::Type OutputView;
+        OutputView output(
+            typename SelectEigenView<Plain>::Shallow(allocate(input.rows(), input.cols()))
+        );
+        output = input;
+        return PyConverter<OutputView>::toPython(output);
+    }
+    typedef typename SelectEigenView<Plain const,false>::Type SharedView;
+    typename SharedView::PointerType data = input.data();
+    SharedView view(
+        typename SelectEigenView<Plain const,false>::Shallow(
+            external(
+                data,
+                makeVector(int(input.rows()), int(input.cols())),
+                makeVector(int(input.rowStride()), int(input.colStride()))
+            )
+        )
+    );
+    return PyConverter<SharedView>::toPython(view, owner);
+}
+
 /**
  *  @internal @ingroup ndarrayPythonInternalGroup
  *  @brief Implementations for PyConverter for Eigen objects.
  */
 template <typename Matrix>
 class EigenPyConverter : public detail::PyConverterBase<Matrix> {
-    typedef typename SelectEigenView<Matrix>::Type OutputView;
     typedef typename SelectEigenView<Matrix const, false>::Type InputView;
 public:
 
+    /**
+     *  @brief Convert to a numpy array; this copies unless an owner is given (see eigenToPython).
+     */
     static PyObject * toPython(Matrix const & input, PyObject * owner = NULL) {
-        return PyConverter<OutputView>::toPython(ndarray::copy(input), owner);
+        return eigenToPython<Matrix>(input, owner);
     }
 
     static PyTypeObject const * getPyType() {
         return &PyArray_Type;
     }
 
-    static bool fromPythonStage1(PyPtr & p) {
-        return PyConverter<InputView>::fromPythonStage1(p);
+    static bool fromPythonStage1(PyPtr & p, bool checkOnly=false) {
+        return PyConverter<InputView>::fromPythonStage1(p, checkOnly);
+    }
+
+    static bool matches(PyObject * arg) {
+        return PyConverter<InputView>::matches(arg);
     }
 
     static bool fromPythonStage2(PyPtr const & p, Matrix & output) {
@@ -143,6 +201,29 @@ struct PyConverter< Eigen::Array<Scalar,Rows,Cols,Options,MaxRows,MaxCols> >
     : public detail::EigenPyConverter< Eigen::Array<Scalar,Rows,Cols,Options,MaxRows,MaxCols> > 
 {};
 
+/**
+ *  @ingroup ndarrayPythonGroup
+ *  @brief Specialization of PyConverter for Eigen::Map, supporting only conversion to Python.
+ *
+ *  A Map does not own its memory, so it is shared with numpy only if the owning Python object
+ *  is passed to toPython(); otherwise it is copied.  Return an EigenView instead of a Map to
+ *  share memory owned by an ndarray::Array.
+ */
+template <typename PlainObjectType, int MapOptions, typename StrideType>
+struct PyConverter< Eigen::Map<PlainObjectType,MapOptions,StrideType> >
+    : public detail::PyConverterBase< Eigen::Map<PlainObjectType,MapOptions,StrideType> >
+{
+    static PyObject * toPython(
+        Eigen::Map<PlainObjectType,MapOptions,StrideType> const & input, PyObject * owner = NULL
+    ) {
+        return detail::eigenToPython<PlainObjectType>(input, owner);
+    }
+
+    static PyTypeObject const * getPyType() {
+        return &PyArray_Type;
+    }
+};
+
 } // namespace ndarray
 
 #endif // !NDARRAY_SWIG_eigen_h_INCLUDED
@@ -18,6 +18,8 @@
 
 #include "ndarray.h"
 #include "ndarray/swig/PyConverter.h"
+#include "ndarray/detail/PyBuffer.h"
+#include "ndarray/detail/PyCopyPolicy.h"
 
 namespace ndarray {
 namespace detail {
@@ -105,22 +107,33 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
      *  and optionally begin the conversion by replacing the
      *  input with an intermediate.
      *
+     *  If checkOnly is true, numpy arrays that would be copied (see PyCopyPolicy) are
+     *  accepted but left unchanged, so the result must not be passed to fromPythonStage2().
+     *
      *  \return true if a conversion may be possible, and
      *  false if it is not (with a Python exception set).
      */
     static bool fromPythonStage1(
-        PyPtr & p /**< On input, a Python object to be converted.
-                   *   On output, a Python object to be passed to
-                   *   fromPythonStage2().
-                   */
+        PyPtr & p, /**< On input, a Python object to be converted.
+                    *   On output, a Python object to be passed to
+                    *   fromPythonStage2().
+                    */
+        bool checkOnly=false
     ) {
         if (!PyArray_Check(p.get())) {
-            PyErr_SetString(PyExc_TypeError, "numpy.ndarray argument required");
-            return false;
+            if (detail::isPyBufferObject(p.get())) {
+                return detail::checkPyBufferObject<Element,N,C>(p.get());
+            }
+            if (!PyObject_CheckBuffer(p.get())) {
+                PyErr_SetString(PyExc_TypeError, "numpy.ndarray or buffer argument required");
+                return false;
+            }
+            PyPtr buffer(detail::importPyBuffer<Element,N,C>(p.get()), false);
+            if (!buffer) return false;
+            p.swap(buffer);
+            return true;
         }
-        int actualType = PyArray_TYPE(p.get());
-        int requiredType = detail::NumpyTraits<NonConst>::getCode();
-        if (actualType != requiredType) {
+        if (PyArray_TYPE(p.get()) != detail::NumpyTraits<NonConst>::getCode()) {
             PyErr_SetString(PyExc_ValueError, "numpy.ndarray argument has incorrect data type");
             return false;
         }
@@ -128,37 +141,54 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
             PyErr_SetString(PyExc_ValueError, "numpy.ndarray argument has incorrect number of dimensions");
             return false;
         }
+        int const flags = PyArray_FLAGS(p.get());
         bool writeable = !boost::is_const<Element>::value;
-        if (writeable && !(PyArray_FLAGS(p.get()) & NPY_WRITEABLE)) {
+        if (writeable && !(flags & NPY_WRITEABLE)) {
             PyErr_SetString(PyExc_TypeError, "numpy.ndarray argument must be writeable");
             return false;
         }
-        if (C > 0) {
-            int requiredStride = sizeof(Element);
-            for (int i = 0; i < C; ++i) {
-                int actualStride = PyArray_STRIDE(p.get(), N-i-1);
-                if (actualStride != requiredStride) {
-                    PyErr_SetString(
-                        PyExc_ValueError,
-                        "numpy.ndarray does not have enough row-major contiguous dimensions"
-                    );
-                    return false;
-                }
-                requiredStride *= PyArray_DIM(p.get(), N-i-1);
-            }
-        } else if (C < 0) {
-            int requiredStride = sizeof(Element);
-            for (int i = 0; i < -C; ++i) {
-                int actualStride = PyArray_STRIDE(p.get(), i);
-                if (actualStride != requiredStride) {
-                    PyErr_SetString(
-                        PyExc_ValueError,
-                        "numpy.ndarray does not have enough column-major contiguous dimensions"
-                    );
-                    return false;
-                }
-                requiredStride *= PyArray_DIM(p.get(), i);
+        bool const copyAllowed = !writeable && PyCopyPolicy::isEnabled();
+        if (!(flags & NPY_ALIGNED)) {
+            if (copyAllowed) return checkOnly || copyStage1(p);
+            PyErr_SetString(PyExc_ValueError, "unaligned arrays cannot be converted to C++");
+            return false;
+        }
+        npy_intp const * dims = PyArray_DIMS(p.get());
+        npy_intp const * strides = PyArray_STRIDES(p.get());
+        // A single pass, starting from the contiguous end, checks only the strides that
+        // must be contiguous.
+        npy_intp requiredStride = sizeof(Element);
+        for (int i = 0; i < ((C < 0) ? -C : C); ++i) {
+            int const n = (C < 0) ? i : N - i - 1;
+            if (strides[n] != requiredStride) {
+                if (copyAllowed) return checkOnly || copyStage1(p);
+                PyErr_SetString(
+                    PyExc_ValueError,
+                    (C < 0) ? "numpy.ndarray does not have enough column-major contiguous dimensions"
+                            : "numpy.ndarray does not have enough row-major contiguous dimensions"
+                );
+                return false;
             }
+            requiredStride *= dims[n];
+        }
+        return true;
+    }
+
+    /**
+     *  @brief Check if a Python object might be convertible to an Array, without
+     *  making the copy the conversion may require.
+     *
+     *  This is used by the SWIG typecheck typemaps, so overload resolution does not copy
+     *  arguments (or record copies) that are then converted again.
+     *
+     *  \return true if the conversion may be successful, and false if it definitely is
+     *  not.  Will not raise a Python exception.
+     */
+    static bool matches(PyObject * arg) {
+        PyPtr p(arg,true);
+        if (!fromPythonStage1(p, true)) {
+            PyErr_Clear();
+            return false;
         }
         return true;
     }
@@ -166,12 +196,14 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
     /**
      *  @brief Complete a Python to C++ conversion begun with fromPythonStage1().
      * 
-     *  The copy will be shallow if possible and deep if necessary to meet the data type
-     *  and contiguousness requirements.  If a non-const array is required, the copy will
-     *  always be shallow; if this is not possible, ValueError will be raised.
+     *  The copy will be shallow if possible.  If a const array is required and
+     *  PyCopyPolicy is enabled, arrays that are unaligned or not contiguous enough are
+     *  deep-copied; otherwise (and always for non-const arrays), ValueError will be raised.
      *
      *  The output Array's shared_ptr owner attribute will own a reference to the numpy
-     *  array that ultimately owns the data (either the original or the copy).
+     *  array that ultimately owns the data (either the original or the copy).  Objects
+     *  that are not numpy arrays but support the buffer protocol are never copied; the
+     *  Array's owner holds the Py_buffer acquired in fromPythonStage1().
      *
      *  \return true on success, false on failure (with a Python exception set).
      */
@@ -179,19 +211,20 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
         PyPtr const & input,  ///< Result of fromPythonStage1().
         Array<T,N,C> & output ///< Reference to existing output C++ object.
     ) {
-        if (!(PyArray_FLAGS(input.get()) & NPY_ALIGNED)) {
-            PyErr_SetString(PyExc_ValueError, "unaligned arrays cannot be converted to C++");
-            return false;
+        if (detail::isPyBufferObject(input.get())) {
+            return detail::extractPyBuffer(input.get(), output);
         }
+        // The layout is re-read rather than cached by stage 1: SWIG checks other arguments
+        // and overloads between its typecheck and in typemaps, and addresses are reused.
         Vector<int,N> shape;
         Vector<int,N> strides;
-        std::copy(PyArray_DIMS(input.get()), PyArray_DIMS(input.get()) + N, shape.begin());
-        std::copy(PyArray_STRIDES(input.get()), PyArray_STRIDES(input.get()) + N , strides.begin());
-        for (int i = 0; i < N; ++i) strides[i] /= sizeof(Element);
-        output = external(
-            reinterpret_cast<Element*>(PyArray_DATA(input.get())),
-            shape, strides, input
-        );
+        npy_intp const * dims = PyArray_DIMS(input.get());
+        npy_intp const * byteStrides = PyArray_STRIDES(input.get());
+        for (int i = 0; i < N; ++i) {
+            shape[i] = dims[i];
+            strides[i] = byteStrides[i] / npy_intp(sizeof(Element));
+        }
+        output = external(reinterpret_cast<Element*>(PyArray_DATA(input.get())), shape, strides, input);
         return true;
     }
 
@@ -200,7 +233,8 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
      *
      *  The Array will be shallow-copied with reference counting if either
      *  m.getManager() is not empty or the optional owner argument is supplied;
-     *  otherwise a deep copy will be made.
+     *  otherwise a deep copy will be made.  The Manager is preferred when both are
+     *  available, as it keeps the memory alive even if the owner's Array is reassigned.
      *
      *  \return a new Python object, or NULL on failure (with
      *  a Python exception set).
@@ -235,10 +269,10 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
             if (!r) return NULL;
             array.swap(r);
         } else {
-            if (owner != NULL) {
-                Py_INCREF(owner);
-            } else {
+            if (m.getManager()) {
                 owner = PyCObject_FromVoidPtr(new Manager::Ptr(m.getManager()), detail::destroyCObject);
+            } else {
+                Py_INCREF(owner);
             }
             reinterpret_cast<PyArrayObject*>(array.get())->base = owner;
         }
@@ -246,7 +280,35 @@ struct PyConverter< Array<T,N,C> > : public detail::PyConverterBase< Array<T,N,C
         return PyArray_Return(reinterpret_cast<PyArrayObject*>(array.get()));
     }
 
+    /**
+     *  @brief Create an object that exports an ndarray::Array with the buffer protocol.
+     *
+     *  Unlike toPython(), this does not use the numpy C API; the result can be passed to
+     *  memoryview or numpy.asarray.  The Array will be shallow-copied if m.getManager() is
+     *  not empty, and deep-copied otherwise.
+     *
+     *  \return a new Python object, or NULL on failure (with
+     *  a Python exception set).
+     */
+    static PyObject* toPyBuffer(Array<T,N,C> const & m) {
+        return detail::exportPyBuffer(m);
+    }
+
     static PyTypeObject const * getPyType() { return &PyArray_Type; }
+
+private:
+
+    // Replace a numpy array that failed the alignment or stride checks with a buffer that
+    // exports a contiguous copy (see PyCopyPolicy).
+    static bool copyStage1(PyPtr & p) {
+        Array<T,N,C> copy = detail::copyToContiguous<Element,N,C>(
+            p.get(), PyArray_DATA(p.get()), PyArray_DIMS(p.get()), PyArray_STRIDES(p.get())
+        );
+        PyPtr buffer(detail::exportPyBuffer(copy), false);
+        if (!buffer) return false;
+        p.swap(buffer);
+        return true;
+    }
 };
 
 } // namespace ndarray
@@ -11,117 +11,329 @@
 #ifndef NDARRAY_SWIG_ufunctors_h_INCLUDED
 #define NDARRAY_SWIG_ufunctors_h_INCLUDED
 
-/** 
+/**
  *  \file ndarray/swig/ufunctors.h
  *  @brief Python wrappers to create numpy ufunc objects from C++ function objects.
+ *
+ *  Both the direct _call_() wrappers and the ufunc objects created by makeUFunc() run the
+ *  C++ function object in inner loops over whole contiguous or strided chunks, with the GIL
+ *  released, so the function object must not use the Python C API.  Exceptions thrown by
+ *  the function object stop the loop and are raised in Python as RuntimeError.  Modules that
+ *  call makeUFunc() must call import_ufunc() in addition to import_array() when initialized.
  */
 
+#include <exception>
+#include <string>
+
 #include "ndarray/swig/numpy.h"
 
 namespace ndarray {
+namespace detail {
 
-template <typename TUnaryFunctor, 
-          typename TArgument=typename TUnaryFunctor::argument_type,
-          typename TResult=typename TUnaryFunctor::result_type>
-struct PyUnaryUFunctor {
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Set a Python RuntimeError for the C++ exception being handled.
+ *
+ *  Must be called from a catch block, with the GIL held.
+ */
+inline void setUFuncError() {
+    try {
+        throw;
+    } catch (std::exception & err) {
+        PyErr_SetString(PyExc_RuntimeError, err.what());
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "unknown C++ exception in ufunc function object");
+    }
+}
 
-    static PyObject* _call_(TUnaryFunctor const& self, PyObject* input, PyObject* output) {
-        PyObject* input_array = PyArray_FROM_OTF(input,detail::NumpyTraits<TArgument>::getCode(),
-                                                 NPY_ALIGNED);
-        if (input_array == NULL) return NULL;
-        PyObject* output_array;
-        if (output == NULL || output == Py_None) {
-            output_array = PyArray_SimpleNew(PyArray_NDIM(input_array),
-                                             PyArray_DIMS(input_array),
-                                             detail::NumpyTraits<TResult>::getCode());
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Deduces the size argument type of numpy's ufunc inner loop signature, which
+ *         gained const qualifiers in later numpy versions.
+ */
+template <typename F> struct UFuncLoopTraits;
+
+template <typename Size>
+struct UFuncLoopTraits<void (*)(char **, Size *, Size *, void *)> {
+    typedef Size SizeArg;
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Inner loop that applies a unary function object to one chunk of a ufunc call.
+ *
+ *  Chunks with contiguous operands are processed with plain pointer loops the compiler can
+ *  vectorize; others step by byte strides.
+ */
+template <typename TUnaryFunctor, typename TArgument, typename TResult>
+struct UnaryUFuncKernel {
+    enum { NOP = 2 };
+
+    static void apply(TUnaryFunctor const & self, char ** data, npy_intp const * steps,
+                      npy_intp size) {
+        if (steps[0] == npy_intp(sizeof(TArgument)) && steps[1] == npy_intp(sizeof(TResult))) {
+            TArgument const * arg = reinterpret_cast<TArgument const *>(data[0]);
+            TResult * res = reinterpret_cast<TResult *>(data[1]);
+            for (npy_intp i = 0; i < size; ++i) res[i] = self(arg[i]);
+        } else {
+            char * arg = data[0];
+            char * res = data[1];
+            for (npy_intp i = 0; i < size; ++i, arg += steps[0], res += steps[1]) {
+                *reinterpret_cast<TResult *>(res) = self(*reinterpret_cast<TArgument const *>(arg));
+            }
+        }
+    }
+
+    static void getTypeCodes(int * codes) {
+        codes[0] = NumpyTraits<TArgument>::getCode();
+        codes[1] = NumpyTraits<TResult>::getCode();
+    }
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Inner loop that applies a binary function object to one chunk of a ufunc call.
+ */
+template <typename TBinaryFunctor, typename TArgument1, typename TArgument2, typename TResult>
+struct BinaryUFuncKernel {
+    enum { NOP = 3 };
+
+    static void apply(TBinaryFunctor const & self, char ** data, npy_intp const * steps,
+                      npy_intp size) {
+        if (steps[0] == npy_intp(sizeof(TArgument1)) && steps[1] == npy_intp(sizeof(TArgument2))
+            && steps[2] == npy_intp(sizeof(TResult))) {
+            TArgument1 const * arg1 = reinterpret_cast<TArgument1 const *>(data[0]);
+            TArgument2 const * arg2 = reinterpret_cast<TArgument2 const *>(data[1]);
+            TResult * res = reinterpret_cast<TResult *>(data[2]);
+            for (npy_intp i = 0; i < size; ++i) res[i] = self(arg1[i], arg2[i]);
+        } else {
+            char * arg1 = data[0];
+            char * arg2 = data[1];
+            char * res = data[2];
+            for (npy_intp i = 0; i < size;
+                 ++i, arg1 += steps[0], arg2 += steps[1], res += steps[2]) {
+                *reinterpret_cast<TResult *>(res) = self(
+                    *reinterpret_cast<TArgument1 const *>(arg1),
+                    *reinterpret_cast<TArgument2 const *>(arg2)
+                );
+            }
+        }
+    }
+
+    static void getTypeCodes(int * codes) {
+        codes[0] = NumpyTraits<TArgument1>::getCode();
+        codes[1] = NumpyTraits<TArgument2>::getCode();
+        codes[2] = NumpyTraits<TResult>::getCode();
+    }
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Apply a ufunc kernel to Python objects with a buffered numpy iterator.
+ *
+ *  The iterator broadcasts the inputs, casts them (and the output) to the kernel's types one
+ *  buffer at a time only when needed, and allocates the output if it is NULL or None; arrays
+ *  that already have the right types are processed in place, with no copies.  The GIL is
+ *  released while the kernel runs.
+ *
+ *  \return the output array (a new reference), or NULL with a Python exception set.
+ */
+template <typename Kernel, typename Functor>
+PyObject * iterateUFunc(Functor const & self, PyObject ** args) {
+    static int const NOP = Kernel::NOP;
+    int codes[NOP];
+    Kernel::getTypeCodes(codes);
+    PyArrayObject * ops[NOP];
+    PyArray_Descr * dtypes[NOP];
+    npy_uint32 opFlags[NOP];
+    bool failed = false;
+    for (int k = 0; k < NOP; ++k) {
+        ops[k] = NULL;
+        dtypes[k] = PyArray_DescrFromType(codes[k]);
+        opFlags[k] = NPY_ITER_NBO | NPY_ITER_ALIGNED;
+        if (failed) continue;
+        if (k < NOP - 1) {
+            opFlags[k] |= NPY_ITER_READONLY;
+            ops[k] = reinterpret_cast<PyArrayObject *>(PyArray_FROM_O(args[k]));
+            if (ops[k] == NULL) failed = true;
+        } else if (args[k] == NULL || args[k] == Py_None) {
+            opFlags[k] |= NPY_ITER_WRITEONLY | NPY_ITER_ALLOCATE;
+        } else if (PyArray_Check(args[k])) {
+            opFlags[k] |= NPY_ITER_WRITEONLY | NPY_ITER_NO_BROADCAST;
+            Py_INCREF(args[k]);
+            ops[k] = reinterpret_cast<PyArrayObject *>(args[k]);
         } else {
-            output_array = PyArray_FROM_OTF(output,detail::NumpyTraits<TResult>::getCode(),
-                                            NPY_ALIGNED | NPY_WRITEABLE | NPY_UPDATEIFCOPY);
+            PyErr_SetString(PyExc_TypeError, "ufunc output argument must be a numpy.ndarray");
+            failed = true;
         }
-        if (output_array == NULL) {
-            Py_DECREF(input_array);
+    }
+    NpyIter * iter = NULL;
+    if (!failed) {
+        iter = NpyIter_MultiNew(
+            NOP, ops,
+            NPY_ITER_EXTERNAL_LOOP | NPY_ITER_BUFFERED | NPY_ITER_GROWINNER
+            | NPY_ITER_ZEROSIZE_OK | NPY_ITER_DELAY_BUFALLOC,
+            NPY_KEEPORDER, NPY_SAME_KIND_CASTING, opFlags, dtypes
+        );
+    }
+    for (int k = 0; k < NOP; ++k) {
+        Py_XDECREF(ops[k]);
+        Py_XDECREF(dtypes[k]);
+    }
+    if (iter == NULL) return NULL;
+    if (NpyIter_GetIterSize(iter) > 0) {
+        if (NpyIter_Reset(iter, NULL) != NPY_SUCCEED) {
+            NpyIter_Deallocate(iter);
             return NULL;
         }
-        PyObject* iter = PyArray_MultiIterNew(2,input_array,output_array);
-        if (iter == NULL) {
-            Py_DECREF(input_array);
-            Py_DECREF(output_array);
+        NpyIter_IterNextFunc * next = NpyIter_GetIterNext(iter, NULL);
+        if (next == NULL) {
+            NpyIter_Deallocate(iter);
             return NULL;
         }
-        int size = ((PyArrayMultiIterObject*)(iter))->size;
-        while (size--) {
-            TArgument* arg = (TArgument*)PyArray_MultiIter_DATA(iter,0);
-            TResult* res = (TResult*)PyArray_MultiIter_DATA(iter,1);
-            *res = self(*arg);
-            PyArray_MultiIter_NEXT(iter);
+        char ** data = NpyIter_GetDataPtrArray(iter);
+        npy_intp * steps = NpyIter_GetInnerStrideArray(iter);
+        npy_intp * size = NpyIter_GetInnerLoopSizePtr(iter);
+        NPY_BEGIN_THREADS_DEF;
+        if (!NpyIter_IterationNeedsAPI(iter)) {
+            NPY_BEGIN_THREADS;
         }
-        Py_DECREF(input_array);
-        Py_DECREF(iter);
-        return PyArray_Return(reinterpret_cast<PyArrayObject*>(output_array));
+        try {
+            do {
+                Kernel::apply(self, data, steps, *size);
+            } while (next(iter));
+        } catch (...) {
+            NPY_END_THREADS;
+            setUFuncError();
+        }
+        NPY_END_THREADS;
+    }
+    PyObject * output = reinterpret_cast<PyObject *>(NpyIter_GetOperandArray(iter)[NOP - 1]);
+    Py_INCREF(output);
+    if (NpyIter_Deallocate(iter) != NPY_SUCCEED || PyErr_Occurred()) {
+        Py_DECREF(output);
+        return NULL;
+    }
+    return PyArray_Return(reinterpret_cast<PyArrayObject *>(output));
+}
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Storage for a function object and the loop tables of the numpy ufunc that calls it.
+ *
+ *  Numpy does not copy these tables, or the ufunc's name and docstring, so they are allocated
+ *  together and owned by the ufunc.
+ */
+template <typename Kernel, typename Functor>
+struct UFuncStorage {
+    typedef typename UFuncLoopTraits<PyUFuncGenericFunction>::SizeArg SizeArg;
+
+    UFuncStorage(Functor const & self_, char const * name_, char const * doc_) :
+        self(self_), name(name_), doc(doc_)
+    {
+        functions[0] = &loop;
+        data[0] = this;
+        int codes[Kernel::NOP];
+        Kernel::getTypeCodes(codes);
+        for (int k = 0; k < Kernel::NOP; ++k) types[k] = char(codes[k]);
+    }
+
+    // Called by numpy, usually without the GIL; exceptions must not propagate into numpy.
+    static void loop(char ** args, SizeArg * dimensions, SizeArg * steps, void * data) {
+        try {
+            Kernel::apply(static_cast<UFuncStorage const *>(data)->self, args, steps, dimensions[0]);
+        } catch (...) {
+            PyGILState_STATE state = PyGILState_Ensure();
+            setUFuncError();
+            PyGILState_Release(state);
+        }
+    }
+
+    static void destroy(void * p) { delete static_cast<UFuncStorage *>(p); }
+
+    Functor self;
+    std::string name;
+    std::string doc;
+    PyUFuncGenericFunction functions[1];
+    void * data[1];
+    char types[Kernel::NOP];
+};
+
+/**
+ *  @internal @ingroup ndarrayPythonInternalGroup
+ *  @brief Create a numpy ufunc with a single loop that calls the given function object.
+ */
+template <typename Kernel, typename Functor>
+PyObject * makeUFunc(Functor const & self, char const * name, char const * doc) {
+    typedef UFuncStorage<Kernel,Functor> Storage;
+    Storage * storage = new Storage(self, name, doc);
+    PyPtr owner(PyCObject_FromVoidPtr(storage, &Storage::destroy), false);
+    if (!owner) {
+        delete storage;
+        return NULL;
+    }
+    PyObject * ufunc = PyUFunc_FromFuncAndData(
+        storage->functions, storage->data, storage->types, 1, Kernel::NOP - 1, 1, PyUFunc_None,
+        const_cast<char *>(storage->name.c_str()), const_cast<char *>(storage->doc.c_str()), 0
+    );
+    if (ufunc == NULL) return NULL;
+    reinterpret_cast<PyUFuncObject *>(ufunc)->obj = owner.get();
+    Py_INCREF(owner.get());
+    return ufunc;
+}
+
+} // namespace ndarray::detail
+
+template <typename TUnaryFunctor,
+          typename TArgument=typename TUnaryFunctor::argument_type,
+          typename TResult=typename TUnaryFunctor::result_type>
+struct PyUnaryUFunctor {
+    typedef detail::UnaryUFuncKernel<TUnaryFunctor,TArgument,TResult> Kernel;
+
+    /**
+     *  @brief Apply the function object elementwise to a Python object.
+     *
+     *  If output is NULL or None, a new array is returned; otherwise output must be an array
+     *  with the broadcast shape of the input, and is filled and returned.
+     */
+    static PyObject* _call_(TUnaryFunctor const& self, PyObject* input, PyObject* output) {
+        PyObject * args[2] = { input, output };
+        return detail::iterateUFunc<Kernel>(self, args);
+    }
+
+    /// @brief Create a numpy ufunc object that calls the given function object.
+    static PyObject* makeUFunc(TUnaryFunctor const& self, char const * name, char const * doc="") {
+        return detail::makeUFunc<Kernel>(self, name, doc);
     }
-    
+
 };
 
 
-template <typename TBinaryFunctor, 
+template <typename TBinaryFunctor,
           typename TArgument1=typename TBinaryFunctor::first_argument_type,
           typename TArgument2=typename TBinaryFunctor::second_argument_type,
           typename TResult=typename TBinaryFunctor::result_type>
 struct PyBinaryUFunctor {
+    typedef detail::BinaryUFuncKernel<TBinaryFunctor,TArgument1,TArgument2,TResult> Kernel;
 
-    static PyObject* _call_(TBinaryFunctor const& self, PyObject* input1, PyObject* input2, 
+    /**
+     *  @brief Apply the function object elementwise to a pair of Python objects.
+     *
+     *  The inputs are broadcast against each other.  If output is NULL or None, a new array
+     *  is returned; otherwise output must be an array with the broadcast shape, and is filled
+     *  and returned.
+     */
+    static PyObject* _call_(TBinaryFunctor const& self, PyObject* input1, PyObject* input2,
                               PyObject* output) {
-        PyObject* input1_array = PyArray_FROM_OTF(input1,detail::NumpyTraits<TArgument1>::getCode(),
-                                                  NPY_ALIGNED);
-        PyObject* input2_array = PyArray_FROM_OTF(input2,detail::NumpyTraits<TArgument1>::getCode(),
-                                                  NPY_ALIGNED);
-        if (input1_array == NULL || input2_array == NULL) {
-            Py_XDECREF(input1_array);
-            Py_XDECREF(input2_array);
-            return NULL;
-        }
-        PyObject* output_array;
-        if (output == NULL || output == Py_None) {
-            PyObject* tmp = PyArray_MultiIterNew(2,input1_array,input2_array);
-            if (tmp == NULL) {
-                Py_XDECREF(input1_array);
-                Py_XDECREF(input2_array);
-                return NULL;
-            }
-            PyArrayMultiIterObject* tmp_iter = (PyArrayMultiIterObject*)tmp;
-            output_array = PyArray_SimpleNew(tmp_iter->nd,tmp_iter->dimensions,
-                                             detail::NumpyTraits<TResult>::getCode());
-            Py_DECREF(tmp);
-        } else {
-            output_array = PyArray_FROM_OTF(output,detail::NumpyTraits<TResult>::getCode(),
-                                            NPY_ALIGNED | NPY_WRITEABLE | NPY_UPDATEIFCOPY);
-        }
-        if (output_array == NULL) {
-            Py_DECREF(input1_array);
-            Py_DECREF(input2_array);
-            return NULL;
-        }
-        PyObject* iter = PyArray_MultiIterNew(3,input1_array,input2_array,output_array);
-        if (iter == NULL) {
-            Py_DECREF(input1_array);
-            Py_DECREF(input2_array);
-            Py_DECREF(output_array);
-            return NULL;
-        }
-        int size = ((PyArrayMultiIterObject*)(iter))->size;
-        while (size--) {
-            TArgument1* arg1 = (TArgument1*)PyArray_MultiIter_DATA(iter,0);
-            TArgument2* arg2 = (TArgument2*)PyArray_MultiIter_DATA(iter,1);
-            TResult* res = (TResult*)PyArray_MultiIter_DATA(iter,2);
-            *res = self(*arg1,*arg2);
-            PyArray_MultiIter_NEXT(iter);
-        }
-        Py_DECREF(input1_array);
-        Py_DECREF(input2_array);
-        Py_DECREF(iter);
-        return PyArray_Return(reinterpret_cast<PyArrayObject*>(output_array));
+        PyObject * args[3] = { input1, input2, output };
+        return detail::iterateUFunc<Kernel>(self, args);
     }
-    
+
+    /// @brief Create a numpy ufunc object that calls the given function object.
+    static PyObject* makeUFunc(TBinaryFunctor const& self, char const * name, char const * doc="") {
+        return detail::makeUFunc<Kernel>(self, name, doc);
+    }
+
 };
 
 } // namespace ndarray
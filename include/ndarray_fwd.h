@@ -43,6 +43,7 @@ namespace ndarray {
 template <typename T, int N, int C> struct ArrayTraits;
 template <typename Expression_> struct ExpressionTraits;
 class Manager;
+class AllocationPolicy;
 
 /// @brief An enumeration for stride computation.
 enum DataOrderEnum { ROW_MAJOR=1, COLUMN_MAJOR=2 };
@@ -97,6 +98,7 @@ template <typename Derived> class ExpressionBase;
 template <typename Derived> class ArrayBase;
 template <typename T, int N, int C=0> class ArrayRef;
 template <typename T, int N, int C=0> class Array;
+template <typename T> class DynamicArray;
 template <typename T, int N> struct Vector;
 
 } // namespace ndarray
@@ -0,0 +1,81 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+
+#include "ndarray/bp/auto.h"
+
+// Reproduces the Array converter used before FromBoostPython<Array>::convertible() built the
+// result in a single pass: convertible() validates the array, and operator() reads the
+// array's attributes again.
+template <typename T, int N, int C>
+static bool legacyConvertible(boost::python::object const & input) {
+    try {
+        boost::numpy::ndarray array = boost::python::extract<boost::numpy::ndarray>(input);
+        boost::numpy::dtype dtype
+            = boost::numpy::dtype::get_builtin<typename boost::remove_const<T>::type>();
+        boost::numpy::ndarray::bitflag flags = array.get_flags();
+        if (dtype != array.get_dtype()) return false;
+        if (N != array.get_nd()) return false;
+        if (!boost::is_const<T>::value && !(flags & boost::numpy::ndarray::WRITEABLE)) return false;
+        int requiredStride = sizeof(T);
+        for (int i = 0; i < C; ++i) {
+            if (array.strides(N-i-1) != requiredStride) return false;
+            requiredStride *= array.shape(N-i-1);
+        }
+    } catch (boost::python::error_already_set) {
+        boost::python::handle_exception();
+        PyErr_Clear();
+        return false;
+    }
+    return true;
+}
+
+template <typename T, int N, int C>
+static ndarray::Array<T,N,C> legacyConvert(boost::python::object const & input) {
+    boost::numpy::ndarray array = boost::python::extract<boost::numpy::ndarray>(input);
+    boost::numpy::dtype dtype = array.get_dtype();
+    int itemsize = dtype.get_itemsize();
+    boost::python::object obj_owner = array.get_base();
+    if (obj_owner.is_none()) {
+        obj_owner = array;
+    }
+    ndarray::Vector<int,N> shape;
+    ndarray::Vector<int,N> strides;
+    for (int i=0; i<N; ++i) {
+        shape[i] = array.shape(i);
+        strides[i] = array.strides(i) / itemsize;
+    }
+    return ndarray::external(reinterpret_cast<T*>(array.get_data()), shape, strides, obj_owner);
+}
+
+static void noop(boost::python::object const &) {}
+
+template <typename T, int N, int C>
+static void legacyArray(boost::python::object const & input) {
+    if (!legacyConvertible<T,N,C>(input)) {
+        PyErr_SetString(PyExc_TypeError, "object cannot be converted to ndarray::Array");
+        boost::python::throw_error_already_set();
+    }
+    ndarray::Array<T,N,C> array = legacyConvert<T,N,C>(input);
+}
+
+template <typename T, int N, int C>
+static void passArray(ndarray::Array<T,N,C> const &) {}
+
+BOOST_PYTHON_MODULE(bp_bench_mod) {
+    boost::numpy::initialize();
+    boost::python::def("noop", noop);
+    boost::python::def("legacyArray1", legacyArray<double,1,1>);
+    boost::python::def("legacyArray2", legacyArray<double,2,1>);
+    boost::python::def("legacyArray3", legacyArray<double,3,1>);
+    boost::python::def("passArray1", passArray<double,1,1>);
+    boost::python::def("passArray2", passArray<double,2,1>);
+    boost::python::def("passArray3", passArray<double,3,1>);
+}
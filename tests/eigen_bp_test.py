@@ -82,6 +82,17 @@ class TestEigenWrappers(unittest.TestCase):
             self.assert_(not obj.getMatrix_cref().flags["WRITEABLE"])
             self.assert_(not obj.getMatrix_ref().flags["OWNDATA"])
             self.assert_(not obj.getMatrix_cref().flags["OWNDATA"])
+            address = obj.getMatrix_cref().__array_interface__["data"][0]
+            self.assertEqual(obj.getMatrix_ref().__array_interface__["data"][0], address)
+            # Maps returned by value are copied; with ReturnInternal they share memory
+            m1 = obj.getMap()
+            self.assert_((m1 == self.matrix_p_d).all())
+            self.assertNotEqual(m1.__array_interface__["data"][0], address)
+            self.assert_(m1.flags["WRITEABLE"])
+            m2 = obj.getMap_internal()
+            self.assert_((m2 == self.matrix_p_d).all())
+            self.assertEqual(m2.__array_interface__["data"][0], address)
+            self.assert_(m2.base is obj)
 
 if __name__=="__main__":
     unittest.main()
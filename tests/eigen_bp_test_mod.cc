@@ -82,6 +82,7 @@ public:
 
     M const & getMatrix_cref() const { return _matrix; }
     M & getMatrix_ref() { return _matrix; }
+    Eigen::Map<M> getMap() { return Eigen::Map<M>(_matrix.data(), _matrix.rows(), _matrix.cols()); }
 
     bool compareData(bn::matrix const & mp) const {
         return _matrix.data() == reinterpret_cast<double const*>(mp.get_data());
@@ -95,6 +96,9 @@ public:
                  ndarray::ReturnInternal<>())
             .def("getMatrix_ref", &MatrixOwner::getMatrix_ref,
                  ndarray::ReturnInternal<>())
+            .def("getMap", &MatrixOwner::getMap)
+            .def("getMap_internal", &MatrixOwner::getMap,
+                 ndarray::ReturnInternal<>())
             .def("compareData", &MatrixOwner::compareData)
             ;
     }
@@ -0,0 +1,361 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+
+/*
+ *  Microbenchmarks for ndarray.  These are not unit tests; build them with
+ *  "scons benchmarks" and run the resulting binary with optimization enabled.
+ */
+#include "ndarray.h"
+#include "ndarray/fft/FourierOps.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace {
+
+/// Report the time per iteration of one or more alternative implementations.
+class Report {
+public:
+
+    explicit Report(std::string const & name) : _baseline(0.0) {
+        std::cout << name << "\n";
+    }
+
+    void operator()(std::string const & label, std::clock_t start, int nIterations) {
+        double t = double(std::clock() - start) / CLOCKS_PER_SEC / nIterations;
+        std::cout << "    " << std::left << std::setw(32) << label
+                  << std::right << std::setw(12) << std::setprecision(4) << t * 1E6 << " us";
+        if (_baseline > 0.0) {
+            std::cout << std::setw(10) << std::setprecision(3) << _baseline / t << "x";
+        } else {
+            _baseline = t;
+        }
+        std::cout << "\n";
+    }
+
+private:
+    double _baseline;
+};
+
+// Reproduces the nested-iterator evaluation ArrayRef assignment used before the flat
+// evaluation path existed: one ArrayRef<T,N-1> proxy per row, recursively.
+template <typename AssignOp, typename T, int C, typename Expression>
+void nestedApply(ndarray::ArrayRef<T,1,C> const & dest, Expression const & expr, AssignOp const & op) {
+    typename ndarray::ArrayRef<T,1,C>::Iterator const i_end = dest.end();
+    typename Expression::Iterator j = expr.begin();
+    for (typename ndarray::ArrayRef<T,1,C>::Iterator i = dest.begin(); i != i_end; ++i, ++j) {
+        op(*i, *j);
+    }
+}
+
+template <typename AssignOp, typename T, int N, int C, typename Expression>
+void nestedApply(ndarray::ArrayRef<T,N,C> const & dest, Expression const & expr, AssignOp const & op) {
+    typename ndarray::ArrayRef<T,N,C>::Iterator const i_end = dest.end();
+    typename Expression::Iterator j = expr.begin();
+    for (typename ndarray::ArrayRef<T,N,C>::Iterator i = dest.begin(); i != i_end; ++i, ++j) {
+        nestedApply(*i, *j, op);
+    }
+}
+
+template <int N>
+void benchmarkAssignment(ndarray::Vector<int,N> const & shape, int nIterations) {
+    ndarray::Array<float,N,N> a = ndarray::allocate(shape);
+    ndarray::Array<float,N,N> b = ndarray::allocate(shape);
+    ndarray::Array<float,N,N> c = ndarray::allocate(shape);
+    a.deep() = 1.5f;
+    b.deep() = 0.5f;
+    c.deep() = 0.0f;
+
+    std::ostringstream suffix;
+    suffix << ", shape=" << shape;
+
+    Report assign("c = a*b + a" + suffix.str());
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        nestedApply(c.deep(), a * b + a, ndarray::detail::Assign());
+    }
+    assign("nested", start, nIterations);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        c.deep() = a * b + a;
+    }
+    assign("flat", start, nIterations);
+
+    Report augmented("c += b" + suffix.str());
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        nestedApply(c.deep(), b, ndarray::detail::PlusAssign());
+    }
+    augmented("nested", start, nIterations);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        c.deep() += b;
+    }
+    augmented("flat", start, nIterations);
+}
+
+template <typename T>
+void benchmarkPacketEvaluation(int size, int nIterations) {
+    ndarray::Array<T,1,1> a = ndarray::allocate(size);
+    ndarray::Array<T,1,1> b = ndarray::allocate(size);
+    ndarray::Array<T,1,1> c = ndarray::allocate(size);
+    ndarray::Array<T,1,1> d = ndarray::allocate(size);
+    a.deep() = T(1.5);
+    b.deep() = T(0.5);
+    c.deep() = T(2.0);
+
+    std::ostringstream name;
+    name << "d = a*b + c, " << sizeof(T) << "-byte elements, size=" << size;
+    Report report(name.str());
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        typedef ndarray::detail::FlatTraits<
+            ndarray::detail::BinaryOpExpression<
+                ndarray::detail::BinaryOpExpression<
+                    ndarray::Array<T,1,1>, ndarray::Array<T,1,1>,
+                    ndarray::detail::MultipliesTag::ScalarFunction<T,T>
+                    >,
+                ndarray::Array<T,1,1>,
+                ndarray::detail::PlusTag::ScalarFunction<T,T>
+                >
+            > Traits;
+        ndarray::detail::flatLoop(
+            d.getData(), Traits::getCursor(a * b + c), 0, size,
+            ndarray::detail::Assign(), boost::mpl::false_()
+        );
+    }
+    report("scalar", start, nIterations);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        d.deep() = a * b + c;
+    }
+    report("packet", start, nIterations);
+}
+
+void benchmarkViewCreation(int nIterations) {
+    ndarray::Array<float,3,3> a = ndarray::allocate(ndarray::makeVector(64, 64, 4));
+    a.deep() = 1.0f;
+#ifdef NDARRAY_NO_CORE_POOL
+    std::string const suffix = ", global heap Cores";
+#else
+    std::string const suffix = ", pooled Cores";
+#endif
+    float total = 0.0f;
+    Report view("view creation" + suffix);
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        for (int i = 0; i < 62; ++i) {
+            ndarray::ArrayRef<float,3> sub = a[ndarray::view(i, i + 2)(1, 63, 2)()];
+            total += sub[1][0][0];
+        }
+    }
+    view("a[view(i, i+2)(1, 63, 2)()]", start, nIterations * 62);
+    Report flatten("flatten" + suffix);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        for (int i = 0; i < 62; ++i) {
+            ndarray::Array<float,2,2> flat = ndarray::flatten<2>(a);
+            total += flat[i][0];
+        }
+    }
+    flatten("flatten<2>(a)", start, nIterations * 62);
+    if (total == 0.0f) std::cout << "";  // keep the loops from being optimized away
+}
+
+void benchmarkSum(int size, int nIterations) {
+    ndarray::Array<float,2,2> a = ndarray::allocate(size, size);
+    ndarray::Array<float,2,2> b = ndarray::allocate(size, size);
+    a.deep() = 0.1f;
+    b.deep() = 3.0f;
+    std::ostringstream name;
+    name << "sum(a*b), " << size << "x" << size << " float";
+    Report report(name.str());
+    float naive = 0.0f;
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        naive = 0.0f;
+        for (int i = 0; i < size; ++i) {
+            for (int j = 0; j < size; ++j) naive += a[i][j] * b[i][j];
+        }
+    }
+    report("nested loop", start, nIterations);
+    float pairwise = 0.0f;
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        pairwise = ndarray::sum(a * b);
+    }
+    report("ndarray::sum", start, nIterations);
+    double const exact = double(size) * size * (double(0.1f) * 3.0);
+    std::cout << "    relative error: nested loop " << std::abs(naive - exact) / exact
+              << ", ndarray::sum " << std::abs(pairwise - exact) / exact << "\n";
+}
+
+// Reproduces the row-major gather into a buffer that reductions used for expressions that
+// could not be traversed flat.
+template <typename Expression>
+float gatherSum(Expression const & expr) {
+    typedef ndarray::detail::SumVisitor<float> Visitor;
+    Visitor visitor;
+    ndarray::detail::ReductionBuffer<float,Visitor> buffer(visitor);
+    ndarray::detail::gatherRows(expr.begin(), expr.end(), buffer, boost::mpl::int_<3>());
+    buffer.flush();
+    return visitor.get();
+}
+
+void benchmarkPlannedEvaluation(int size, int nIterations) {
+    // Operands are column-major views that skip the last row, so they are neither dense nor
+    // row-major, and flat evaluation does not apply.
+    ndarray::Array<float,3,3> at = ndarray::allocate(size + 1, size, size);
+    ndarray::Array<float,3,3> bt = ndarray::allocate(size + 1, size, size);
+    ndarray::Array<float,3,3> ct = ndarray::allocate(size + 1, size, size);
+    at.deep() = 1.5f;
+    bt.deep() = 0.5f;
+    ndarray::Array<float,3,-2> a = at[ndarray::view(0, size)()()].transpose();
+    ndarray::Array<float,3,-2> b = bt[ndarray::view(0, size)()()].transpose();
+    ndarray::Array<float,3,-2> c = ct[ndarray::view(0, size)()()].transpose();
+
+    std::ostringstream suffix;
+    suffix << ", " << size << "^3 column-major views";
+
+    Report assign("c = a*b + a" + suffix.str());
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        nestedApply(c.deep(), a * b + a, ndarray::detail::Assign());
+    }
+    assign("nested", start, nIterations);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        c.deep() = a * b + a;
+    }
+    assign("planned", start, nIterations);
+
+    Report reduce("sum(a*b)" + suffix.str());
+    float gathered = 0.0f;
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        gathered = gatherSum(a * b);
+    }
+    reduce("nested gather", start, nIterations);
+    float planned = 0.0f;
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        planned = ndarray::sum(a * b);
+    }
+    reduce("planned", start, nIterations);
+    std::cout << "    results: nested gather " << gathered << ", planned " << planned << "\n";
+}
+
+template <typename T>
+void benchmarkTransposeAssignment(int size, int nIterations) {
+    ndarray::Array<T,2,2> a = ndarray::allocate(size, size);
+    ndarray::Array<T,2,2> b = ndarray::allocate(size, size);
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) a[i][j] = T(i - j);
+    }
+    std::ostringstream name;
+    name << "b = a.transpose(), " << size << "x" << size << ", "
+         << sizeof(T) << "-byte elements";
+    Report report(name.str());
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        // the nested-iterator copy ArrayRef assignment used for mismatched layouts
+        ndarray::ArrayRef<T,2,-2> const source = a.transpose();
+        std::copy(source.begin(), source.end(), b.deep().begin());
+    }
+    report("iterator", start, nIterations);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        b.deep() = a.transpose();
+    }
+    report("tiled", start, nIterations);
+}
+
+// Reproduces the Fourier-space shift used before the per-axis factors were precomputed:
+// one std::polar per element at every nesting level, and std::complex multiplication.
+template <typename T, int N>
+struct LegacyShift {
+    template <int C>
+    static void apply(T const * offset, std::complex<T> const & factor,
+                      ndarray::ArrayRef<std::complex<T>,N,C> const & array, int realLastDim) {
+        typename ndarray::ArrayRef<std::complex<T>,N,C>::Iterator iter = array.begin();
+        T u = -2.0 * M_PI * (*offset) / array.size();
+        int kMid = (array.size() + 1) / 2;
+        for (int k = 0; k < kMid; ++k, ++iter) {
+            LegacyShift<T,N-1>::apply(offset+1, factor * std::polar(static_cast<T>(1), u * k), *iter, realLastDim);
+        }
+        if (array.size() % 2 == 0) {
+            LegacyShift<T,N-1>::apply(offset+1, factor * std::cos(u * kMid), *iter, realLastDim);
+            ++iter;
+            ++kMid;
+        }
+        for (int kn = kMid - array.size(); kn < 0; ++kn, ++iter) {
+            LegacyShift<T,N-1>::apply(offset+1, factor * std::polar(static_cast<T>(1), u * kn), *iter, realLastDim);
+        }
+    }
+};
+
+template <typename T>
+struct LegacyShift<T,1> {
+    template <int C>
+    static void apply(T const * offset, std::complex<T> const & factor,
+                      ndarray::ArrayRef<std::complex<T>,1,C> const & array, int realLastDim) {
+        typename ndarray::ArrayRef<std::complex<T>,1,C>::Iterator iter = array.begin();
+        T u = -2.0 * M_PI * (*offset) / realLastDim;
+        int kMid = (realLastDim + 1) / 2;
+        for (int k = 0; k < kMid; ++k, ++iter) {
+            (*iter) *= factor * std::polar(1.0, u * T(k));
+        }
+        if (realLastDim % 2 == 0) {
+            (*iter) *= factor * std::cos(u * kMid);
+        }
+    }
+};
+
+void benchmarkFourierShift(int size, int nIterations) {
+    ndarray::Array<std::complex<double>,2,2> k = ndarray::allocate(size, size / 2 + 1);
+    k.deep() = std::complex<double>(1.0, 0.5);
+    ndarray::Vector<double,2> offset = ndarray::makeVector(0.25, -1.5);
+    std::ostringstream name;
+    name << "shift(offset, k), " << size << "x" << size << " real-space double";
+    Report report(name.str());
+    std::clock_t start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        LegacyShift<double,2>::apply(offset.begin(), std::complex<double>(1.0), k.deep(), size);
+    }
+    report("per-element std::polar", start, nIterations);
+    start = std::clock();
+    for (int n = 0; n < nIterations; ++n) {
+        ndarray::shift(offset, k, size);
+    }
+    report("ndarray::shift", start, nIterations);
+}
+
+} // anonymous
+
+int main(int argc, char ** argv) {
+    benchmarkAssignment(ndarray::makeVector(512, 512, 3), 50);
+    benchmarkAssignment(ndarray::makeVector(64, 64, 16, 4), 50);
+    benchmarkAssignment(ndarray::makeVector(4096, 1024), 20);
+    benchmarkPacketEvaluation<float>(4096, 20000);
+    benchmarkPacketEvaluation<double>(4096, 20000);
+    benchmarkViewCreation(20000);
+    benchmarkSum(2048, 20);
+    benchmarkTransposeAssignment<float>(4096, 10);
+    benchmarkTransposeAssignment<double>(4096, 10);
+    benchmarkPlannedEvaluation(256, 10);
+    benchmarkFourierShift(2048, 10);
+    return 0;
+}
@@ -14,6 +14,7 @@
 #define BOOST_TEST_MODULE ndarray-fft
 #include "boost/test/unit_test.hpp"
 
+#include <cstdio>
 #include <sstream>
 
 #ifndef GCC_45
@@ -434,6 +435,338 @@ BOOST_AUTO_TEST_CASE(complex_2d) {
     FourierTransformTester<std::complex<double>,2>::testMultiplex(ndarray::makeVector(3,3,4),xData2,kData2);
 };
 
+BOOST_AUTO_TEST_CASE(planCache) {
+    typedef ndarray::FourierTransform<double,2> FFT;
+    ndarray::Vector<int,2> shape = ndarray::makeVector(24, 20);
+    FFT::ArrayX x1 = FFT::initializeX(shape);
+    FFT::ArrayX x2 = FFT::initializeX(shape);
+    for (int i = 0; i < shape[0]; ++i) {
+        for (int j = 0; j < shape[1]; ++j) {
+            x1[i][j] = std::cos(0.3 * i - 0.2 * j);
+            x2[i][j] = 0.5 * i - j;
+        }
+    }
+    FFT::ArrayX xIn1 = ndarray::copy(x1);
+    FFT::ArrayX xIn2 = ndarray::copy(x2);
+    FFT::ArrayK k1;
+    FFT::ArrayK k2;
+    // planning must not touch the arrays, and both transforms share the cached plan
+    FFT::Ptr forward1 = FFT::planForward(shape, x1, k1);
+    BOOST_CHECK(ndarray::all(ndarray::equal(x1, xIn1)));
+    FFT::Ptr forward2 = FFT::planForward(shape, x2, k2);
+    BOOST_CHECK(ndarray::all(ndarray::equal(x2, xIn2)));
+    typedef ndarray::detail::FFTWPlanCache<double> Cache;
+    Cache::PlanPtr plan1 = Cache::getForward(
+        2, shape.begin(), 1, x1.getData(), 0, k1.getData(), 0, ndarray::PlannerOptions()
+    );
+    Cache::PlanPtr plan2 = Cache::getForward(
+        2, shape.begin(), 1, x2.getData(), 0, k2.getData(), 0, ndarray::PlannerOptions()
+    );
+    BOOST_CHECK(plan1 == plan2);
+    // held by the cache, both transforms, plan1 and plan2
+    BOOST_CHECK_EQUAL(plan1.use_count(), 5);
+    plan1.reset();
+    plan2.reset();
+    forward1->execute();
+    forward2->execute();
+    FFT::ArrayX y1;
+    FFT::ArrayX y2;
+    FFT::Ptr inverse1 = FFT::planInverse(shape, k1, y1);
+    FFT::Ptr inverse2 = FFT::planInverse(shape, k2, y2);
+    ndarray::clearPlanCache<double>();
+    inverse1->execute();
+    inverse2->execute();
+    y1.deep() /= shape.product();
+    y2.deep() /= shape.product();
+    BOOST_CHECK(compareAbsolute(y1, xIn1));
+    BOOST_CHECK(compareAbsolute(y2, xIn2));
+
+    std::string const path = "ndarray-fft-test.wisdom";
+    ndarray::exportWisdom<double>(path);
+    ndarray::forgetWisdom<double>();
+    BOOST_CHECK(ndarray::importWisdom< std::complex<double> >(path));
+    std::remove(path.c_str());
+    BOOST_CHECK(!ndarray::importWisdom<double>(path));
+    BOOST_CHECK_THROW(ndarray::exportWisdom<double>("no-such-directory/fft.wisdom"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(newArrayExecute) {
+    typedef ndarray::FourierTransform<double,2> FFT;
+    ndarray::Vector<int,2> shape = ndarray::makeVector(16, 10);
+    FFT::ArrayX x;
+    FFT::ArrayK k;
+    FFT::Ptr forward = FFT::planForward(shape, x, k);
+    FFT::ArrayX y;
+    FFT::ArrayK kIn = FFT::initializeK(shape);
+    FFT::Ptr inverse = FFT::planInverse(shape, kIn, y);
+    // an array whose data is deliberately not aligned the way FFTW allocates it
+    ndarray::Array<double,1,1> buffer = FFT::initializeX(ndarray::makeVector(shape.product() + 1));
+    FFT::ArrayX misaligned = ndarray::external(buffer.getData() + 1, shape, ndarray::ROW_MAJOR, buffer);
+    for (int n = 0; n < 3; ++n) {
+        FFT::ArrayX image = FFT::initializeX(shape);
+        for (int i = 0; i < shape[0]; ++i) {
+            for (int j = 0; j < shape[1]; ++j) {
+                image[i][j] = std::sin(0.1 * (n + 1) * i * j) + n;
+            }
+        }
+        FFT::ArrayX expected = ndarray::copy(image);
+        x.deep() = image;
+        forward->execute();
+        FFT::ArrayK out = FFT::initializeK(shape);
+        forward->execute(image, out);
+        BOOST_CHECK(compareRelative(out, k));
+        FFT::ArrayX result = FFT::initializeX(shape);
+        inverse->execute(out, result);
+        result.deep() /= shape.product();
+        BOOST_CHECK(compareAbsolute(result, expected));
+        misaligned.deep() = expected;
+        forward->execute(misaligned, out);
+        inverse->execute(out, misaligned);
+        misaligned.deep() /= shape.product();
+        BOOST_CHECK(compareAbsolute(misaligned, expected));
+    }
+
+    typedef ndarray::FourierTransform<std::complex<double>,1> CFFT;
+    ndarray::Vector<int,2> mShape = ndarray::makeVector(3, 7);
+    CFFT::MultiplexArrayX cx;
+    CFFT::MultiplexArrayK ck;
+    CFFT::Ptr cForward = CFFT::planMultiplexForward(mShape, cx, ck);
+    CFFT::Ptr cInverse = CFFT::planMultiplexInverse(mShape, ck, cx);
+    CFFT::MultiplexArrayX cIn = CFFT::initializeX(mShape);
+    for (int i = 0; i < mShape[0]; ++i) {
+        for (int j = 0; j < mShape[1]; ++j) {
+            cIn[i][j] = std::complex<double>(i - j + 0.25, 0.5 * i * j + 1.25);
+        }
+    }
+    CFFT::MultiplexArrayX cExpected = ndarray::copy(cIn);
+    CFFT::MultiplexArrayK cOut = CFFT::initializeK(mShape);
+    cForward->execute(cIn, cOut);
+    CFFT::MultiplexArrayX cResult = CFFT::initializeX(mShape);
+    cInverse->execute(cOut, cResult);
+    cResult.deep() /= mShape[1];
+    BOOST_CHECK(compareRelative(cResult, cExpected));
+}
+
+BOOST_AUTO_TEST_CASE(threadedPlans) {
+    typedef ndarray::FourierTransform<double,2> FFT;
+    ndarray::Vector<int,3> shape = ndarray::makeVector(4, 128, 96);
+    FFT::MultiplexArrayX xIn = FFT::initializeX(shape);
+    for (int n = 0; n < shape[0]; ++n) {
+        for (int i = 0; i < shape[1]; ++i) {
+            for (int j = 0; j < shape[2]; ++j) {
+                xIn[n][i][j] = std::cos(0.05 * (n + 1) * i) * std::sin(0.07 * j) + 0.01 * i;
+            }
+        }
+    }
+    ndarray::PlannerOptions threaded;
+    threaded.threads = 4;
+    FFT::MultiplexArrayX x1 = ndarray::copy(xIn);
+    FFT::MultiplexArrayX x2 = ndarray::copy(xIn);
+    FFT::MultiplexArrayK k1;
+    FFT::MultiplexArrayK k2;
+    FFT::Ptr serial = FFT::planMultiplexForward(shape, x1, k1);
+    FFT::Ptr parallel = FFT::planMultiplexForward(shape, x2, k2, threaded);
+    serial->execute();
+    parallel->execute();
+    BOOST_CHECK(compareRelative(k2, k1, 1E-8));
+    FFT::MultiplexArrayX y;
+    FFT::Ptr inverse = FFT::planMultiplexInverse(shape, k2, y, threaded);
+    inverse->execute();
+    y.deep() /= shape[1] * shape[2];
+    BOOST_CHECK(compareAbsolute(y, xIn, 1E-10));
+}
+
+BOOST_AUTO_TEST_CASE(plannerOptions) {
+    typedef ndarray::FourierTransform<double,1> FFT;
+    ndarray::Vector<int,2> shape = ndarray::makeVector(5, 60);
+    FFT::MultiplexArrayX xIn = FFT::initializeX(shape);
+    for (int i = 0; i < shape[0]; ++i) {
+        for (int j = 0; j < shape[1]; ++j) {
+            xIn[i][j] = std::exp(-0.01 * (j - 30) * (j - 30)) * (i + 1);
+        }
+    }
+    ndarray::PlannerOptions options[3];
+    options[0].rigor = ndarray::PLAN_ESTIMATE;
+    options[1].rigor = ndarray::PLAN_PATIENT;
+    options[1].timeLimit = 0.5;
+    options[2].preserveInput = true;
+    for (int n = 0; n < 3; ++n) {
+        FFT::MultiplexArrayX x = ndarray::copy(xIn);
+        FFT::MultiplexArrayK k;
+        FFT::Ptr forward = FFT::planMultiplexForward(shape, x, k, options[n]);
+        BOOST_CHECK(ndarray::all(ndarray::equal(x, xIn)));
+        forward->execute();
+        FFT::MultiplexArrayK kIn = ndarray::copy(k);
+        FFT::Ptr inverse = FFT::planMultiplexInverse(shape, k, x, options[n]);
+        inverse->execute();
+        x.deep() /= shape[1];
+        BOOST_CHECK(compareAbsolute(x, xIn));
+        if (options[n].preserveInput) {
+            BOOST_CHECK(ndarray::all(ndarray::equal(k, kIn)));
+        }
+    }
+    // FFTW cannot preserve the input of multidimensional real inverse transforms
+    typedef ndarray::FourierTransform<double,2> FFT2;
+    FFT2::ArrayK k2;
+    FFT2::ArrayX x2;
+    BOOST_CHECK_THROW(FFT2::planInverse(ndarray::makeVector(8, 8), k2, x2, options[2]), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(stridedMultiplex) {
+    typedef ndarray::FourierTransform<double,2> FFT;
+    ndarray::Array<double,3,3> big = ndarray::allocate(6, 16, 12);
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            for (int k = 0; k < 12; ++k) {
+                big[i][j][k] = std::cos(0.2 * j * (i + 1) - 0.3 * k) + 0.1 * i;
+            }
+        }
+    }
+    // every other plane of a cropped stack, transformed without a copy
+    ndarray::Array<double,3> x = big[ndarray::view(0, 6, 2)(2, 14)(1, 11)];
+    ndarray::Array<double,3,3> xIn = ndarray::copy(x);
+    ndarray::Array<std::complex<double>,3,3> k = FFT::initializeK(x.getShape());
+    FFT::Ptr forward = FFT::planMultiplexForward(x, k);
+    BOOST_CHECK(ndarray::all(ndarray::equal(x, xIn)));
+    forward->execute();
+    FFT::ArrayX single;
+    FFT::ArrayK singleK;
+    FFT::Ptr singlePlan = FFT::planForward(ndarray::makeVector(12, 10), single, singleK);
+    for (int i = 0; i < 3; ++i) {
+        single.deep() = xIn[i];
+        singlePlan->execute();
+        BOOST_CHECK(compareRelative(k[i], singleK));
+    }
+    // the other planes have the same strides
+    ndarray::Array<double,3> x2 = big[ndarray::view(1, 6, 2)(2, 14)(1, 11)];
+    forward->execute(x2, k);
+    single.deep() = x2[2];
+    singlePlan->execute();
+    BOOST_CHECK(compareRelative(k[2], singleK));
+
+    // reversed planes and rows; measuring plans on scratch memory must allow for the
+    // negative strides
+    ndarray::Array<double,3> xr = ndarray::external(
+        &big[5][13][1], ndarray::makeVector(3, 12, 10), ndarray::makeVector(-2 * 16 * 12, -12, 1),
+        big.getManager()
+    );
+    ndarray::Array<double,3,3> xrIn = ndarray::copy(xr);
+    ndarray::Array<std::complex<double>,3,3> kr = FFT::initializeK(xr.getShape());
+    ndarray::Array<std::complex<double>,3> krReversed = ndarray::external(
+        &kr[2][0][0], kr.getShape(), ndarray::makeVector(-kr.getStride<0>(), kr.getStride<1>(), 1),
+        kr.getManager()
+    );
+    FFT::Ptr reversed = FFT::planMultiplexForward(xr, krReversed);
+    BOOST_CHECK(ndarray::all(ndarray::equal(xr, xrIn)));
+    reversed->execute();
+    for (int i = 0; i < 3; ++i) {
+        single.deep() = xrIn[i];
+        singlePlan->execute();
+        BOOST_CHECK(compareRelative(krReversed[i], singleK));
+    }
+
+    // transforms nested along the middle dimension
+    ndarray::Array<double,3,3> y = ndarray::copy(big);
+    ndarray::Array<std::complex<double>,3,3> yk = ndarray::allocate(6, 16, 7);
+    FFT::Ptr middle = FFT::planMultiplexForward(y, yk, 1);
+    middle->execute();
+    FFT::ArrayX single2;
+    FFT::ArrayK singleK2;
+    FFT::Ptr singlePlan2 = FFT::planForward(ndarray::makeVector(6, 12), single2, singleK2);
+    for (int j = 0; j < 16; j += 5) {
+        single2.deep() = big[ndarray::view()(j)()];
+        singlePlan2->execute();
+        BOOST_CHECK(compareRelative(yk[ndarray::view()(j)()], singleK2));
+    }
+    ndarray::Array<double,3,3> yOut = ndarray::allocate(6, 16, 12);
+    FFT::Ptr middleInverse = FFT::planMultiplexInverse(yk, yOut, 1);
+    middleInverse->execute();
+    yOut.deep() /= 6 * 12;
+    BOOST_CHECK(compareAbsolute(yOut, big));
+
+    // in-place transforms with a padded last dimension
+    ndarray::Vector<int,3> shape = ndarray::makeVector(4, 9, 10);
+    ndarray::Array<double,3,1> z;
+    ndarray::Array<std::complex<double>,3,3> zk;
+    FFT::initializeInPlace(shape, z, zk);
+    BOOST_CHECK_EQUAL(z.getStride<1>(), 12);
+    BOOST_CHECK(reinterpret_cast<void*>(z.getData()) == reinterpret_cast<void*>(zk.getData()));
+    ndarray::Array<double,3,3> zIn = ndarray::copy(big[ndarray::view(0, 4)(0, 9)(0, 10)]);
+    z.deep() = zIn;
+    FFT::MultiplexArrayX zx = ndarray::copy(zIn);
+    FFT::MultiplexArrayK zkRef;
+    FFT::planMultiplexForward(shape, zx, zkRef)->execute();
+    FFT::planMultiplexForward(z, zk)->execute();
+    BOOST_CHECK(compareRelative(zk, zkRef));
+    FFT::planMultiplexInverse(zk, z)->execute();
+    z.deep() /= 9 * 10;
+    BOOST_CHECK(compareAbsolute(z, zIn));
+}
+
+BOOST_AUTO_TEST_CASE(realToReal) {
+    typedef ndarray::RealToRealTransform<double,1> R2R;
+    double const pi = 3.14159265358979323846;
+    int const n = 12;
+    R2R::ArrayT x;
+    R2R::ArrayT y;
+    R2R::Ptr dct = R2R::plan(ndarray::makeVector(n), ndarray::makeVector<int>(ndarray::DCT_II), x, y);
+    R2R::ArrayT xIn = ndarray::allocate(n);
+    R2R::ArrayT yIn = ndarray::allocate(n);
+    for (int j = 0; j < n; ++j) xIn[j] = std::exp(-0.1 * (j - 3) * (j - 3)) + 0.2 * j;
+    for (int k = 0; k < n; ++k) {
+        yIn[k] = 0.0;
+        for (int j = 0; j < n; ++j) yIn[k] += 2.0 * xIn[j] * std::cos(pi * (j + 0.5) * k / n);
+    }
+    x.deep() = xIn;
+    dct->execute();
+    BOOST_CHECK(compareAbsolute(y, yIn, 1E-10));
+    BOOST_CHECK_EQUAL(R2R::getInverseKind(ndarray::DCT_II), ndarray::DCT_III);
+    // an in-place inverse plan, executed on a new array with the same layout
+    R2R::Kinds const inverseKind = ndarray::makeVector<int>(R2R::getInverseKind(ndarray::DCT_II));
+    R2R::ArrayT z;
+    R2R::Ptr idct = R2R::plan(ndarray::makeVector(n), inverseKind, y, y);
+    z = ndarray::copy(y);
+    idct->execute(z, z);
+    z.deep() /= R2R::computeNormalization(ndarray::makeVector(n), inverseKind);
+    BOOST_CHECK(compareAbsolute(z, xIn, 1E-10));
+
+    // multiplexed 2-d transforms with a different kind along each dimension
+    typedef ndarray::RealToRealTransform<double,2> R2R2;
+    ndarray::Vector<int,3> shape = ndarray::makeVector(3, 7, 10);
+    R2R2::Kinds kinds = ndarray::makeVector<int>(ndarray::DST_I, ndarray::DCT_IV);
+    R2R2::Kinds inverseKinds;
+    for (int n = 0; n < 2; ++n) {
+        inverseKinds[n] = R2R2::getInverseKind(ndarray::RealToRealKindEnum(kinds[n]));
+    }
+    R2R2::MultiplexArrayT a;
+    R2R2::MultiplexArrayT b;
+    R2R2::Ptr forward = R2R2::planMultiplex(shape, kinds, a, b);
+    R2R2::Ptr inverse = R2R2::planMultiplex(shape, inverseKinds, b, a);
+    R2R2::MultiplexArrayT aIn = ndarray::allocate(shape);
+    for (int i = 0; i < shape[0]; ++i) {
+        for (int j = 0; j < shape[1]; ++j) {
+            for (int k = 0; k < shape[2]; ++k) {
+                aIn[i][j][k] = std::sin(0.3 * j + 0.1 * k * (i + 1)) + i;
+            }
+        }
+    }
+    a.deep() = aIn;
+    forward->execute();
+    // each nested array matches a single-array transform
+    R2R2::ArrayT single;
+    R2R2::ArrayT singleOut;
+    R2R2::Ptr singlePlan = R2R2::plan(shape.last<2>(), kinds, single, singleOut);
+    for (int i = 0; i < shape[0]; ++i) {
+        single.deep() = aIn[i];
+        singlePlan->execute();
+        BOOST_CHECK(compareAbsolute(b[i], singleOut, 1E-10));
+    }
+    a.deep() = 0.0;
+    inverse->execute();
+    a.deep() /= R2R2::computeNormalization(shape.last<2>(), kinds);
+    BOOST_CHECK(compareAbsolute(a, aIn, 1E-10));
+}
+
 template <typename T, int N>
 struct FourierOpsTester {
     typedef ndarray::FourierTransform<T,N> FFT;
@@ -494,6 +827,67 @@ struct FourierOpsTester {
         BOOST_CHECK(compareAbsolute(x1,x2));
     }
 
+    static void testConvolve(
+        typename FFT::Index const & shape,
+        typename FFT::Index const & offset,
+        T sigma
+    ) {
+        typename FFT::ArrayX x1;
+        typename FFT::ArrayX x2;
+        typename FFT::ArrayK k1;
+        typename FFT::ArrayK k2;
+        typename FFT::Ptr forward1 = FFT::planForward(shape,x1,k1);
+        typename FFT::Ptr forward2 = FFT::planForward(shape,x2,k2);
+        typename FFT::Ptr inverse = FFT::planInverse(shape,k1,x1);
+        x1.deep() = 1.0;
+        ndarray::Vector<T,N> mu = shape * 0.5;
+        makeGaussian(mu.begin(), sigma, x1);
+        typename FFT::ArrayX expected = ndarray::copy(x1);
+        // convolving with a delta function translates by a whole number of pixels
+        x2.deep() = 0.0;
+        x2[offset] = 1.0;
+        forward1->execute();
+        forward2->execute();
+        ndarray::convolve(k1, k2);
+        inverse->execute();
+        x1.deep() /= shape.product();
+        mu += offset;
+        expected.deep() = 1.0;
+        makeGaussian(mu.begin(), sigma, expected);
+        BOOST_CHECK(compareAbsolute(x1, expected));
+    }
+
+    static void testResample(
+        typename FFT::Index const & shape,
+        typename FFT::Index const & newShape,
+        T sigma
+    ) {
+        typename FFT::ArrayX x1;
+        typename FFT::ArrayX x2;
+        typename FFT::ArrayK k1;
+        typename FFT::ArrayK k2;
+        typename FFT::Ptr forward = FFT::planForward(shape,x1,k1);
+        typename FFT::Ptr inverse = FFT::planInverse(newShape,k2,x2);
+        x1.deep() = 1.0;
+        ndarray::Vector<T,N> mu = shape * 0.5;
+        makeGaussian(mu.begin(), sigma, x1);
+        forward->execute();
+        ndarray::resample(k1, shape[N-1], k2, newShape[N-1]);
+        inverse->execute();
+        x2.deep() /= newShape.product();
+        // the same Gaussian, sampled on the new grid (in units of its pixels)
+        typename FFT::ArrayX expected = FFT::initializeX(newShape);
+        expected.deep() = 1.0;
+        // makeGaussian uses one sigma for all dimensions, so all of them must scale alike
+        T scale = T(newShape[0]) / T(shape[0]);
+        for (int n = 0; n < N; ++n) {
+            BOOST_REQUIRE(std::abs(T(newShape[n]) / T(shape[n]) - scale) < 1E-12);
+        }
+        ndarray::Vector<T,N> newMu = mu * scale;
+        makeGaussian(newMu.begin(), sigma * scale, expected);
+        BOOST_CHECK(compareAbsolute(x2, expected));
+    }
+
 };
 
 template <typename T>
@@ -517,6 +911,15 @@ BOOST_AUTO_TEST_CASE(ops) {
     FourierOpsTester<double,2>::testDifferentiate(ndarray::makeVector(256,256),10.0,1);
     FourierOpsTester<double,2>::testDifferentiate(ndarray::makeVector(256,255),10.0,0);
     FourierOpsTester<double,2>::testDifferentiate(ndarray::makeVector(256,255),10.0,1);
+
+    FourierOpsTester<double,1>::testConvolve(ndarray::makeVector(128),ndarray::makeVector(5),8.0);
+    FourierOpsTester<double,2>::testConvolve(ndarray::makeVector(64,63),ndarray::makeVector(3,4),6.0);
+
+    FourierOpsTester<double,1>::testResample(ndarray::makeVector(64),ndarray::makeVector(96),5.0);
+    FourierOpsTester<double,1>::testResample(ndarray::makeVector(64),ndarray::makeVector(48),5.0);
+    FourierOpsTester<double,2>::testResample(ndarray::makeVector(64,60),ndarray::makeVector(96,90),5.0);
+    FourierOpsTester<double,2>::testResample(ndarray::makeVector(64,60),ndarray::makeVector(48,45),5.0);
+    FourierOpsTester<double,2>::testResample(ndarray::makeVector(63,63),ndarray::makeVector(84,84),5.0);
 }
 
 #else
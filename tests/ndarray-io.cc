@@ -0,0 +1,169 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#include <ndarray/io.h>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ndarray-io
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+#ifndef GCC_45
+
+namespace {
+
+template <typename T, int N>
+void fillRamp(ndarray::Array<T,N,N> const & array) {
+    T * p = array.getData();
+    for (int i = 0; i < array.getNumElements(); ++i) p[i] = T(i % 251) / T(4);
+}
+
+template <typename T1, typename T2, int N, int C1, int C2>
+bool isEqual(ndarray::Array<T1,N,C1> const & a, ndarray::Array<T2,N,C2> const & b) {
+    return a.getShape() == b.getShape() && ndarray::all(ndarray::equal(a, b));
+}
+
+} // anonymous
+
+BOOST_AUTO_TEST_CASE(dtypes) {
+    ndarray::DType f8 = ndarray::DTypeTraits<double const>::get(false);
+    BOOST_CHECK_EQUAL(f8.kind, 'f');
+    BOOST_CHECK_EQUAL(f8.size, 8);
+    ndarray::DType c8 = ndarray::DTypeTraits< std::complex<float> >::get(true);
+    BOOST_CHECK_EQUAL(c8.kind, 'c');
+    BOOST_CHECK_EQUAL(c8.getSwapSize(), 4);
+    BOOST_CHECK_EQUAL(ndarray::DTypeTraits<unsigned short>::get(false).kind, 'u');
+    BOOST_CHECK_EQUAL(ndarray::DTypeTraits<long>::get(false).kind, 'i');
+    BOOST_CHECK_EQUAL(ndarray::DTypeTraits<bool>::get(false).kind, 'b');
+}
+
+BOOST_AUTO_TEST_CASE(nativeStream) {
+    ndarray::Array<double,3,3> a = ndarray::allocate(4, 5, 6);
+    fillRamp(a);
+    std::stringstream stream;
+    ndarray::saveArray(stream, a);
+    BOOST_CHECK_EQUAL(stream.str().size(), std::size_t(128 + 4 * 5 * 6 * 8));
+    ndarray::Array<double,3,3> b = ndarray::loadArray(stream);
+    BOOST_CHECK(isEqual(a, b));
+
+    // expressions and strided views are streamed element by element
+    std::stringstream stream2;
+    ndarray::saveArray(stream2, a[ndarray::view()(1, 5, 2)()] * 2.0);
+    ndarray::Array<double const,3,3> c = ndarray::loadArray(stream2);
+    ndarray::Array<double,3,3> expected = ndarray::copy(a[ndarray::view()(1, 5, 2)()] * 2.0);
+    BOOST_CHECK_EQUAL(c.getShape(), ndarray::makeVector(4, 2, 6));
+    BOOST_CHECK(ndarray::all(ndarray::equal(c, expected)));
+
+    // reading into a column-major array requires a copy
+    std::stringstream stream3(stream.str());
+    ndarray::Array<double,3,-3> d = ndarray::loadArray(stream3);
+    BOOST_CHECK(ndarray::all(ndarray::equal(d, a)));
+
+    std::stringstream stream4(stream.str());
+    ndarray::Array<float,3,3> wrongType;
+    BOOST_CHECK_THROW(wrongType = ndarray::loadArray(stream4), std::runtime_error);
+    std::stringstream stream5(stream.str());
+    ndarray::Array<double,2,2> wrongRank;
+    BOOST_CHECK_THROW(wrongRank = ndarray::loadArray(stream5), std::runtime_error);
+    std::stringstream stream6(stream.str().substr(0, 200));
+    ndarray::Array<double,3,3> truncated;
+    BOOST_CHECK_THROW(truncated = ndarray::loadArray(stream6), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(byteOrder) {
+    // a hand-written big-endian file with two 16-bit elements
+    std::string data("\x89NDARRAY\x01i\x02>", 12);
+    data += std::string("\x01\0\0\0", 4) + std::string("\x40\0\0\0\0\0\0\0", 8);
+    data += std::string("\x02\0\0\0\0\0\0\0", 8) + std::string("\x01\0\0\0\0\0\0\0", 8);
+    data += std::string(64 - data.size(), '\0');
+    data += std::string("\x01\x02\xff\xfe", 4);
+    std::stringstream stream(data);
+    ndarray::Array<short,1,1> a = ndarray::loadArray(stream);
+    BOOST_CHECK_EQUAL(a.getSize<0>(), 2);
+    BOOST_CHECK_EQUAL(a[0], 0x0102);
+    BOOST_CHECK_EQUAL(a[1], -2);
+}
+
+BOOST_AUTO_TEST_CASE(npyStream) {
+    ndarray::Array<float,2,2> a = ndarray::allocate(3, 7);
+    fillRamp(a);
+    std::stringstream stream;
+    ndarray::saveNpy(stream, a);
+    std::string const contents = stream.str();
+    BOOST_CHECK_EQUAL(contents.substr(0, 8), std::string("\x93NUMPY\x01\x00", 8));
+    BOOST_CHECK(contents.find("{'descr': '<f4', 'fortran_order': False, 'shape': (3, 7), }") != std::string::npos);
+    BOOST_CHECK_EQUAL((contents.size() - 3 * 7 * 4) % 64, 0u);
+    BOOST_CHECK_EQUAL(contents[contents.size() - 3 * 7 * 4 - 1], '\n');
+    ndarray::Array<float,2,2> b = ndarray::loadNpy(stream);
+    BOOST_CHECK(isEqual(a, b));
+
+    std::stringstream stream1;
+    ndarray::Array<std::complex<double>,1,1> c = ndarray::allocate(5);
+    for (int i = 0; i < 5; ++i) c[i] = std::complex<double>(i, -i);
+    ndarray::saveNpy(stream1, c);
+    BOOST_CHECK(stream1.str().find("'descr': '<c16'") != std::string::npos);
+    BOOST_CHECK(stream1.str().find("'shape': (5,)") != std::string::npos);
+    ndarray::Array<std::complex<double>,1,1> d = ndarray::loadNpy(stream1);
+    BOOST_CHECK(isEqual(c, d));
+}
+
+BOOST_AUTO_TEST_CASE(npyFortranOrder) {
+    // a file as written by numpy.save(f, numpy.asfortranarray(numpy.arange(6, dtype='<i4').reshape(2, 3)))
+    std::string dict = "{'descr': '<i4', 'fortran_order': True, 'shape': (2, 3), }";
+    dict.append(128 - 10 - dict.size() - 1, ' ');
+    dict.push_back('\n');
+    std::string data = std::string("\x93NUMPY\x01\x00", 8) + char(dict.size()) + char(0) + dict;
+    int const values[6] = { 0, 3, 1, 4, 2, 5 };
+    data.append(reinterpret_cast<char const *>(values), sizeof(values));
+    std::stringstream stream(data);
+    ndarray::Array<int,2,-2> a = ndarray::loadNpy(stream);
+    std::stringstream stream2(data);
+    ndarray::Array<int,2,2> b = ndarray::loadNpy(stream2);
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            BOOST_CHECK_EQUAL(a[i][j], 3 * i + j);
+            BOOST_CHECK_EQUAL(b[i][j], 3 * i + j);
+        }
+    }
+}
+
+#ifdef NDARRAY_HAVE_MMAP
+BOOST_AUTO_TEST_CASE(files) {
+    std::string const nativePath = "ndarray-io-test.nda";
+    std::string const npyPath = "ndarray-io-test.npy";
+    ndarray::Array<double,2,2> a = ndarray::allocate(31, 17);
+    fillRamp(a);
+    ndarray::saveArray(nativePath, a);
+    ndarray::saveNpy(npyPath, a);
+
+    ndarray::Array<double,2,2> b = ndarray::loadArray(nativePath);
+    BOOST_CHECK(isEqual(a, b));
+    ndarray::Array<double const,2,2> c = ndarray::mapArray(nativePath);
+    BOOST_CHECK(isEqual(a, c));
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(c.getData()) % 64, 0u);
+    ndarray::Array<double,2,2> d = ndarray::loadNpy(npyPath);
+    BOOST_CHECK(isEqual(a, d));
+    ndarray::Array<double,2,2> e = ndarray::mapNpy(npyPath, ndarray::MAPPED_COPY_ON_WRITE);
+    BOOST_CHECK(isEqual(a, e));
+    e.deep() = 0.0;
+    ndarray::Array<double,2,-2> f;
+    BOOST_CHECK_THROW(f = ndarray::mapNpy(npyPath), std::runtime_error);
+    ndarray::Array<double,2,2> g = ndarray::loadNpy(npyPath);
+    BOOST_CHECK(isEqual(a, g));
+
+    std::remove(nativePath.c_str());
+    std::remove(npyPath.c_str());
+    BOOST_CHECK_THROW(b = ndarray::loadArray(nativePath), std::runtime_error);
+}
+#endif
+
+#endif
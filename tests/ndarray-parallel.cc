@@ -0,0 +1,170 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#include <ndarray/parallel.h>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ndarray-parallel
+#include "boost/test/unit_test.hpp"
+
+#ifndef GCC_45
+
+namespace {
+
+// A policy that always uses four threads, regardless of size.
+ndarray::ParallelPolicy const threaded(4, 0);
+
+template <typename T, int N>
+void fillRamp(ndarray::Array<T,N,N> const & array, double scale) {
+    T * p = array.getData();
+    for (int i = 0; i < array.getNumElements(); ++i) {
+        p[i] = T((i % 97) * scale + 1.0);
+    }
+}
+
+template <typename T, int N, int C1, int C2>
+bool isEqual(ndarray::ArrayRef<T,N,C1> const & a, ndarray::ArrayRef<T,N,C2> const & b) {
+    return ndarray::all(ndarray::equal(a, b));
+}
+
+} // anonymous
+
+BOOST_AUTO_TEST_CASE(policy) {
+    ndarray::ParallelPolicy p1(3, 100);
+    BOOST_CHECK_EQUAL(p1.getThreads(), 3);
+    BOOST_CHECK_EQUAL(p1.getThreshold(), 100);
+    ndarray::ParallelPolicy p2;
+    BOOST_CHECK(p2.getThreads() >= 1);
+    ndarray::ParallelPolicy original = ndarray::ParallelPolicy::getDefault();
+    ndarray::ParallelPolicy::setDefault(p1);
+    BOOST_CHECK_EQUAL(ndarray::ParallelPolicy::getDefault().getThreads(), 3);
+    ndarray::ParallelPolicy::setDefault(original);
+}
+
+BOOST_AUTO_TEST_CASE(flatExpression) {
+    ndarray::Vector<int,3> shape = ndarray::makeVector(37, 21, 5);
+    ndarray::Array<double,3,3> a = ndarray::allocate(shape);
+    ndarray::Array<double,3,3> b = ndarray::allocate(shape);
+    ndarray::Array<double,3,3> serial = ndarray::allocate(shape);
+    ndarray::Array<double,3,3> result = ndarray::allocate(shape);
+    fillRamp(a, 0.5);
+    fillRamp(b, -0.25);
+    serial.deep() = a * b + a;
+    ndarray::parallel(result, threaded) = a * b + a;
+    BOOST_CHECK(isEqual(result.deep(), serial.deep()));
+    serial.deep() -= b;
+    ndarray::parallel(result, threaded) -= b;
+    BOOST_CHECK(isEqual(result.deep(), serial.deep()));
+    serial.deep() *= 2.0;
+    ndarray::parallel(result, threaded) *= 2.0;
+    BOOST_CHECK(isEqual(result.deep(), serial.deep()));
+}
+
+BOOST_AUTO_TEST_CASE(stridedExpression) {
+    ndarray::Vector<int,3> shape = ndarray::makeVector(23, 12, 7);
+    ndarray::Array<float,3,3> a = ndarray::allocate(shape);
+    ndarray::Array<float,3,3> b = ndarray::allocate(ndarray::makeVector(23, 24, 7));
+    fillRamp(a, 0.75);
+    fillRamp(b, 1.5);
+    ndarray::ArrayRef<float,3> bs = b[ndarray::view()(0, 24, 2)()];
+    ndarray::Array<float,3,3> serial = ndarray::allocate(shape);
+    ndarray::Array<float,3,3> result = ndarray::allocate(shape);
+    serial.deep() = a - bs;
+    ndarray::parallel(result, threaded) = a - bs;
+    BOOST_CHECK(isEqual(result.deep(), serial.deep()));
+
+    // strided destination
+    ndarray::Array<float,3,3> big = ndarray::allocate(ndarray::makeVector(23, 24, 7));
+    big.deep() = 0.0f;
+    ndarray::ArrayRef<float,3> dest = big[ndarray::view()(1, 24, 2)()];
+    ndarray::parallel(dest, threaded) = a;
+    ndarray::parallel(dest, threaded) += bs;
+    serial.deep() = a + bs;
+    BOOST_CHECK(isEqual(dest, serial.deep()));
+    BOOST_CHECK(ndarray::all(ndarray::equal(big[ndarray::view()(0, 24, 2)()], 0.0f)));
+}
+
+BOOST_AUTO_TEST_CASE(lowerDimensionalExpression) {
+    ndarray::Array<int,2,2> result = ndarray::allocate(50, 8);
+    ndarray::Array<int,1,1> column = ndarray::allocate(50);
+    for (int i = 0; i < 50; ++i) column[i] = i;
+    ndarray::parallel(result, threaded) = column;
+    for (int i = 0; i < 50; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            BOOST_CHECK_EQUAL(result[i][j], i);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(scalars) {
+    ndarray::Array<double,2,2> result = ndarray::allocate(101, 33);
+    ndarray::parallel(result, threaded) = 3.0;
+    BOOST_CHECK(ndarray::all(ndarray::equal(result, 3.0)));
+    ndarray::parallel(result, threaded) += 1;
+    BOOST_CHECK(ndarray::all(ndarray::equal(result, 4.0)));
+    ndarray::ArrayRef<double,2> transposed = result.transpose();
+    ndarray::parallel(transposed[ndarray::view(0, 33, 2)()], threaded) = -1.0;
+    for (int i = 0; i < 101; ++i) {
+        for (int j = 0; j < 33; ++j) {
+            BOOST_CHECK_EQUAL(result[i][j], (j % 2) ? 4.0 : -1.0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(belowThreshold) {
+    ndarray::Array<double,1,1> a = ndarray::allocate(10);
+    ndarray::Array<double,1,1> serial = ndarray::allocate(10);
+    ndarray::Array<double,1,1> result = ndarray::allocate(10);
+    fillRamp(a, 1.0);
+    serial.deep() = -a;
+    ndarray::parallel(result, ndarray::ParallelPolicy(4, 1000)) = -a;
+    BOOST_CHECK(isEqual(result.deep(), serial.deep()));
+}
+
+BOOST_AUTO_TEST_CASE(reductions) {
+    ndarray::Array<double,2,2> a = ndarray::allocate(301, 67);
+    ndarray::Array<double,2,2> b = ndarray::allocate(301, 67);
+    fillRamp(a, 0.5);
+    fillRamp(b, -0.25);
+    BOOST_CHECK_CLOSE(ndarray::sum(a * b, threaded), ndarray::sum(a * b), 1E-12);
+    BOOST_CHECK_CLOSE(ndarray::mean(a, threaded), ndarray::mean(a), 1E-12);
+    BOOST_CHECK_CLOSE(ndarray::variance(a, threaded, 1), ndarray::variance(a, 1), 1E-10);
+    // strided views are divided by rows, with each thread using its own Cores
+    ndarray::ArrayRef<double,2> strided = a[ndarray::view()(0, 67, 3)];
+    BOOST_CHECK_CLOSE(ndarray::sum(strided - 1.0, threaded), ndarray::sum(strided - 1.0), 1E-12);
+    ndarray::Array<int,1,1> c = ndarray::allocate(1000);
+    for (int i = 0; i < 1000; ++i) c[i] = i;
+    BOOST_CHECK_EQUAL(ndarray::sum(c[ndarray::view(0, 1000, 2)], threaded), 249500);
+    BOOST_CHECK_EQUAL(ndarray::sum(c, ndarray::ParallelPolicy(4, 5000)), 499500);
+}
+
+namespace {
+
+// Assigns to one row of an array in parallel; used to check that nested parallel calls
+// are evaluated serially instead of deadlocking.
+struct NestedTask {
+    void operator()(int i) const {
+        ndarray::parallel(array[i], threaded) = double(i);
+    }
+    ndarray::Array<double,2,2> array;
+};
+
+} // anonymous
+
+BOOST_AUTO_TEST_CASE(nested) {
+    NestedTask task;
+    task.array = ndarray::allocate(8, 1000);
+    ndarray::detail::ThreadPool::run(4, 8, boost::cref(task));
+    for (int i = 0; i < 8; ++i) {
+        BOOST_CHECK(ndarray::all(ndarray::equal(task.array[i], double(i))));
+    }
+}
+
+#endif
@@ -14,6 +14,8 @@
 #define BOOST_TEST_MODULE ndarray
 #include "boost/test/unit_test.hpp"
 
+#include <cstdio>
+
 BOOST_AUTO_TEST_CASE(sizes) {
     std::cerr << "sizeof(int): " << sizeof(int) << "\n";
     std::cerr << "sizeof(double*): " << sizeof(double*) << "\n";
@@ -56,6 +58,36 @@ BOOST_AUTO_TEST_CASE(cores) {
     BOOST_CHECK_EQUAL(core->getRC(),2);
     copy.reset();
     BOOST_CHECK_EQUAL(core->getRC(),1);
+    copy = core->copy();
+    BOOST_CHECK_EQUAL(copy->getRC(),1);
+    BOOST_CHECK_EQUAL(core->getRC(),1);
+    BOOST_CHECK_EQUAL(copy->getStride(),6);
+}
+
+BOOST_AUTO_TEST_CASE(corePool) {
+    typedef ndarray::detail::Core<3> Core;
+    typedef ndarray::detail::CorePool Pool;
+    Core::Ptr core = Core::create(ndarray::makeVector(4,3,2), ndarray::ROW_MAJOR);
+#ifndef NDARRAY_NO_CORE_POOL
+    int cached = Pool::getCachedCount();
+    Core const * address = core.get();
+    core.reset();
+    BOOST_CHECK_EQUAL(Pool::getCachedCount(), cached + 1);
+    core = Core::create(ndarray::makeVector(5,3,2), ndarray::ROW_MAJOR);
+    BOOST_CHECK_EQUAL(core.get(), address);
+    BOOST_CHECK_EQUAL(Pool::getCachedCount(), cached);
+#else
+    core.reset();
+    BOOST_CHECK_EQUAL(Pool::getCachedCount(), 0);
+#endif
+    ndarray::Array<double,2,2> a = ndarray::allocate(6, 5);
+    for (int i = 0; i < 1000; ++i) {
+        ndarray::Array<double,2> b = a[ndarray::view(1, 4)(0, 5, 2)];
+        BOOST_CHECK_EQUAL(b.getSize<0>(), 3);
+    }
+    BOOST_CHECK(Pool::getCachedCount() <= 64 * 16);
+    Pool::releaseCached();
+    BOOST_CHECK_EQUAL(Pool::getCachedCount(), 0);
 }
 
 BOOST_AUTO_TEST_CASE(allocation) {
@@ -85,6 +117,77 @@ BOOST_AUTO_TEST_CASE(allocation) {
     
 }
 
+BOOST_AUTO_TEST_CASE(alignedAllocation) {
+    ndarray::Vector<int,3> shape = ndarray::makeVector(5,6,7);
+    ndarray::Array<float,3,3> a = ndarray::allocate(shape, ndarray::AllocationPolicy());
+    BOOST_CHECK_EQUAL(a.getShape(), shape);
+    BOOST_CHECK_EQUAL(a.getStrides(), ndarray::makeVector(42,7,1));
+    BOOST_CHECK_EQUAL(a.getManager()->getAlignment(), 64);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(a.getData()) % 64, 0u);
+
+    ndarray::Array<double,2,1> b(ndarray::makeVector(5,3), ndarray::AllocationPolicy(128, true));
+    BOOST_CHECK_EQUAL(b.getShape(), ndarray::makeVector(5,3));
+    BOOST_CHECK_EQUAL(b.getStrides(), ndarray::makeVector(16,1));
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(b.getData()) % 128, 0u);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(b[3].getData()) % 128, 0u);
+    b.deep() = 2.0;
+    BOOST_CHECK(ndarray::all(ndarray::equal(b, 2.0)));
+
+    // Row padding would break the contiguity guaranteed by RMC=2, so it is not applied.
+    ndarray::Array<double,2,2> c = ndarray::allocate(5, 3, ndarray::AllocationPolicy(64, true));
+    BOOST_CHECK_EQUAL(c.getStrides(), ndarray::makeVector(3,1));
+
+    ndarray::Array<float,2,-1> d = ndarray::allocate(5, 3, ndarray::AllocationPolicy(64, true));
+    BOOST_CHECK_EQUAL(d.getStrides(), ndarray::makeVector(1,16));
+
+    ndarray::Array<std::complex<double>,1,1> e =
+        ndarray::allocate(300000, ndarray::AllocationPolicy(64, false, true));
+    BOOST_CHECK_EQUAL(e[299999], std::complex<double>(0.0, 0.0));
+    BOOST_CHECK(e.getManager()->getAlignment() >= 64);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(e.getData()) % e.getManager()->getAlignment(), 0u);
+
+    ndarray::Array<float,3,3> f = ndarray::allocate(shape);
+    BOOST_CHECK(f.getManager()->getAlignment() >= 4);
+}
+
+#ifdef NDARRAY_HAVE_MMAP
+BOOST_AUTO_TEST_CASE(mappedFile) {
+    std::string const path = "ndarray-mapped-test.dat";
+    std::size_t const header = 12;
+    ndarray::Vector<int,2> shape = ndarray::makeVector(40, 30);
+    {
+        ndarray::Array<float,2,2> a = ndarray::mapFile<float>(path, shape, ndarray::MAPPED_READ_WRITE, header);
+        BOOST_CHECK_EQUAL(a.getShape(), shape);
+        for (int i = 0; i < 40; ++i) {
+            for (int j = 0; j < 30; ++j) {
+                a[i][j] = i * 30 + j;
+            }
+        }
+        BOOST_CHECK_EQUAL(a.getManager()->getAlignment(), 4);
+        boost::static_pointer_cast<ndarray::MappedManager>(a.getManager())->sync();
+    }
+    {
+        ndarray::Array<float const,2,2> b = ndarray::mapFile<float const>(path, shape, ndarray::MAPPED_READ_ONLY, header);
+        BOOST_CHECK_EQUAL(b[39][29], 1199.0f);
+        BOOST_CHECK_EQUAL(b[2][3], 63.0f);
+        ndarray::Array<float,2,2> c = ndarray::mapFile<float>(path, shape, ndarray::MAPPED_COPY_ON_WRITE, header);
+        c.deep() = 0.0f;
+        BOOST_CHECK_EQUAL(b[2][3], 63.0f);
+        BOOST_CHECK_EQUAL(c[2][3], 0.0f);
+    }
+    {
+        ndarray::Array<float const,1,1> d = ndarray::mapFile<float const>(path, ndarray::makeVector(1200), ndarray::MAPPED_READ_ONLY, header);
+        BOOST_CHECK_EQUAL(d[63], 63.0f);
+        BOOST_CHECK_THROW(
+            ndarray::mapFile<float const>(path, ndarray::makeVector(1201), ndarray::MAPPED_READ_ONLY, header),
+            std::runtime_error
+        );
+    }
+    std::remove(path.c_str());
+    BOOST_CHECK_THROW(ndarray::mapFile<float const>(path, shape), std::runtime_error);
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(external) {
     double data[3*4*2] = {0};
     ndarray::Vector<int,3> shape = ndarray::makeVector(3,4,2);
@@ -343,6 +446,126 @@ BOOST_AUTO_TEST_CASE(binary_ops) {
     BOOST_CHECK(ndarray::allclose(b, a + q));
 }
 
+BOOST_AUTO_TEST_CASE(reductions) {
+    ndarray::Array<double,3,3> a = ndarray::allocate(5, 6, 7);
+    ndarray::Array<double,3,3> b = ndarray::allocate(5, 6, 7);
+    ndarray::Array<int,3,3> c = ndarray::allocate(5, 6, 7);
+    for (int i = 0; i < a.getNumElements(); ++i) {
+        a.getData()[i] = std::sin(0.1 * i) * 3.0;
+        b.getData()[i] = 0.5 + i % 11;
+        c.getData()[i] = i % 13 - 4;
+    }
+    double expected = 0.0, expectedProduct = 0.0, expectedStrided = 0.0;
+    int expectedInt = 0;
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            for (int k = 0; k < 7; ++k) {
+                expected += a[i][j][k];
+                expectedProduct += a[i][j][k] * b[i][j][k];
+                if (j % 2 == 1) expectedStrided += a[i][j][k];
+                expectedInt += c[i][j][k];
+            }
+        }
+    }
+    ndarray::Array<double,3,-3> aT = ndarray::allocate(5, 6, 7);
+    aT.deep() = a;
+    BOOST_CHECK_CLOSE(ndarray::sum(a), expected, 1E-10);
+    BOOST_CHECK_CLOSE(ndarray::sum(aT), expected, 1E-10);
+    BOOST_CHECK_CLOSE(ndarray::sum(a * b), expectedProduct, 1E-10);
+    BOOST_CHECK_CLOSE(ndarray::sum(a[ndarray::view()(1, 6, 2)()]), expectedStrided, 1E-10);
+    BOOST_CHECK_EQUAL(ndarray::sum(c), expectedInt);
+    BOOST_CHECK_CLOSE(ndarray::mean(c), double(expectedInt) / 210, 1E-10);
+    BOOST_CHECK_CLOSE(ndarray::mean(a - b), (expected - ndarray::sum(b)) / 210, 1E-10);
+
+    double expectedVariance = 0.0;
+    double const m = expected / 210;
+    for (int i = 0; i < a.getNumElements(); ++i) {
+        expectedVariance += (a.getData()[i] - m) * (a.getData()[i] - m);
+    }
+    BOOST_CHECK_CLOSE(ndarray::variance(a), expectedVariance / 210, 1E-10);
+    BOOST_CHECK_CLOSE(ndarray::variance(a, 1), expectedVariance / 209, 1E-10);
+    ndarray::Array<std::complex<double>,1,1> z = ndarray::allocate(4);
+    z[0] = std::complex<double>(1, 1);
+    z[1] = std::complex<double>(-1, 1);
+    z[2] = std::complex<double>(-1, -1);
+    z[3] = std::complex<double>(1, -1);
+    BOOST_CHECK_SMALL(std::abs(ndarray::mean(z)), 1E-15);
+    BOOST_CHECK_CLOSE(ndarray::variance(z), 2.0, 1E-10);
+
+    c[2][3][4] = 100;
+    c[4][1][0] = -100;
+    std::pair<int,int> extrema = ndarray::minmax(c);
+    BOOST_CHECK_EQUAL(extrema.first, -100);
+    BOOST_CHECK_EQUAL(extrema.second, 100);
+    BOOST_CHECK_EQUAL(ndarray::argmax(c), ndarray::makeVector(2, 3, 4));
+    BOOST_CHECK_EQUAL(ndarray::argmin(c), ndarray::makeVector(4, 1, 0));
+    BOOST_CHECK_EQUAL(ndarray::argmax(c[ndarray::view()(1, 6, 2)()] * 2), ndarray::makeVector(2, 1, 4));
+    BOOST_CHECK_EQUAL(ndarray::min(c[ndarray::view(0, 4)]), -4);
+    BOOST_CHECK_EQUAL(ndarray::max(-c), 100);
+
+    // pairwise summation keeps single-precision sums accurate
+    ndarray::Array<float,1,1> ones = ndarray::allocate(1 << 22);
+    ones.deep() = 0.1f;
+    float naive = 0.0f;
+    for (int i = 0; i < ones.getSize<0>(); ++i) naive += ones[i];
+    double const exact = (1 << 22) * double(0.1f);
+    BOOST_CHECK_CLOSE(double(ndarray::sum(ones)), exact, 1E-4);
+    BOOST_CHECK(std::abs(naive - exact) > 1E-2 * exact);
+}
+
+BOOST_AUTO_TEST_CASE(axisReductions) {
+    ndarray::Array<double,3,3> a = ndarray::allocate(4, 5, 6);
+    for (int i = 0; i < a.getNumElements(); ++i) a.getData()[i] = std::cos(0.3 * i) + 0.01 * i;
+    ndarray::Array<double,2,2> s0 = ndarray::sum<0>(a * 2.0);
+    ndarray::Array<double,2,2> s1 = ndarray::sum<1>(a * 2.0);
+    ndarray::Array<double,2,2> s2 = ndarray::sum<2>(a * 2.0);
+    ndarray::Array<double,2,2> m1 = ndarray::mean<1>(a);
+    ndarray::Array<double,2,2> v2 = ndarray::variance<2>(a, 1);
+    ndarray::Array<double,2,2> min0 = ndarray::min<0>(a);
+    ndarray::Array<double,2,2> max2 = ndarray::max<2>(a[ndarray::view()()(0, 6, 2)]);
+    BOOST_CHECK_EQUAL(s0.getShape(), ndarray::makeVector(5, 6));
+    BOOST_CHECK_EQUAL(s1.getShape(), ndarray::makeVector(4, 6));
+    BOOST_CHECK_EQUAL(s2.getShape(), ndarray::makeVector(4, 5));
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            double total = 0.0, squares = 0.0, top = a[i][j][0];
+            for (int k = 0; k < 6; ++k) {
+                total += a[i][j][k];
+                squares += a[i][j][k] * a[i][j][k];
+                if (k % 2 == 0) top = std::max(top, a[i][j][k]);
+            }
+            BOOST_CHECK_CLOSE(s2[i][j], 2.0 * total, 1E-10);
+            BOOST_CHECK_CLOSE(v2[i][j], (squares - total * total / 6) / 5, 1E-8);
+            BOOST_CHECK_EQUAL(max2[i][j], top);
+        }
+    }
+    for (int j = 0; j < 5; ++j) {
+        for (int k = 0; k < 6; ++k) {
+            double total = 0.0, bottom = a[0][j][k];
+            for (int i = 0; i < 4; ++i) {
+                total += a[i][j][k];
+                bottom = std::min(bottom, a[i][j][k]);
+            }
+            BOOST_CHECK_CLOSE(s0[j][k], 2.0 * total, 1E-10);
+            BOOST_CHECK_EQUAL(min0[j][k], bottom);
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        for (int k = 0; k < 6; ++k) {
+            double total = 0.0;
+            for (int j = 0; j < 5; ++j) total += a[i][j][k];
+            BOOST_CHECK_CLOSE(s1[i][k], 2.0 * total, 1E-10);
+            BOOST_CHECK_CLOSE(m1[i][k], total / 5, 1E-10);
+        }
+    }
+    ndarray::Array<int,2,2> c = ndarray::allocate(3, 4);
+    for (int i = 0; i < 12; ++i) c.getData()[i] = i;
+    ndarray::Array<double,1,1> cm = ndarray::mean<0>(c);
+    BOOST_CHECK_EQUAL(cm[1], 5.0);
+    ndarray::Array<int,1,1> cs = ndarray::sum<1>(c);
+    BOOST_CHECK_EQUAL(cs[2], 8 + 9 + 10 + 11);
+}
+
 BOOST_AUTO_TEST_CASE(broadcasting) {
     double data3[3*4*2] = { 
          0, 1, 2, 3, 4, 5, 6, 7,
@@ -377,6 +600,54 @@ BOOST_AUTO_TEST_CASE(broadcasting) {
     BOOST_CHECK(all(equal(c3, c32)));
 }
 
+BOOST_AUTO_TEST_CASE(broadcastOperands) {
+    ndarray::Array<double,2,2> image = ndarray::allocate(4, 5);
+    ndarray::Array<double,2,2> column = ndarray::allocate(4, 1);
+    ndarray::Array<double,2,2> row = ndarray::allocate(1, 5);
+    for (int i = 0; i < 20; ++i) image.getData()[i] = i;
+    for (int i = 0; i < 4; ++i) column[i][0] = 100.0 * i;
+    for (int j = 0; j < 5; ++j) row[0][j] = -1.0 * j;
+
+    // size-1 dimensions are expanded; contiguous operands must not be evaluated flat
+    ndarray::Array<double,2,2> result = ndarray::allocate(4, 5);
+    result.deep() = image * 2.0 + column;
+    BOOST_CHECK_EQUAL((image + column).getShape(), ndarray::makeVector(4, 5));
+    BOOST_CHECK_EQUAL((column - row).getShape(), ndarray::makeVector(4, 5));
+    ndarray::Array<double,2,2> outer = ndarray::copy(column - row);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            BOOST_CHECK_EQUAL(result[i][j], 2.0 * image[i][j] + 100.0 * i);
+            BOOST_CHECK_EQUAL(outer[i][j], 100.0 * i + j);
+        }
+    }
+    BOOST_CHECK_EQUAL(ndarray::sum(image - column), ndarray::sum(image) - 5 * ndarray::sum(column));
+    BOOST_CHECK_EQUAL((image + row)[2][3], 10.0);
+    BOOST_CHECK_EQUAL(((image + row).end() - (image + row).begin()), 4);
+
+    // broadcast views have zero strides and never copy
+    ndarray::Array<double,1,1> offsets = ndarray::allocate(5);
+    for (int j = 0; j < 5; ++j) offsets[j] = 0.5 * j;
+    ndarray::Array<double const,2,0> tiled = ndarray::broadcast<2>(offsets, image.getShape());
+    BOOST_CHECK_EQUAL(tiled.getShape(), ndarray::makeVector(4, 5));
+    BOOST_CHECK_EQUAL(tiled.getStrides(), ndarray::makeVector(0, 1));
+    BOOST_CHECK_EQUAL(tiled.getData(), offsets.getData());
+    BOOST_CHECK_EQUAL(tiled.end() - tiled.begin(), 4);
+    BOOST_CHECK_EQUAL(ndarray::sum(tiled), 4 * ndarray::sum(offsets));
+    ndarray::Array<double,2,2> copied = ndarray::copy(tiled);
+    result.deep() = image;
+    result.deep() += tiled;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            BOOST_CHECK_EQUAL(copied[i][j], 0.5 * j);
+            BOOST_CHECK_EQUAL(result[i][j], image[i][j] + 0.5 * j);
+        }
+    }
+    ndarray::Array<double const,3,0> expanded = ndarray::broadcast<3>(column, ndarray::makeVector(2, 4, 3));
+    BOOST_CHECK_EQUAL(expanded.getStrides(), ndarray::makeVector(0, 1, 0));
+    BOOST_CHECK_EQUAL(expanded[1][3][2], 300.0);
+    BOOST_CHECK_EQUAL(ndarray::sum(expanded), 6 * ndarray::sum(column));
+}
+
 #endif
 
 BOOST_AUTO_TEST_CASE(assignment) {
@@ -432,6 +703,104 @@ BOOST_AUTO_TEST_CASE(assignment) {
     }
 }
 
+#ifndef GCC_45
+
+BOOST_AUTO_TEST_CASE(flatAssignment) {
+    ndarray::Vector<int,3> shape = ndarray::makeVector(3,4,5);
+    ndarray::Array<double,3,3> a = ndarray::allocate(shape);
+    ndarray::Array<double,3,3> b = ndarray::allocate(shape);
+    for (int i=0; i<shape[0]; ++i) {
+        for (int j=0; j<shape[1]; ++j) {
+            for (int k=0; k<shape[2]; ++k) {
+                a[i][j][k] = i*20 + j*5 + k;
+                b[i][j][k] = 0.5*k - j + 2*i;
+            }
+        }
+    }
+    // contiguous at compile time
+    ndarray::Array<double,3,3> c = ndarray::allocate(shape);
+    c.deep() = a * b + a;
+    // contiguous only at runtime
+    ndarray::Array<double,3> d = ndarray::allocate(shape);
+    ndarray::Array<double const,3> a0(a);
+    d.deep() = a0 * b + a0;
+    // column-major destination and operands
+    ndarray::Array<double,3,3> eT = ndarray::allocate(ndarray::makeVector(5,4,3));
+    ndarray::Array<double,3,-3> e = eT.transpose();
+    e.deep() = 0.0;
+    e.deep() += a;
+    e.deep() *= b;
+    e.deep() += a;
+    // mixed layout, which must fall back to nested iteration
+    ndarray::Array<double,3,3> f = ndarray::allocate(shape);
+    f.deep() = 0.0;
+    f.deep() += e * b.transpose().transpose();
+    f.deep() += a0;
+    // non-dense destination, which must also fall back
+    ndarray::Array<double,3,3> g = ndarray::allocate(ndarray::makeVector(3,4,10));
+    g.deep() = -1.0;
+    ndarray::ArrayRef<double,3> h = g[ndarray::view()()(0,10,2)];
+    h = a * b;
+    h += a;
+    for (int i=0; i<shape[0]; ++i) {
+        for (int j=0; j<shape[1]; ++j) {
+            for (int k=0; k<shape[2]; ++k) {
+                double expected = a[i][j][k] * b[i][j][k] + a[i][j][k];
+                BOOST_CHECK_CLOSE(c[i][j][k], expected, 1E-8);
+                BOOST_CHECK_CLOSE(d[i][j][k], expected, 1E-8);
+                BOOST_CHECK_CLOSE(e[i][j][k], expected, 1E-8);
+                BOOST_CHECK_CLOSE(h[i][j][k], expected, 1E-8);
+                BOOST_CHECK_CLOSE(f[i][j][k], e[i][j][k] * b[i][j][k] + a[i][j][k], 1E-8);
+                BOOST_CHECK_EQUAL(g[i][j][2*k+1], -1.0);
+            }
+        }
+    }
+}
+
+template <typename T>
+void testPacketEvaluation() {
+    // 37 elements: not a multiple of any SIMD packet size, so the scalar tail is exercised.
+    ndarray::Vector<int,2> shape = ndarray::makeVector(37,1);
+    ndarray::Array<T,2,2> a = ndarray::allocate(shape);
+    ndarray::Array<T,2,2> b = ndarray::allocate(shape);
+    ndarray::Array<T,2,2> c = ndarray::allocate(shape);
+    for (int i=0; i<shape[0]; ++i) {
+        a[i][0] = T(0.25) * i + T(1);
+        b[i][0] = T(2.25) - T(0.5) * i;
+        c[i][0] = T(i % 5);
+    }
+    ndarray::Array<T,2,2> r1 = ndarray::allocate(shape);
+    ndarray::Array<T,2,2> r2 = ndarray::allocate(shape);
+    ndarray::Array<T,2,2> r3 = ndarray::allocate(shape);
+    ndarray::Array<T,2,2> r4 = ndarray::allocate(shape);
+    r1.deep() = a * b + c;
+    r2.deep() = -a / b - T(3) * c;
+    r3.deep() = T(1.5);
+    r3.deep() += a;
+    r3.deep() *= b;
+    r3.deep() -= T(2);
+    r3.deep() /= a;
+    r4.deep() = c;
+    r4.deep() -= 2;
+    for (int i=0; i<shape[0]; ++i) {
+        T e1 = a[i][0] * b[i][0] + c[i][0];
+        T e2 = -a[i][0] / b[i][0] - T(3) * c[i][0];
+        T e3 = ((T(1.5) + a[i][0]) * b[i][0] - T(2)) / a[i][0];
+        BOOST_CHECK_CLOSE(double(r1[i][0]), double(e1), 1E-4);
+        BOOST_CHECK_CLOSE(double(r2[i][0]), double(e2), 1E-4);
+        BOOST_CHECK_CLOSE(double(r3[i][0]), double(e3), 1E-4);
+        BOOST_CHECK_EQUAL(r4[i][0], c[i][0] - 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(packetEvaluation) {
+    testPacketEvaluation<float>();
+    testPacketEvaluation<double>();
+    testPacketEvaluation<int>();
+}
+
+#endif
+
 BOOST_AUTO_TEST_CASE(transpose) {
     double data[3*4*2] = {
          0, 1, 2, 3, 4, 5, 6, 7,
@@ -495,6 +864,100 @@ BOOST_AUTO_TEST_CASE(transpose) {
     }
 }
 
+template <typename T>
+void checkTransposeAssignment(int rows, int cols) {
+    ndarray::Array<T,2,2> a = ndarray::allocate(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            a[i][j] = T(i * cols + j);
+        }
+    }
+    ndarray::Array<T,2,2> bt = ndarray::allocate(cols, rows);
+    ndarray::Array<T,2,-2> b = bt.transpose();
+    b.deep() = a;
+    ndarray::Array<T,2,2> c = ndarray::allocate(cols, rows);
+    c.deep() = a.transpose();
+    ndarray::Array<double,2,2> d = ndarray::allocate(cols, rows);
+    d.deep() = a.transpose();
+    d.deep() += a.transpose();
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            BOOST_CHECK_EQUAL(b[i][j], a[i][j]);
+            BOOST_CHECK_EQUAL(c[j][i], a[i][j]);
+            BOOST_CHECK_EQUAL(d[j][i], 2.0 * a[i][j]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transposeAssignment) {
+    checkTransposeAssignment<double>(67, 45);
+    checkTransposeAssignment<float>(131, 9);
+    checkTransposeAssignment<int>(40, 33);
+    checkTransposeAssignment<double>(3, 1);
+
+    // 3-d, with one dimension that is neither array's fastest, and a strided source
+    ndarray::Array<float,3,3> a = ndarray::allocate(5, 70, 36);
+    for (int i = 0; i < a.getNumElements(); ++i) a.getData()[i] = float(i);
+    ndarray::Array<float,3,3> b = ndarray::allocate(36, 5, 35);
+    b.deep() = ndarray::transpose(a, ndarray::makeVector(2, 0, 1))[ndarray::view()()(0, 70, 2)];
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 35; ++j) {
+            for (int k = 0; k < 36; ++k) {
+                BOOST_CHECK_EQUAL(b[k][i][j], a[i][2*j][k]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(plannedEvaluation) {
+    // row-major, column-major and permuted operands in one expression
+    ndarray::Array<double,3,3> a = ndarray::allocate(4, 6, 5);
+    for (int i = 0; i < a.getNumElements(); ++i) a.getData()[i] = double(i);
+    ndarray::Array<double,3,3> bt = ndarray::allocate(5, 6, 4);
+    ndarray::Array<double,3,-3> b = bt.transpose();
+    b.deep() = a;
+    ndarray::Array<double,3,3> ct = ndarray::allocate(6, 5, 4);
+    ndarray::Array<double,3,0> c = ndarray::transpose(ct, ndarray::makeVector(2, 0, 1));
+    c.deep() = 2.0 * a;
+    ndarray::Array<double,3,3> d = ndarray::allocate(4, 6, 5);
+    d.deep() = a + b * c;
+    ndarray::Array<double,3,3> et = ndarray::allocate(5, 6, 4);
+    ndarray::Array<double,3,-3> e = et.transpose();
+    e.deep() = 0.0;
+    e.deep() -= a + b * c;
+    // strided destination and a reversed dimension
+    ndarray::Array<double,3,3> ft = ndarray::allocate(4, 12, 5);
+    ndarray::Array<double,3,1> f = ft[ndarray::view()(0, 12, 2)()];
+    ndarray::Array<double,3,0> g = ndarray::external(
+        a.getData() + 4, a.getShape(), ndarray::makeVector(30, 5, -1), a
+    );
+    f.deep() = b - g;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            for (int k = 0; k < 5; ++k) {
+                double const x = a[i][j][k];
+                BOOST_CHECK_EQUAL(b[i][j][k], x);
+                BOOST_CHECK_EQUAL(d[i][j][k], x + 2.0 * x * x);
+                BOOST_CHECK_EQUAL(e[i][j][k], -d[i][j][k]);
+                BOOST_CHECK_EQUAL(f[i][j][k], x - a[i][j][4 - k]);
+            }
+        }
+    }
+
+    // reductions over the same layouts
+    double expected = 0.0;
+    for (int i = 0; i < a.getNumElements(); ++i) {
+        expected += a.getData()[i] * (1.0 + 2.0 * a.getData()[i]);
+    }
+    BOOST_CHECK_CLOSE(ndarray::sum(a + b * c), expected, 1E-12);
+    BOOST_CHECK_CLOSE(ndarray::sum(-e), expected, 1E-12);
+    BOOST_CHECK_EQUAL(ndarray::max(f), 4.0);
+    BOOST_CHECK_EQUAL(ndarray::argmax(f), ndarray::makeVector(0, 0, 4));
+    BOOST_CHECK_EQUAL(ndarray::argmin(f), ndarray::makeVector(0, 0, 0));
+    BOOST_CHECK_EQUAL(ndarray::argmin(e), ndarray::makeVector(3, 5, 4));
+    BOOST_CHECK_EQUAL(ndarray::argmin(g), ndarray::makeVector(0, 0, 4));
+}
+
 BOOST_AUTO_TEST_CASE(flatten) {
     double data[3*4*2] = { 
          0, 1, 2, 3, 4, 5, 6, 7,
@@ -515,6 +978,68 @@ BOOST_AUTO_TEST_CASE(flatten) {
     );
 }
 
+BOOST_AUTO_TEST_CASE(axisViews) {
+    double data[3*4*2] = {
+         0, 1, 2, 3, 4, 5, 6, 7,
+         8, 9,10,11,12,13,14,15,
+        16,17,18,19,20,21,22,23,
+    };
+    ndarray::Array<double,3,3> a = ndarray::external(
+        data, ndarray::makeVector(3,4,2), ndarray::makeVector(8,2,1)
+    );
+    ndarray::Array<double,3> t = ndarray::transpose(a, ndarray::makeVector(2,0,1));
+    BOOST_CHECK_EQUAL(t.getShape(), ndarray::makeVector(2,3,4));
+    BOOST_CHECK_EQUAL(t.getData(), a.getData());
+    ndarray::Array<double,3,1> s = ndarray::swapaxes<0,1>(a);
+    ndarray::Array<double,3,-3> at = a.transpose();
+    ndarray::Array<double,3,-1> s2 = ndarray::swapaxes<1,2>(at);
+    for (int i=0; i<3; ++i) {
+        for (int j=0; j<4; ++j) {
+            for (int k=0; k<2; ++k) {
+                BOOST_CHECK_EQUAL(t[k][i][j], a[i][j][k]);
+                BOOST_CHECK_EQUAL(s[j][i][k], a[i][j][k]);
+                BOOST_CHECK_EQUAL(s2[k][i][j], a[i][j][k]);
+            }
+        }
+    }
+
+    // contiguous arrays can always be reshaped
+    ndarray::Array<double,2,2> r = ndarray::reshape(a, ndarray::makeVector(6,4));
+    BOOST_CHECK_EQUAL(r.getStrides(), ndarray::makeVector(4,1));
+    BOOST_CHECK_EQUAL(r[5][3], 23.0);
+    // merging dimensions that are not contiguous with respect to each other would require a
+    // copy, so the result is empty
+    ndarray::Array<double,3> every = a[ndarray::view()(0,4,2)()];
+    ndarray::Array<double,2> r2 = ndarray::reshape(every, ndarray::makeVector(3,4));
+    BOOST_CHECK(r2.isEmpty());
+    BOOST_CHECK_EQUAL(r2.getNumElements(), 0);
+    // merges and splits within dimensions that are contiguous with respect to each other
+    // need no copy
+    ndarray::Array<double,3,2> firstRows = a[ndarray::view(0,3,2)()()];
+    ndarray::Array<double,3> r3 = ndarray::reshape(firstRows, ndarray::makeVector(2,2,4));
+    BOOST_CHECK(!r3.isEmpty());
+    BOOST_CHECK_EQUAL(r3.getStrides(), ndarray::makeVector(16,4,1));
+    BOOST_CHECK_EQUAL(r3[1][1][2], 22.0);
+    ndarray::Array<double,4> r4 = ndarray::reshape(every, ndarray::makeVector(3,1,2,2));
+    BOOST_CHECK(!r4.isEmpty());
+    BOOST_CHECK_EQUAL(r4[2][0][1][0], a[2][2][0]);
+    BOOST_CHECK(ndarray::reshape(at, ndarray::makeVector(24)).isEmpty());
+
+    ndarray::Array<double,4,4> e = ndarray::expand_dims<1>(a);
+    BOOST_CHECK_EQUAL(e.getShape(), ndarray::makeVector(3,1,4,2));
+    BOOST_CHECK(ndarray::dynamic_dimension_cast<4>(ndarray::Array<double,4>(e)) == e);
+    ndarray::Array<double,4,2> e2 = ndarray::expand_dims<0>(firstRows);
+    BOOST_CHECK_EQUAL(e2.getShape(), ndarray::makeVector(1,2,4,2));
+    ndarray::Array<double,4,3> e3 = ndarray::expand_dims<1>(firstRows);
+    BOOST_CHECK_EQUAL(e3.getShape(), ndarray::makeVector(2,1,4,2));
+    ndarray::Array<double,3,3> sq = ndarray::squeeze<1>(e);
+    BOOST_CHECK(sq == a);
+    ndarray::Array<double,3,0> column = a[ndarray::view(1,2)()(1,2)];
+    ndarray::Array<double,2,0> sq2 = ndarray::squeeze<0>(column);
+    BOOST_CHECK_EQUAL(sq2.getShape(), ndarray::makeVector(4,1));
+    BOOST_CHECK_EQUAL(sq2[3][0], a[1][3][1]);
+}
+
 BOOST_AUTO_TEST_CASE(unique) {
     ndarray::Array<double,2,2> a = ndarray::allocate(5,4);
     BOOST_CHECK(a.isUnique());
@@ -567,6 +1092,65 @@ BOOST_AUTO_TEST_CASE(manager) {
     BOOST_CHECK_EQUAL(a.getManager(), b.getManager()); // no extra indirection in makeManager
 }
 
+BOOST_AUTO_TEST_CASE(dynamicArray) {
+    ndarray::Array<double,3,3> a = ndarray::allocate(4, 5, 6);
+    for (int i = 0; i < a.getNumElements(); ++i) a.getData()[i] = i;
+    ndarray::DynamicArray<double> d(a);
+    BOOST_CHECK_EQUAL(d.getNumDimensions(), 3);
+    BOOST_CHECK_EQUAL(d.getSize(1), 5);
+    BOOST_CHECK_EQUAL(d.getStride(0), 30);
+    BOOST_CHECK_EQUAL(d.getNumElements(), 120);
+    BOOST_CHECK_EQUAL(d.getData(), a.getData());
+    BOOST_CHECK_EQUAL(d.getManager(), a.getManager());
+    BOOST_CHECK((d.isConvertible<3,3>()));
+    BOOST_CHECK((!d.isConvertible<3,-1>()));
+    ndarray::Array<double,3,3> b = d.toArray<3,3>();
+    BOOST_CHECK_EQUAL(b.getData(), a.getData());
+    BOOST_CHECK_EQUAL(b.getStrides(), a.getStrides());
+    BOOST_CHECK_THROW((d.toArray<2,2>()), std::runtime_error);
+    BOOST_CHECK_THROW((d.toArray<3,-3>()), std::runtime_error);
+
+    // strided views convert only to Arrays with weaker contiguity guarantees
+    ndarray::DynamicArray<double const> view(a[ndarray::view()(1, 5, 2)(0, 3)]);
+    BOOST_CHECK((view.isConvertible<3,1>()));
+    BOOST_CHECK((!view.isConvertible<3,2>()));
+    ndarray::Array<double const,3,0> c = view.toArray<3,0>();
+    BOOST_CHECK_EQUAL(c[2][1][2], a[2][3][2]);
+
+    // deep copies through the rank-independent copy engine
+    ndarray::DynamicArray<double> e = ndarray::copy(view);
+    BOOST_CHECK(e.getShape() == view.getShape());
+    BOOST_CHECK((e.isConvertible<3,3>()));
+    ndarray::Array<double,3,3> f = e.toArray<3,3>();
+    ndarray::Array<float,3,-3> g = ndarray::allocate(4, 5, 6);
+    ndarray::DynamicArray<float>(g).assign(d);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            for (int k = 0; k < 6; ++k) {
+                BOOST_CHECK_EQUAL(g[i][j][k], float(a[i][j][k]));
+                if (j % 2 == 1 && k < 3) BOOST_CHECK_EQUAL(f[i][j / 2][k], a[i][j][k]);
+            }
+        }
+    }
+
+    // many dimensions and zero strides
+    std::vector<int> shape(6, 2);
+    shape[5] = 3;
+    ndarray::DynamicArray<int> h = ndarray::allocateDynamic<int>(shape, ndarray::COLUMN_MAJOR);
+    BOOST_CHECK_EQUAL(h.getStride(5), 32);
+    int value = 7;
+    std::vector<int> zeros(6, 0);
+    ndarray::DynamicArray<int const> constant(&value, shape, zeros);
+    h.assign(constant);
+    for (int i = 0; i < h.getNumElements(); ++i) BOOST_CHECK_EQUAL(h.getData()[i], 7);
+    ndarray::DynamicArray<int> h2;
+    h2 = h;
+    BOOST_CHECK_EQUAL(h2.getNumDimensions(), 6);
+    BOOST_CHECK(h2.getStrides() == h.getStrides());
+    h2 = ndarray::DynamicArray<int>();
+    BOOST_CHECK(h2.isEmpty());
+}
+
 BOOST_AUTO_TEST_CASE(issue3) {
     ndarray::Array<double,1,1> a1(5);
     ndarray::Array<double,1,1> r1(5);
@@ -0,0 +1,42 @@
+# -*- python -*-
+#
+#  Copyright (c) 2010-2012, Jim Bosch
+#  All rights reserved.
+#
+#  ndarray is distributed under a simple BSD-like license;
+#  see the LICENSE file that should be present in the root
+#  of the source distribution, or alternately available at:
+#  https://github.com/ndarray/ndarray
+#
+"""Per-call overhead of converting numpy arrays to ndarray::Array arguments.
+
+Each function converts its argument and returns None, so the time for noop (which takes
+any object without converting it) is the cost of the call itself.
+"""
+import sys
+import timeit
+import numpy
+import python_bench_mod
+
+def report(label, seconds, baseline=None):
+    line = "    %-32s%12.4f us" % (label, seconds * 1E6)
+    if baseline:
+        line += "%10.3fx" % (baseline / seconds)
+    print(line)
+
+def benchmarkConversion(ndim, nCalls):
+    array = numpy.zeros((4,) * ndim, dtype=float)
+    print("conversion of %d-d arrays (%d calls)" % (ndim, nCalls))
+    timings = []
+    for name in ("noop", "legacyArray%d" % ndim, "passArray%d" % ndim):
+        f = getattr(python_bench_mod, name)
+        timings.append(min(timeit.repeat(lambda: f(array), number=nCalls, repeat=5)) / nCalls)
+    call = timings[0]
+    report("call", call)
+    report("legacy (overhead)", timings[1] - call)
+    report("single pass (overhead)", timings[2] - call, timings[1] - call)
+
+if __name__ == "__main__":
+    nCalls = int(sys.argv[1]) if len(sys.argv) > 1 else 200000
+    for ndim in (1, 2, 3):
+        benchmarkConversion(ndim, nCalls)
@@ -0,0 +1,98 @@
+// -*- c++ -*-
+/*
+ * Copyright (c) 2010-2012, Jim Bosch
+ * All rights reserved.
+ *
+ * ndarray is distributed under a simple BSD-like license;
+ * see the LICENSE file that should be present in the root
+ * of the source distribution, or alternately available at:
+ * https://github.com/ndarray/ndarray
+ */
+#include "Python.h"
+#include "numpy/arrayobject.h"
+#include "ndarray/swig.h"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+// Reproduces the Array converter used before fromPythonStage1() validated arguments in a
+// single pass: each check reads the array again, and the second stage checks alignment.
+template <typename T, int N, int C>
+static int legacyFromPython(PyObject * arg, ndarray::Array<T,N,C> * output) {
+    typedef typename boost::remove_const<T>::type NonConst;
+    if (!PyArray_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "numpy.ndarray argument required");
+        return false;
+    }
+    if (PyArray_TYPE(arg) != ndarray::detail::NumpyTraits<NonConst>::getCode()) {
+        PyErr_SetString(PyExc_ValueError, "numpy.ndarray argument has incorrect data type");
+        return false;
+    }
+    if (PyArray_NDIM(arg) != N) {
+        PyErr_SetString(PyExc_ValueError, "numpy.ndarray argument has incorrect number of dimensions");
+        return false;
+    }
+    if (!boost::is_const<T>::value && !(PyArray_FLAGS(arg) & NPY_WRITEABLE)) {
+        PyErr_SetString(PyExc_TypeError, "numpy.ndarray argument must be writeable");
+        return false;
+    }
+    int requiredStride = sizeof(T);
+    for (int i = 0; i < C; ++i) {
+        if (PyArray_STRIDE(arg, N-i-1) != requiredStride) {
+            PyErr_SetString(PyExc_ValueError, "numpy.ndarray does not have enough row-major contiguous dimensions");
+            return false;
+        }
+        requiredStride *= PyArray_DIM(arg, N-i-1);
+    }
+    if (!(PyArray_FLAGS(arg) & NPY_ALIGNED)) {
+        PyErr_SetString(PyExc_ValueError, "unaligned arrays cannot be converted to C++");
+        return false;
+    }
+    ndarray::Vector<int,N> shape;
+    ndarray::Vector<int,N> strides;
+    std::copy(PyArray_DIMS(arg), PyArray_DIMS(arg) + N, shape.begin());
+    std::copy(PyArray_STRIDES(arg), PyArray_STRIDES(arg) + N, strides.begin());
+    for (int i = 0; i < N; ++i) strides[i] /= sizeof(T);
+    *output = ndarray::external(
+        reinterpret_cast<T*>(PyArray_DATA(arg)), shape, strides, ndarray::PyPtr(arg, true)
+    );
+    return true;
+}
+
+static PyObject * noop(PyObject * self, PyObject * args) {
+    PyObject * arg;
+    if (!PyArg_ParseTuple(args,"O",&arg)) return NULL;
+    Py_RETURN_NONE;
+}
+
+template <typename T, int N, int C>
+static PyObject * legacyArray(PyObject * self, PyObject * args) {
+    ndarray::Array<T,N,C> array;
+    if (!PyArg_ParseTuple(args,"O&",&legacyFromPython<T,N,C>,&array)) return NULL;
+    Py_RETURN_NONE;
+}
+
+template <typename T, int N, int C>
+static PyObject * passArray(PyObject * self, PyObject * args) {
+    ndarray::Array<T,N,C> array;
+    if (!PyArg_ParseTuple(args,"O&",ndarray::PyConverter< ndarray::Array<T,N,C> >::fromPython,&array))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef methods[] = {
+    {"noop",&noop,METH_VARARGS,NULL},
+    {"legacyArray1",&legacyArray<double,1,1>,METH_VARARGS,NULL},
+    {"legacyArray2",&legacyArray<double,2,1>,METH_VARARGS,NULL},
+    {"legacyArray3",&legacyArray<double,3,1>,METH_VARARGS,NULL},
+    {"passArray1",&passArray<double,1,1>,METH_VARARGS,NULL},
+    {"passArray2",&passArray<double,2,1>,METH_VARARGS,NULL},
+    {"passArray3",&passArray<double,3,1>,METH_VARARGS,NULL},
+    {NULL}
+};
+
+extern "C"
+PyMODINIT_FUNC
+initpython_bench_mod(void) {
+    import_array();
+    PyObject * module = Py_InitModule("python_bench_mod",methods);
+    if (module == NULL) return;
+}
@@ -99,6 +99,28 @@ class TestNDArray(unittest.TestCase):
         self.assertRaises(ValueError, python_test_mod.passFloatArray30,
                           numpy.zeros((4,3,4),dtype=numpy.int32))
 
+    def testCopyPolicy(self):
+        a1 = numpy.arange(60, dtype=float).reshape(5,3,4)
+        a2 = a1[:,:,::2]
+        self.assertRaises(ValueError, python_test_mod.passConstFloatArray33, a2)
+        python_test_mod.setCopyPolicy(True)
+        try:
+            b1 = python_test_mod.passConstFloatArray33(a1)
+            self.assertEqual(python_test_mod.getCopyCounters(), (0, 0, 0))
+            b2 = python_test_mod.passConstFloatArray33(a2)
+            self.assert_((b2 == a2).all())
+            self.assert_(b2.flags["C_CONTIGUOUS"])
+            self.assert_(not b2.flags.writeable)
+            self.assertEqual(python_test_mod.getCopyCounters(), (1, a2.nbytes, a2.nbytes))
+            b3 = python_test_mod.passConstFloatArray3m3(a1)
+            self.assert_((b3 == a1).all())
+            self.assert_(b3.flags["F_CONTIGUOUS"])
+            self.assertEqual(python_test_mod.getCopyCounters(), (2, a2.nbytes + a1.nbytes,
+                                                                 a2.nbytes + a1.nbytes))
+            self.assertRaises(ValueError, python_test_mod.passFloatArray33, a2)
+        finally:
+            python_test_mod.setCopyPolicy(False)
+
     def testFloatArrayCreation(self):
         a = python_test_mod.makeFloatArray3((3,4,5))
     
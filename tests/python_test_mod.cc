@@ -39,6 +39,29 @@ static PyObject * makeArray(PyObject * self, PyObject * args) {
     return ndarray::PyConverter< ndarray::Array<T,N,N> >::toPython(array);
 }
 
+static std::size_t hookBytes = 0;
+
+static void recordCopy(PyObject * source, std::size_t bytes) {
+    hookBytes += bytes;
+}
+
+static PyObject * setCopyPolicy(PyObject * self, PyObject * args) {
+    int enabled;
+    if (!PyArg_ParseTuple(args,"i",&enabled)) return NULL;
+    ndarray::PyCopyPolicy::setEnabled(enabled);
+    ndarray::PyCopyPolicy::setHook(enabled ? &recordCopy : NULL);
+    ndarray::PyCopyPolicy::resetCounters();
+    hookBytes = 0;
+    Py_RETURN_NONE;
+}
+
+static PyObject * getCopyCounters(PyObject * self, PyObject * args) {
+    return Py_BuildValue(
+        "lll", long(ndarray::PyCopyPolicy::getCopyCount()),
+        long(ndarray::PyCopyPolicy::getBytesCopied()), long(hookBytes)
+    );
+}
+
 static PyMethodDef methods[] = {
     {"passFloatVector3",&passVector<double,3>,METH_VARARGS,NULL},
     {"passFloatArray33",&passArray<double,3,3>,METH_VARARGS,NULL},
@@ -50,6 +73,9 @@ static PyMethodDef methods[] = {
     {"passConstIntArray33",&passArray<int const,3,3>,METH_VARARGS,NULL},
     {"passIntArray30",&passArray<int,3,0>,METH_VARARGS,NULL},
     {"makeIntArray3",&makeArray<int,3>,METH_VARARGS,NULL},
+    {"passConstFloatArray3m3",&passArray<double const,3,-3>,METH_VARARGS,NULL},
+    {"setCopyPolicy",&setCopyPolicy,METH_VARARGS,NULL},
+    {"getCopyCounters",&getCopyCounters,METH_NOARGS,NULL},
     {NULL}
 };
 
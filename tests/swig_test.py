@@ -44,6 +44,21 @@ class TestNumpySwig(unittest.TestCase):
         self.assert_((a1 == a3).all())
         self.assert_(a3.flags["WRITEABLE"] == False)
 
+    def testBuffers(self):
+        a1 = swig_test_mod.returnBufferArray2()
+        v = memoryview(a1)
+        self.assertEqual(v.shape, (3,4))
+        self.assertEqual(v.format, "f")
+        a2 = numpy.asarray(a1)
+        self.assert_((a2 == numpy.arange(12, dtype=numpy.float32).reshape(3,4)).all())
+        self.assertEqual(swig_test_mod.acceptBufferArray2(a1), 65.0)
+        self.assertEqual(a2[0,0], -1.0)
+        self.assertEqual(swig_test_mod.acceptBufferArray2(a2[:,::2].transpose().copy()), 29.0)
+        self.assertRaises(ValueError, swig_test_mod.acceptBufferArray2, memoryview(a2[:,::2]))
+        self.assertRaises(ValueError, swig_test_mod.acceptBufferArray2, swig_test_mod.returnStridedBufferArray2())
+        self.assert_(swig_test_mod.acceptArray1(memoryview(numpy.arange(6, dtype=float))))
+        self.assert_(swig_test_mod.acceptArray3(memoryview(numpy.arange(4*3*2, dtype=float).reshape(4,3,2))))
+
     def testClass(self):
         a = swig_test_mod.MatrixOwner()
         m1 = a.member
@@ -52,11 +67,61 @@ class TestNumpySwig(unittest.TestCase):
         self.assert_((m2 == 0).all())
         self.assertEqual(m1.shape, (2,2))
         self.assertEqual(m2.shape, (2,2))
+        # attributes are copied; getters declared with %declareSharedNumPyGetter share the
+        # member's memory, read-only, and keep the owner alive
+        m3 = a.getMap()
+        self.assert_((m3 == 0).all())
+        address = m2.__array_interface__["data"][0]
+        self.assertNotEqual(m1.__array_interface__["data"][0], address)
+        self.assert_(m1.flags["WRITEABLE"])
+        for m in (m2, m3):
+            self.assertEqual(m.__array_interface__["data"][0], address)
+            self.assertFalse(m.flags["WRITEABLE"])
+        del a
+        self.assert_((m2 == 0).all())
+        self.assert_((m3 == 0).all())
+
+    def testUFunctors(self):
+        a = numpy.arange(12, dtype=float).reshape(3,4)
+        b = numpy.arange(4, dtype=float)
+        self.assert_(numpy.allclose(swig_test_mod.applyHypot(a, b, None), numpy.hypot(a, b)))
+        out = numpy.zeros((4,3), dtype=float).transpose()
+        result = swig_test_mod.applyHypot(a, b, out)
+        self.assert_(result is out)
+        self.assert_(numpy.allclose(out, numpy.hypot(a, b)))
+        c = numpy.arange(10, dtype=numpy.float32)[::2]
+        self.assert_((swig_test_mod.applyNegate(c, None) == -c).all())
+        self.assertRaises(ValueError, swig_test_mod.applyHypot, a, b, numpy.zeros(4))
+        hypot = swig_test_mod.makeHypotUFunc()
+        self.assert_(numpy.allclose(hypot(a, b), numpy.hypot(a, b)))
+        # exceptions from the function object are raised as RuntimeError
+        d = numpy.arange(-3, 100, dtype=float)
+        self.assertRaises(RuntimeError, swig_test_mod.applyCheckedSqrt, d, None)
+        self.assert_((swig_test_mod.applyCheckedSqrt(numpy.array([4.0]), None) == 2.0).all())
+        checkedSqrt = swig_test_mod.makeCheckedSqrtUFunc()
+        self.assertEqual(checkedSqrt.__name__, "checked_sqrt")
+        self.assert_(checkedSqrt.__doc__.endswith("Square root that raises for negative arguments."))
+        self.assertRaises(RuntimeError, checkedSqrt, d)
 
     def testOverloads(self):
         self.assertEqual(swig_test_mod.acceptOverload(1), 0)
         self.assertEqual(swig_test_mod.acceptOverload(numpy.zeros((2,2), dtype=float)), 2)
         self.assertEqual(swig_test_mod.acceptOverload(numpy.zeros((3,3), dtype=float)), 3)
+
+    def testCopyOverloads(self):
+        a = numpy.arange(12, dtype=float)[::2]
+        swig_test_mod.setCopyPolicy(True)
+        try:
+            # overload resolution must not copy; only the conversion of the chosen argument does
+            self.assertEqual(swig_test_mod.acceptCopyOverload(a), a.sum())
+            self.assertEqual(swig_test_mod.getCopyCount(), 1)
+            self.assertEqual(swig_test_mod.acceptCopyOverload(2), -1.0)
+            self.assertEqual(swig_test_mod.getCopyCount(), 1)
+            # Eigen arguments are viewed with any strides, so they are never copied
+            self.assertEqual(swig_test_mod.acceptOverload(numpy.zeros((2,4), dtype=float)[:,::2]), 2)
+            self.assertEqual(swig_test_mod.getCopyCount(), 1)
+        finally:
+            swig_test_mod.setCopyPolicy(False)
         
 
 if __name__ == "__main__":
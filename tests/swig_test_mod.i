@@ -12,12 +12,18 @@
 %{
 #define PY_ARRAY_UNIQUE_SYMBOL LSST_SWIG_TEST_NUMPY_ARRAY_API
 #include "numpy/arrayobject.h"
+#include "numpy/ufuncobject.h"
 #include "ndarray/swig.h"
 #include "ndarray/swig/eigen.h"
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <string>
 #pragma GCC diagnostic ignored "-Wuninitialized"
 %}
 %init %{
     import_array();
+    import_ufunc();
 %}
 
 %include "ndarray.i"
@@ -30,6 +36,10 @@
 %declareNumPyConverters(ndarray::Array<double const,1,1>);
 %declareNumPyConverters(ndarray::Array<double,3>);
 %declareNumPyConverters(ndarray::Array<double const,3>);
+%declareBufferConverters(ndarray::Array<float,2,1>);
+%declareBufferConverters(ndarray::Array<float,2>);
+%declareSharedNumPyGetter(MatrixOwner, getMember, Eigen::Matrix<double,2,2,Eigen::DontAlign>);
+%declareSharedNumPyGetter(MatrixOwner, getMap, Eigen::Map< Eigen::Matrix<double,2,2,Eigen::DontAlign> >);
 
 %inline %{
 
@@ -74,6 +84,24 @@ ndarray::Array<double const,3> returnConstArray3() {
     return returnArray3();
 }
 
+ndarray::Array<float,2,1> returnBufferArray2() {
+    ndarray::Array<float,2,2> r(ndarray::allocate(ndarray::makeVector(3,4)));
+    ndarray::Array<float,1,1> f = ndarray::flatten<1>(r);
+    for (int n = 0; n < f.getSize<0>(); ++n) {
+        f[n] = n;
+    }
+    return r;
+}
+
+ndarray::Array<float,2> returnStridedBufferArray2() {
+    return returnBufferArray2()[ndarray::view()(0,4,2)];
+}
+
+double acceptBufferArray2(ndarray::Array<float,2,1> const & a) {
+    a[0][0] = -1.0f;
+    return ndarray::sum(a);
+}
+
 bool acceptMatrixXd(Eigen::MatrixXd const & m1) {
     Eigen::MatrixXd m2 = returnMatrixXd();
     return m1 == m2;
@@ -119,6 +147,56 @@ int acceptOverload(Eigen::Matrix2d const & m) {
     return 2;
 }
 
+double acceptCopyOverload(ndarray::Array<double const,1,1> const & a) {
+    return ndarray::sum(a);
+}
+
+double acceptCopyOverload(int n) {
+    return -1.0;
+}
+
+void setCopyPolicy(bool enabled) {
+    ndarray::PyCopyPolicy::setEnabled(enabled);
+    ndarray::PyCopyPolicy::resetCounters();
+}
+
+int getCopyCount() {
+    return ndarray::PyCopyPolicy::getCopyCount();
+}
+
+struct Hypot : public std::binary_function<double,double,double> {
+    double operator()(double a, double b) const { return std::sqrt(a * a + b * b); }
+};
+
+PyObject * makeHypotUFunc() {
+    return ndarray::PyBinaryUFunctor<Hypot>::makeUFunc(Hypot(), "hypot");
+}
+
+PyObject * applyHypot(PyObject * a, PyObject * b, PyObject * out) {
+    return ndarray::PyBinaryUFunctor<Hypot>::_call_(Hypot(), a, b, out);
+}
+
+struct CheckedSqrt : public std::unary_function<double,double> {
+    double operator()(double a) const {
+        if (a < 0.0) throw std::domain_error("negative argument");
+        return std::sqrt(a);
+    }
+};
+
+PyObject * makeCheckedSqrtUFunc() {
+    std::string name("checked_sqrt");
+    std::string doc("Square root that raises for negative arguments.");
+    return ndarray::PyUnaryUFunctor<CheckedSqrt>::makeUFunc(CheckedSqrt(), name.c_str(), doc.c_str());
+}
+
+PyObject * applyCheckedSqrt(PyObject * a, PyObject * out) {
+    return ndarray::PyUnaryUFunctor<CheckedSqrt>::_call_(CheckedSqrt(), a, out);
+}
+
+PyObject * applyNegate(PyObject * a, PyObject * out) {
+    return ndarray::PyUnaryUFunctor< std::negate<float> >::_call_(std::negate<float>(), a, out);
+}
+
 struct MatrixOwner {
 
     typedef Eigen::Matrix<double,2,2,Eigen::DontAlign> MemberMatrix;
@@ -128,7 +206,12 @@ struct MatrixOwner {
     MemberMatrix const & getMember() const { return member; }
     MemberMatrix & getMember() { return member; }
 
-    explicit MatrixOwner() : member(MemberMatrix::Zero()) {}
+    Eigen::Map< Eigen::Matrix<double,2,2,Eigen::DontAlign> > const & getMap() const { return _map; }
+
+    explicit MatrixOwner() : member(MemberMatrix::Zero()), _map(member.data()) {}
+
+private:
+    Eigen::Map<MemberMatrix> _map;
 
 };
 